@@ -56,6 +56,12 @@ public:
 	std::string name() const override;
 	std::string json_name() const override;
 	void run() override;
+	Resource resource() const override {
+		return Resource::ANALYSIS;
+	}
+	bool read_only() const override {
+		return true;
+	}
 	bool enable_notify() const override {
 		return true;
 	}
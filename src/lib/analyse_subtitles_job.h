@@ -37,6 +37,13 @@ public:
 	std::string name () const override;
 	std::string json_name () const override;
 	void run () override;
+	Resource resource () const override {
+		return Resource::ANALYSIS;
+	}
+
+	bool read_only () const override {
+		return true;
+	}
 
 	boost::filesystem::path path () const {
 		return _path;
@@ -29,6 +29,7 @@
 #include "dcpomatic_log.h"
 #include "film.h"
 #include "filter.h"
+#include "maths_util.h"
 #include "playlist.h"
 #include <dcp/warnings.h>
 extern "C" {
@@ -152,32 +153,50 @@ AudioAnalyser::analyse (shared_ptr<AudioBuffers> b, DCPTime time)
 	int const frames = b->frames ();
 	vector<double> interleaved(frames * _leqm_channels);
 
-	for (int j = 0; j < _leqm_channels; ++j) {
-		float const* data = b->data(j);
-		for (int i = 0; i < frames; ++i) {
-			float s = data[i];
+	for (int i = 0; i < frames; ++i) {
+		for (int j = 0; j < _leqm_channels; ++j) {
+			interleaved[i * _leqm_channels + j] = b->data(j)[i];
+		}
+	}
 
-			interleaved[i * _leqm_channels + j] = s;
+	/* We may struggle to serialise and recover inf or -inf, so prevent such
+	   values by treating anything quieter than this (140dB down) as this.
+	*/
+	float constexpr minimum = 10e-7;
 
-			float as = fabsf (s);
-			if (as < 10e-7) {
-				/* We may struggle to serialise and recover inf or -inf, so prevent such
-				   values by replacing with this (140dB down) */
-				s = as = 10e-7;
-			}
-			_current[j][AudioPoint::RMS] += pow (s, 2);
-			_current[j][AudioPoint::PEAK] = max (_current[j][AudioPoint::PEAK], as);
+	for (int j = 0; j < _leqm_channels; ++j) {
+		float const* data = b->data(j);
 
-			if (as > _sample_peak[j]) {
-				_sample_peak[j] = as;
-				_sample_peak_frame[j] = _done + i;
+		/* Work through the data in blocks which end where a point ends; a point
+		   ends after any frame whose index is a multiple of _samples_per_point.
+		*/
+		int start = 0;
+		while (start < frames) {
+			auto const to_boundary = (_samples_per_point - ((_done + start) % _samples_per_point)) % _samples_per_point;
+			auto const end = static_cast<int>(std::min(static_cast<Frame>(frames - 1), start + to_boundary)) + 1;
+
+			float block_peak = 0;
+			accumulate_power(data + start, end - start, minimum, _current[j][AudioPoint::RMS], block_peak);
+			_current[j][AudioPoint::PEAK] = max(_current[j][AudioPoint::PEAK], block_peak);
+
+			if (block_peak > _sample_peak[j]) {
+				/* Find the first frame with this peak */
+				for (int i = start; i < end; ++i) {
+					if (max(fabsf(data[i]), minimum) == block_peak) {
+						_sample_peak[j] = block_peak;
+						_sample_peak_frame[j] = _done + i;
+						break;
+					}
+				}
 			}
 
-			if (((_done + i) % _samples_per_point) == 0) {
+			if (((_done + end - 1) % _samples_per_point) == 0) {
 				_current[j][AudioPoint::RMS] = sqrt (_current[j][AudioPoint::RMS] / _samples_per_point);
 				_analysis.add_point (j, _current[j]);
 				_current[j] = AudioPoint ();
 			}
+
+			start = end;
 		}
 	}
 
@@ -23,6 +23,7 @@
 #include "dcpomatic_assert.h"
 #include "maths_util.h"
 #include <dcp/scope_guard.h>
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <cmath>
@@ -326,6 +327,73 @@ AudioBuffers::trim_start (int frames_to_trim)
 }
 
 
+/** Write some of our data, interleaved, to a buffer.
+ *  @param out Buffer to write to, which must have space for frames * out_channels samples.
+ *  @param out_channels Number of channels to write for each frame; if this is more than channels()
+ *  the extra channels will be silent, and if it is less our extra channels will be ignored.
+ *  @param frames_to_write Number of frames to write.
+ *  @param read_offset Offset in frames to start reading from.
+ */
+void
+AudioBuffers::interleave_to (float* out, int out_channels, int frames_to_write, int read_offset) const
+{
+	DCPOMATIC_ASSERT (read_offset >= 0 && (read_offset + frames_to_write) <= frames());
+
+	int const c = std::min(channels(), out_channels);
+
+	if (c == 1 && out_channels == 1) {
+		memcpy (out, _data[0].data() + read_offset, frames_to_write * sizeof(float));
+		return;
+	}
+
+	/* Go a channel at a time so that we read each channel sequentially */
+	for (int channel = 0; channel < c; ++channel) {
+		auto p = _data[channel].data() + read_offset;
+		auto q = out + channel;
+		for (int frame = 0; frame < frames_to_write; ++frame) {
+			*q = *p++;
+			q += out_channels;
+		}
+	}
+
+	for (int channel = c; channel < out_channels; ++channel) {
+		auto q = out + channel;
+		for (int frame = 0; frame < frames_to_write; ++frame) {
+			*q = 0;
+			q += out_channels;
+		}
+	}
+}
+
+
+/** Copy interleaved data into these buffers.
+ *  @param in Interleaved data.
+ *  @param in_channels Number of channels in each frame of `in'; only the first channels() of these are used.
+ *  @param frames_to_copy Number of frames to copy.
+ *  @param write_offset Offset in frames to start writing to.
+ */
+void
+AudioBuffers::deinterleave_from (float const* in, int in_channels, int frames_to_copy, int write_offset)
+{
+	DCPOMATIC_ASSERT (in_channels >= channels());
+	DCPOMATIC_ASSERT (write_offset >= 0 && (write_offset + frames_to_copy) <= frames());
+
+	if (in_channels == 1 && channels() == 1) {
+		memcpy (_data[0].data() + write_offset, in, frames_to_copy * sizeof(float));
+		return;
+	}
+
+	for (int channel = 0; channel < channels(); ++channel) {
+		auto p = in + channel;
+		auto q = _data[channel].data() + write_offset;
+		for (int frame = 0; frame < frames_to_copy; ++frame) {
+			*q++ = *p;
+			p += in_channels;
+		}
+	}
+}
+
+
 void
 AudioBuffers::update_data_pointers ()
 {
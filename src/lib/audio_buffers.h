@@ -81,6 +81,9 @@ public:
 	void append (std::shared_ptr<const AudioBuffers> other);
 	void trim_start (int frames);
 
+	void interleave_to (float* out, int out_channels, int frames_to_write, int read_offset) const;
+	void deinterleave_from (float const* in, int in_channels, int frames_to_copy, int write_offset);
+
 private:
 	void allocate (int channels, int frames);
 	void update_data_pointers ();
@@ -23,12 +23,102 @@
 #include "audio_buffers.h"
 #include "maths_util.h"
 #include "util.h"
+extern "C" {
+#include <libavutil/mem.h>
+#include <libavutil/tx.h>
+}
 #include <cmath>
+#include <stdexcept>
 
 
 using std::make_shared;
 using std::min;
 using std::shared_ptr;
+using std::vector;
+
+
+/** Filters with at least this many taps are run using FFT convolution */
+static int const fft_threshold = 64;
+
+
+/** Things we need to run a filter using FFT convolution */
+struct AudioFilter::FFT
+{
+	FFT (vector<float> const& ir, int M)
+	{
+		/* Transform size; this is a trade-off between the cost of each transform (larger is
+		 * worse) and the number of samples we get out of each one (N - M, so larger is better).
+		 */
+		size = 256;
+		while (size < (M + 1) * 4) {
+			size *= 2;
+		}
+
+		float scale = 1;
+		if (av_tx_init(&forward, &forward_fn, AV_TX_FLOAT_FFT, 0, size, &scale, 0) < 0 ||
+		    av_tx_init(&inverse, &inverse_fn, AV_TX_FLOAT_FFT, 1, size, &scale, 0) < 0) {
+			throw std::runtime_error("Could not set up FFT");
+		}
+
+		in = static_cast<AVComplexFloat*>(av_malloc(size * sizeof(AVComplexFloat)));
+		spectrum = static_cast<AVComplexFloat*>(av_malloc(size * sizeof(AVComplexFloat)));
+		out = static_cast<AVComplexFloat*>(av_malloc(size * sizeof(AVComplexFloat)));
+		if (!in || !spectrum || !out) {
+			throw std::bad_alloc();
+		}
+
+		/* Frequency response of the filter, including the 1 / size that the transforms don't apply */
+		for (int i = 0; i < size; ++i) {
+			in[i].re = i < static_cast<int>(ir.size()) ? ir[i] : 0;
+			in[i].im = 0;
+		}
+		forward_fn(forward, spectrum, in, sizeof(AVComplexFloat));
+		response.resize(size);
+		for (int i = 0; i < size; ++i) {
+			response[i].re = spectrum[i].re / size;
+			response[i].im = spectrum[i].im / size;
+		}
+	}
+
+	~FFT ()
+	{
+		av_tx_uninit(&forward);
+		av_tx_uninit(&inverse);
+		av_free(in);
+		av_free(spectrum);
+		av_free(out);
+	}
+
+	FFT (FFT const&) = delete;
+	FFT& operator= (FFT const&) = delete;
+
+	int size = 0;
+	AVTXContext* forward = nullptr;
+	av_tx_fn forward_fn = nullptr;
+	AVTXContext* inverse = nullptr;
+	av_tx_fn inverse_fn = nullptr;
+	vector<AVComplexFloat> response;
+	AVComplexFloat* in = nullptr;
+	AVComplexFloat* spectrum = nullptr;
+	AVComplexFloat* out = nullptr;
+};
+
+
+AudioFilter::AudioFilter (float transition_bandwidth)
+{
+	_M = 4 / transition_bandwidth;
+	if (_M % 2) {
+		++_M;
+	}
+
+	_use_fft = _M >= fft_threshold;
+}
+
+
+AudioFilter::~AudioFilter ()
+{
+
+}
 
 
 std::vector<float>
@@ -84,6 +174,34 @@ AudioFilter::run (shared_ptr<const AudioBuffers> in)
 		_tail->make_silent ();
 	}
 
+	if (_use_fft && !_fft) {
+		try {
+			_fft.reset(new FFT(_ir, _M));
+		} catch (std::exception&) {
+			_fft.reset();
+			_use_fft = false;
+		}
+	}
+
+	if (_use_fft) {
+		run_fft (in.get(), out.get());
+	} else {
+		run_direct (in.get(), out.get());
+	}
+
+	int const amount = min (in->frames(), _tail->frames());
+	if (amount < _tail->frames ()) {
+		_tail->move (_tail->frames() - amount, amount, 0);
+	}
+	_tail->copy_from (in.get(), amount, in->frames() - amount, _tail->frames () - amount);
+
+	return out;
+}
+
+
+void
+AudioFilter::run_direct (AudioBuffers const* in, AudioBuffers* out) const
+{
 	int const channels = in->channels ();
 	int const frames = in->frames ();
 
@@ -104,14 +222,72 @@ AudioFilter::run (shared_ptr<const AudioBuffers> in)
 			out_p[j] = s;
 		}
 	}
+}
 
-	int const amount = min (in->frames(), _tail->frames());
-	if (amount < _tail->frames ()) {
-		_tail->move (_tail->frames() - amount, amount, 0);
-	}
-	_tail->copy_from (in.get(), amount, in->frames() - amount, _tail->frames () - amount);
 
-	return out;
+/** Run the filter using overlap-save FFT convolution.  Since the filter kernel is real we
+ *  can filter two channels with each transform, one in the real part and one in the imaginary.
+ */
+void
+AudioFilter::run_fft (AudioBuffers const* in, AudioBuffers* out)
+{
+	int const size = _fft->size;
+	/* Number of output samples that we get from each transform */
+	int const step = size - _M;
+	int const channels = in->channels ();
+	int const frames = in->frames ();
+	int const tail_frames = _tail->frames ();
+
+	/* Input sample i, where negative values of i are taken from the tail */
+	auto sample = [tail_frames](float const* in_p, float const* tail_p, int i) {
+		return i < 0 ? tail_p[i + tail_frames] : in_p[i];
+	};
+
+	for (int c = 0; c < channels; c += 2) {
+		bool const pair = (c + 1) < channels;
+		auto in_a = in->data (c);
+		auto tail_a = _tail->data (c);
+		auto out_a = out->data (c);
+		auto in_b = pair ? in->data (c + 1) : nullptr;
+		auto tail_b = pair ? _tail->data (c + 1) : nullptr;
+		auto out_b = pair ? out->data (c + 1) : nullptr;
+
+		for (int start = 0; start < frames; start += step) {
+			int const length = min (step, frames - start);
+
+			/* _M samples of history followed by the new samples */
+			for (int i = 0; i < _M + length; ++i) {
+				_fft->in[i].re = sample (in_a, tail_a, start - _M + i);
+				_fft->in[i].im = pair ? sample (in_b, tail_b, start - _M + i) : 0;
+			}
+			for (int i = _M + length; i < size; ++i) {
+				_fft->in[i].re = _fft->in[i].im = 0;
+			}
+
+			_fft->forward_fn (_fft->forward, _fft->spectrum, _fft->in, sizeof(AVComplexFloat));
+
+			auto spectrum = _fft->spectrum;
+			auto response = _fft->response.data();
+			for (int i = 0; i < size; ++i) {
+				auto const re = spectrum[i].re * response[i].re - spectrum[i].im * response[i].im;
+				auto const im = spectrum[i].re * response[i].im + spectrum[i].im * response[i].re;
+				spectrum[i].re = re;
+				spectrum[i].im = im;
+			}
+
+			_fft->inverse_fn (_fft->inverse, _fft->out, _fft->spectrum, sizeof(AVComplexFloat));
+
+			/* The first _M outputs are wrapped around, so ignore them */
+			for (int i = 0; i < length; ++i) {
+				out_a[start + i] = _fft->out[_M + i].re;
+			}
+			if (pair) {
+				for (int i = 0; i < length; ++i) {
+					out_b[start + i] = _fft->out[_M + i].im;
+				}
+			}
+		}
+	}
 }
 
 
@@ -28,37 +28,56 @@
 
 class AudioBuffers;
 struct audio_filter_impulse_input_test;
+struct audio_filter_fft_test;
 
 
 /** An audio filter which can take AudioBuffers and apply some filtering operation,
- *  returning filtered samples
+ *  returning filtered samples.
+ *
+ *  Short filters are run directly; longer ones use FFT convolution (overlap-save)
+ *  which gives the same result, to within rounding error, much more quickly.
  */
 class AudioFilter
 {
 public:
-	explicit AudioFilter (float transition_bandwidth)
-	{
-		_M = 4 / transition_bandwidth;
-		if (_M % 2) {
-			++_M;
-		}
-	}
+	explicit AudioFilter (float transition_bandwidth);
+	virtual ~AudioFilter ();
 
-	virtual ~AudioFilter () {}
+	AudioFilter (AudioFilter const&) = delete;
+	AudioFilter& operator= (AudioFilter const&) = delete;
 
 	std::shared_ptr<AudioBuffers> run (std::shared_ptr<const AudioBuffers> in);
 
 	void flush ();
 
+	/** Say whether to use FFT convolution (if it can be set up) or to run the filter directly,
+	 *  rather than choosing from the length of the filter.  This is for comparing the two.
+	 */
+	void set_use_fft (bool use_fft) {
+		_use_fft = use_fft;
+	}
+
 protected:
 	friend struct audio_filter_impulse_kernel_test;
 	friend struct audio_filter_impulse_input_test;
+	friend struct audio_filter_fft_test;
 
 	std::vector<float> sinc_blackman (float cutoff, bool invert) const;
 
 	std::vector<float> _ir;
 	int _M;
 	std::shared_ptr<AudioBuffers> _tail;
+
+private:
+	struct FFT;
+
+	void run_direct (AudioBuffers const* in, AudioBuffers* out) const;
+	void run_fft (AudioBuffers const* in, AudioBuffers* out);
+
+	/** true to use FFT convolution, false to run the filter directly */
+	bool _use_fft;
+	/** state for FFT convolution, set up on first use */
+	std::unique_ptr<FFT> _fft;
 };
 
 
@@ -22,6 +22,7 @@
 #include "audio_ring_buffers.h"
 #include "dcpomatic_assert.h"
 #include "exceptions.h"
+#include <algorithm>
 #include <iostream>
 
 
@@ -60,7 +61,9 @@ AudioRingBuffers::put(shared_ptr<const AudioBuffers> data, DCPTime time, int fra
 }
 
 
-/** @return time of the returned data; if it's not set this indicates an underrun */
+/** Get some interleaved audio.
+ *  @return time of the returned data; if it's not set this indicates an underrun.
+ */
 optional<DCPTime>
 AudioRingBuffers::get(float* out, int channels, int frames)
 {
@@ -70,11 +73,7 @@ AudioRingBuffers::get(float* out, int channels, int frames)
 
 	while (frames > 0) {
 		if (_buffers.empty()) {
-			for (int i = 0; i < frames; ++i) {
-				for (int j = 0; j < channels; ++j) {
-					*out++ = 0;
-				}
-			}
+			std::fill(out, out + frames * channels, 0.0f);
 			return time;
 		}
 
@@ -84,16 +83,8 @@ AudioRingBuffers::get(float* out, int channels, int frames)
 		}
 
 		int const to_do = min(frames, front.first->frames() - _used_in_head);
-		float* const* p = front.first->data();
-		int const c = min(front.first->channels(), channels);
-		for (int i = 0; i < to_do; ++i) {
-			for (int j = 0; j < c; ++j) {
-				*out++ = p[j][i + _used_in_head];
-			}
-			for (int j = c; j < channels; ++j) {
-				*out++ = 0;
-			}
-		}
+		front.first->interleave_to(out, channels, to_do, _used_in_head);
+		out += to_do * channels;
 		_used_in_head += to_do;
 		frames -= to_do;
 
@@ -107,6 +98,53 @@ AudioRingBuffers::get(float* out, int channels, int frames)
 }
 
 
+/** Get some audio without interleaving it.
+ *  @param out Buffers to write to, which must have at least frames frames; any channels that
+ *  we do not have will be made silent.
+ *  @return time of the returned data; if it's not set this indicates an underrun.
+ */
+optional<DCPTime>
+AudioRingBuffers::get(AudioBuffers* out, int frames)
+{
+	DCPOMATIC_ASSERT(out->frames() >= frames);
+
+	boost::mutex::scoped_lock lm(_mutex);
+
+	optional<DCPTime> time;
+	int offset = 0;
+
+	while (offset < frames) {
+		if (_buffers.empty()) {
+			out->make_silent(offset, frames - offset);
+			return time;
+		}
+
+		auto front = _buffers.front();
+		if (!time) {
+			time = front.second + DCPTime::from_frames(_used_in_head, 48000);
+		}
+
+		int const to_do = min(frames - offset, front.first->frames() - _used_in_head);
+		int const c = min(front.first->channels(), out->channels());
+		for (int channel = 0; channel < c; ++channel) {
+			std::copy(front.first->data(channel) + _used_in_head, front.first->data(channel) + _used_in_head + to_do, out->data(channel) + offset);
+		}
+		for (int channel = c; channel < out->channels(); ++channel) {
+			std::fill(out->data(channel) + offset, out->data(channel) + offset + to_do, 0.0f);
+		}
+		_used_in_head += to_do;
+		offset += to_do;
+
+		if (_used_in_head == front.first->frames()) {
+			_buffers.pop_front();
+			_used_in_head = 0;
+		}
+	}
+
+	return time;
+}
+
+
 optional<DCPTime>
 AudioRingBuffers::peek() const
 {
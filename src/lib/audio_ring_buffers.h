@@ -40,6 +40,7 @@ public:
 
 	void put(std::shared_ptr<const AudioBuffers> data, dcpomatic::DCPTime time, int frame_rate);
 	boost::optional<dcpomatic::DCPTime> get(float* out, int channels, int frames);
+	boost::optional<dcpomatic::DCPTime> get(AudioBuffers* out, int frames);
 	boost::optional<dcpomatic::DCPTime> peek() const;
 
 	void clear();
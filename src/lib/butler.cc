@@ -24,8 +24,10 @@
 #include "cross.h"
 #include "dcpomatic_log.h"
 #include "exceptions.h"
+#include "image_pool.h"
 #include "log.h"
 #include "player.h"
+#include "player_video_cache.h"
 #include "util.h"
 #include "video_content.h"
 
@@ -59,6 +61,8 @@ using namespace boost::placeholders;
  *  butler.  This will be used (where possible) to prepare the PlayerVideos so that calling image() on them is quick.
  *  @param alignment Same as above for the `alignment' value.
  *  @param fast Same as above for the `fast' flag.
+ *  @param cache Cache of images to use when preparing PlayerVideos, or nullptr.  This must only be shared with
+ *  butlers which have the same pixel_format, video_range and fast parameters.
  */
 Butler::Butler(
 	weak_ptr<const Film> film,
@@ -70,7 +74,8 @@ Butler::Butler(
 	Image::Alignment alignment,
 	bool fast,
 	bool prepare_only_proxy,
-	Audio audio
+	Audio audio,
+	shared_ptr<PlayerVideoCache> cache
 	)
 	: _film(film)
 	, _player(player)
@@ -88,6 +93,7 @@ Butler::Butler(
 	, _alignment(alignment)
 	, _fast(fast)
 	, _prepare_only_proxy(prepare_only_proxy)
+	, _cache(cache)
 {
 	_player_video_connection = _player.Video.connect(bind(&Butler::video, this, _1, _2));
 	_player_audio_connection = _player.Audio.connect(bind(&Butler::audio, this, _1, _2, _3));
@@ -130,6 +136,10 @@ Butler::~Butler()
 	try {
 		_thread.join();
 	} catch (...) {}
+
+	/* This includes how well the image pool and our cache (if we have one) did */
+	auto const memory = memory_used();
+	LOG_GENERAL("Butler finished with %1 bytes in use: %2", memory.first, memory.second);
 }
 
 /** Caller must hold a lock on _mutex */
@@ -326,7 +336,7 @@ try
 	/* If the weak_ptr cannot be locked the video obviously no longer requires any work */
 	if (video) {
 		LOG_TIMING("start-prepare in %1", thread_id());
-		video->prepare(_pixel_format, _video_range, _alignment, _fast, _prepare_only_proxy);
+		video->prepare(_pixel_format, _video_range, _alignment, _fast, _prepare_only_proxy, _cache.get());
 		LOG_TIMING("finish-prepare in %1", thread_id());
 	}
 }
@@ -395,11 +405,42 @@ Butler::get_audio(Behaviour behaviour, float* out, Frame frames)
 }
 
 
+/** Get audio without interleaving it.
+ *  @param out Buffers to write to; these should have the number of channels that was given to our constructor.
+ */
+optional<DCPTime>
+Butler::get_audio(Behaviour behaviour, AudioBuffers* out, Frame frames)
+{
+	boost::mutex::scoped_lock lm(_mutex);
+
+	while (behaviour == Behaviour::BLOCKING && !_finished && !_died && _audio.size() < frames) {
+		_arrived.wait(lm);
+	}
+
+	auto t = _audio.get(out, frames);
+	_summon.notify_all();
+	return t;
+}
+
+
 pair<size_t, string>
 Butler::memory_used() const
 {
 	/* XXX: should also look at _audio.memory_used() */
-	return _video.memory_used();
+	auto video = _video.memory_used();
+
+	/* Image memory which isn't in use is held by the pool for the next frames, so count that too */
+	auto const pool = ImagePool::instance()->memory_used();
+	auto const hit_rate = ImagePool::instance()->statistics().hit_rate();
+	auto description = String::compose("%1; %2 bytes pooled, %3%% pool hits", video.second, pool, int(hit_rate * 100));
+
+	size_t cached = 0;
+	if (_cache) {
+		cached = _cache->memory_used();
+		description += String::compose("; %1 bytes cached, %2%% cache hits", cached, int(_cache->statistics().hit_rate() * 100));
+	}
+
+	return make_pair(video.first + pool + cached, description);
 }
 
 
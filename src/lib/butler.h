@@ -39,6 +39,7 @@
 
 class Player;
 class PlayerVideo;
+class PlayerVideoCache;
 
 
 class Butler : public ExceptionStore
@@ -60,7 +61,8 @@ public:
 		Image::Alignment alignment,
 		bool fast,
 		bool prepare_only_proxy,
-		Audio audio
+		Audio audio,
+		std::shared_ptr<PlayerVideoCache> cache = {}
 		);
 
 	~Butler();
@@ -92,6 +94,7 @@ public:
 
 	std::pair<std::shared_ptr<PlayerVideo>, dcpomatic::DCPTime> get_video(Behaviour behaviour, Error* e = nullptr);
 	boost::optional<dcpomatic::DCPTime> get_audio(Behaviour behaviour, float* out, Frame frames);
+	boost::optional<dcpomatic::DCPTime> get_audio(Behaviour behaviour, AudioBuffers* out, Frame frames);
 	boost::optional<TextRingBuffers::Data> get_closed_caption();
 
 	std::pair<size_t, std::string> memory_used() const;
@@ -148,6 +151,9 @@ private:
 	 */
 	bool _prepare_only_proxy = false;
 
+	/** cache of images for PlayerVideo::prepare to use, or nullptr */
+	std::shared_ptr<PlayerVideoCache> _cache;
+
 	/** If we are waiting to be refilled following a seek, this is the time we were
 	    seeking to.
 	*/
@@ -98,6 +98,7 @@ Config::set_defaults()
 	_use_any_servers = true;
 	_servers.clear();
 	_only_servers_encode = false;
+	_compress_frames_for_servers = true;
 	_tms_protocol = FileTransferProtocol::SCP;
 	_tms_passive = true;
 	_tms_ip = "";
@@ -173,6 +174,12 @@ Config::set_defaults()
 	   use about 240Mb with 72 encoding threads.
 	*/
 	_frames_in_memory_multiplier = 3;
+	_slice_threads = 1;
+	_image_pool_size = 512;
+	_maximum_encode_jobs = 1;
+	_maximum_file_jobs = 1;
+	_maximum_network_jobs = 1;
+	_maximum_analysis_jobs = 1;
 	_decode_reduction = optional<int>();
 	_default_notify = false;
 	for (int i = 0; i < NOTIFICATION_COUNT; ++i) {
@@ -349,6 +356,7 @@ try
 	}
 
 	_only_servers_encode = f.optional_bool_child("OnlyServersEncode").get_value_or(false);
+	_compress_frames_for_servers = f.optional_bool_child("CompressFramesForServers").get_value_or(true);
 	_tms_protocol = static_cast<FileTransferProtocol>(f.optional_number_child<int>("TMSProtocol").get_value_or(static_cast<int>(FileTransferProtocol::SCP)));
 	_tms_passive = f.optional_bool_child("TMSPassive").get_value_or(true);
 	_tms_ip = f.string_child("TMSIP");
@@ -585,6 +593,12 @@ try
 		}
 	}
 	_frames_in_memory_multiplier = f.optional_number_child<int>("FramesInMemoryMultiplier").get_value_or(3);
+	_slice_threads = f.optional_number_child<int>("SliceThreads").get_value_or(1);
+	_image_pool_size = max(0, f.optional_number_child<int>("ImagePoolSize").get_value_or(512));
+	_maximum_encode_jobs = max(1, f.optional_number_child<int>("MaximumEncodeJobs").get_value_or(1));
+	_maximum_file_jobs = max(1, f.optional_number_child<int>("MaximumFileJobs").get_value_or(1));
+	_maximum_network_jobs = max(1, f.optional_number_child<int>("MaximumNetworkJobs").get_value_or(1));
+	_maximum_analysis_jobs = max(1, f.optional_number_child<int>("MaximumAnalysisJobs").get_value_or(1));
 	_decode_reduction = f.optional_number_child<int>("DecodeReduction");
 	_default_notify = f.optional_bool_child("DefaultNotify").get_value_or(false);
 
@@ -776,6 +790,10 @@ Config::write_config() const
 	   is done by the encoding servers.  0 to set the master to do some encoding as well as coordinating the job.
 	*/
 	cxml::add_text_child(root, "OnlyServersEncode", _only_servers_encode ? "1" : "0");
+	/* [XML] CompressFramesForServers 1 to compress uncompressed video frames before sending them to encoding servers,
+	   which uses some CPU time on the master but reduces the load on the network; 0 to send them as they are.
+	*/
+	cxml::add_text_child(root, "CompressFramesForServers", _compress_frames_for_servers ? "1" : "0");
 	/* [XML] TMSProtocol Protocol to use to copy files to a TMS; 0 to use SCP, 1 for FTP. */
 	cxml::add_text_child(root, "TMSProtocol", fmt::to_string(static_cast<int>(_tms_protocol)));
 	/* [XML] TMSPassive True to use PASV mode with TMS FTP connections. */
@@ -1015,6 +1033,22 @@ Config::write_config() const
 	   frames to be held in memory at once.
 	*/
 	cxml::add_text_child(root, "FramesInMemoryMultiplier", fmt::to_string(_frames_in_memory_multiplier));
+	/* [XML] SliceThreads number of threads to split the scaling and colour conversion of each frame across;
+	   1 to do each frame in a single thread.
+	*/
+	cxml::add_text_child(root, "SliceThreads", fmt::to_string(_slice_threads));
+	/* [XML] ImagePoolSize maximum size in megabytes of the memory to keep, once images have finished with it,
+	   for re-use by new images.
+	*/
+	cxml::add_text_child(root, "ImagePoolSize", fmt::to_string(_image_pool_size));
+	/* [XML] MaximumEncodeJobs maximum number of jobs which mostly encode (such as making DCPs) to run at once. */
+	cxml::add_text_child(root, "MaximumEncodeJobs", fmt::to_string(_maximum_encode_jobs));
+	/* [XML] MaximumFileJobs maximum number of jobs which mostly read or write files (such as examining content) to run at once. */
+	cxml::add_text_child(root, "MaximumFileJobs", fmt::to_string(_maximum_file_jobs));
+	/* [XML] MaximumNetworkJobs maximum number of jobs which mostly use the network (such as uploads) to run at once. */
+	cxml::add_text_child(root, "MaximumNetworkJobs", fmt::to_string(_maximum_network_jobs));
+	/* [XML] MaximumAnalysisJobs maximum number of jobs which analyse content (such as audio analysis) to run at once. */
+	cxml::add_text_child(root, "MaximumAnalysisJobs", fmt::to_string(_maximum_analysis_jobs));
 
 	/* [XML] DecodeReduction power of 2 to reduce DCP images by before decoding in the player. */
 	if (_decode_reduction) {
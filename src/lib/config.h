@@ -154,6 +154,10 @@ public:
 		return _only_servers_encode;
 	}
 
+	bool compress_frames_for_servers() const {
+		return _compress_frames_for_servers;
+	}
+
 	FileTransferProtocol tms_protocol() const {
 		return _tms_protocol;
 	}
@@ -496,6 +500,35 @@ public:
 		return _frames_in_memory_multiplier;
 	}
 
+	int slice_threads() const {
+		return _slice_threads;
+	}
+
+	/** @return maximum size in megabytes of the memory to keep for re-use by images */
+	int image_pool_size() const {
+		return _image_pool_size;
+	}
+
+	/** @return maximum number of jobs which mostly encode that may run at once */
+	int maximum_encode_jobs() const {
+		return _maximum_encode_jobs;
+	}
+
+	/** @return maximum number of jobs which mostly read or write files that may run at once */
+	int maximum_file_jobs() const {
+		return _maximum_file_jobs;
+	}
+
+	/** @return maximum number of jobs which mostly use the network that may run at once */
+	int maximum_network_jobs() const {
+		return _maximum_network_jobs;
+	}
+
+	/** @return maximum number of jobs which analyse content that may run at once */
+	int maximum_analysis_jobs() const {
+		return _maximum_analysis_jobs;
+	}
+
 	boost::optional<int> decode_reduction() const {
 		return _decode_reduction;
 	}
@@ -718,6 +751,10 @@ public:
 		maybe_set(_only_servers_encode, o);
 	}
 
+	void set_compress_frames_for_servers(bool c) {
+		maybe_set(_compress_frames_for_servers, c);
+	}
+
 	void set_tms_protocol(FileTransferProtocol p) {
 		maybe_set(_tms_protocol, p);
 	}
@@ -1010,6 +1047,30 @@ public:
 		maybe_set(_frames_in_memory_multiplier, m);
 	}
 
+	void set_slice_threads(int t) {
+		maybe_set(_slice_threads, t);
+	}
+
+	void set_image_pool_size(int s) {
+		maybe_set(_image_pool_size, s);
+	}
+
+	void set_maximum_encode_jobs(int j) {
+		maybe_set(_maximum_encode_jobs, j);
+	}
+
+	void set_maximum_file_jobs(int j) {
+		maybe_set(_maximum_file_jobs, j);
+	}
+
+	void set_maximum_network_jobs(int j) {
+		maybe_set(_maximum_network_jobs, j);
+	}
+
+	void set_maximum_analysis_jobs(int j) {
+		maybe_set(_maximum_analysis_jobs, j);
+	}
+
 	void set_decode_reduction(boost::optional<int> r) {
 		maybe_set(_decode_reduction, r);
 	}
@@ -1350,6 +1411,8 @@ private:
 	/** J2K encoding servers that should definitely be used */
 	std::vector<std::string> _servers;
 	bool _only_servers_encode;
+	/** true to compress uncompressed frames before sending them to encoding servers */
+	bool _compress_frames_for_servers;
 	FileTransferProtocol _tms_protocol;
 	bool _tms_passive;
 	/** The IP address of a TMS that we can copy DCPs to */
@@ -1449,6 +1512,14 @@ private:
 	boost::optional<KDMWriteType> _last_kdm_write_type;
 	boost::optional<DKDMWriteType> _last_dkdm_write_type;
 	int _frames_in_memory_multiplier;
+	/** number of threads to split the scaling and colour conversion of a single frame across */
+	int _slice_threads;
+	/** maximum size in megabytes of the image memory that ImagePool keeps for re-use */
+	int _image_pool_size;
+	int _maximum_encode_jobs;
+	int _maximum_file_jobs;
+	int _maximum_network_jobs;
+	int _maximum_analysis_jobs;
 	boost::optional<int> _decode_reduction;
 	bool _default_notify;
 	bool _notification[NOTIFICATION_COUNT];
@@ -29,6 +29,7 @@
 #include "compose.hpp"
 #include "content.h"
 #include "content_factory.h"
+#include "digest_index.h"
 #include "exceptions.h"
 #include "film.h"
 #include "font.h"
@@ -161,9 +162,10 @@ Content::calculate_digest() const
 {
 	/* Some content files are very big, so we use a poor man's
 	   digest here: a digest of the first and last 1e6 bytes with the
-	   size of the first file tacked on the end as a string.
+	   size of the first file tacked on the end as a string.  DigestIndex
+	   saves us from calculating it again if the files have not changed.
 	*/
-	return simple_digest(paths());
+	return DigestIndex::instance()->digest(paths());
 }
 
 
@@ -176,6 +178,12 @@ Content::examine(shared_ptr<const Film>, shared_ptr<Job> job, bool)
 
 	auto const d = calculate_digest();
 
+	try {
+		DigestIndex::instance()->write();
+	} catch (FileError&) {
+		/* Never mind; we'll just have to calculate the digest again next time */
+	}
+
 	boost::mutex::scoped_lock lm(_mutex);
 	_digest = d;
 
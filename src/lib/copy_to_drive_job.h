@@ -30,6 +30,9 @@ public:
 	std::string name () const override;
 	std::string json_name () const override;
 	void run () override;
+	Resource resource () const override {
+		return Resource::IO;
+	}
 	bool enable_notify () const override {
 		return true;
 	}
@@ -61,6 +61,7 @@ extern void start_batch_converter();
 extern void start_player();
 extern uint64_t thread_id();
 extern int avio_open_boost(AVIOContext** s, boost::filesystem::path file, int flags);
+extern boost::optional<int64_t> last_write_time_nanoseconds(boost::filesystem::path path);
 extern boost::filesystem::path home_directory();
 extern bool running_32_on_64();
 extern void unprivileged();
@@ -27,6 +27,7 @@ extern "C" {
 }
 LIBDCP_ENABLE_WARNINGS
 #include <fmt/format.h>
+#include <sys/stat.h>
 
 
 using std::string;
@@ -61,6 +62,23 @@ avio_open_boost(AVIOContext** s, boost::filesystem::path file, int flags)
 }
 
 
+/** @return Modification time of a file in nanoseconds since the Unix epoch, or none if it could not be found */
+boost::optional<int64_t>
+last_write_time_nanoseconds(boost::filesystem::path path)
+{
+	struct stat s;
+	if (stat(path.c_str(), &s) != 0) {
+		return {};
+	}
+
+#ifdef DCPOMATIC_OSX
+	return static_cast<int64_t>(s.st_mtimespec.tv_sec) * 1000000000 + s.st_mtimespec.tv_nsec;
+#else
+	return static_cast<int64_t>(s.st_mtim.tv_sec) * 1000000000 + s.st_mtim.tv_nsec;
+#endif
+}
+
+
 boost::filesystem::path
 home_directory()
 {
@@ -330,6 +330,22 @@ avio_open_boost(AVIOContext** s, boost::filesystem::path file, int flags)
 }
 
 
+/** @return Modification time of a file in nanoseconds since the Unix epoch, or none if it could not be found */
+optional<int64_t>
+last_write_time_nanoseconds(boost::filesystem::path path)
+{
+	WIN32_FILE_ATTRIBUTE_DATA data;
+	if (!GetFileAttributesExW(dcp::filesystem::fix_long_path(path).c_str(), GetFileExInfoStandard, &data)) {
+		return {};
+	}
+
+	/* FILETIME counts 100ns intervals since 1st January 1601 */
+	auto const time = (static_cast<int64_t>(data.ftLastWriteTime.dwHighDateTime) << 32) | data.ftLastWriteTime.dwLowDateTime;
+	int64_t const from_1601_to_1970 = 116444736000000000LL;
+	return (time - from_1601_to_1970) * 100;
+}
+
+
 void
 maybe_open_console()
 {
@@ -32,6 +32,7 @@
 #include "frame_interval_checker.h"
 #include "image.h"
 #include "j2k_image_proxy.h"
+#include "pcm_unpack.h"
 #include "raw_image_proxy.h"
 #include "text_decoder.h"
 #include "util.h"
@@ -72,6 +73,10 @@ using boost::optional;
 using namespace dcpomatic;
 
 
+/** Number of frames of each asset to read ahead of the one that we are decoding */
+static int const read_ahead_frames = 8;
+
+
 DCPDecoder::DCPDecoder (shared_ptr<const Film> film, shared_ptr<const DCPContent> content, bool fast, bool tolerant, shared_ptr<DCPDecoder> old)
 	: Decoder (film)
 	, _dcp_content (content)
@@ -174,22 +179,23 @@ DCPDecoder::pass ()
 
 	if ((_j2k_mono_reader || _j2k_stereo_reader || _mpeg2_mono_reader) && (_decode_referenced || !_dcp_content->reference_video())) {
 		auto const entry_point = (*_reel)->main_picture()->entry_point().get_value_or(0);
-		if (_j2k_mono_reader) {
+		if (_j2k_mono_frames) {
 			video->emit (
 				film(),
 				std::make_shared<J2KImageProxy>(
-					_j2k_mono_reader->get_frame(entry_point + frame),
+					_j2k_mono_frames->get(entry_point + frame),
 					picture_asset->size(),
 					AV_PIX_FMT_XYZ12LE,
 					_forced_reduction
 					),
 				ContentTime::from_frames(_offset + frame, vfr)
 				);
-		} else if (_j2k_stereo_reader) {
+		} else if (_j2k_stereo_frames) {
+			auto stereo_frame = _j2k_stereo_frames->get(entry_point + frame);
 			video->emit (
 				film(),
 				std::make_shared<J2KImageProxy>(
-					_j2k_stereo_reader->get_frame (entry_point + frame),
+					stereo_frame,
 					picture_asset->size(),
 					dcp::Eye::LEFT,
 					AV_PIX_FMT_XYZ12LE,
@@ -201,7 +207,7 @@ DCPDecoder::pass ()
 			video->emit (
 				film(),
 				std::make_shared<J2KImageProxy>(
-					_j2k_stereo_reader->get_frame (entry_point + frame),
+					stereo_frame,
 					picture_asset->size(),
 					dcp::Eye::RIGHT,
 					AV_PIX_FMT_XYZ12LE,
@@ -209,10 +215,10 @@ DCPDecoder::pass ()
 					),
 				ContentTime::from_frames(_offset + frame, vfr)
 				);
-		} else if (_mpeg2_mono_reader) {
+		} else if (_mpeg2_mono_frames) {
 			/* XXX: got to flush this at some point */
 			try {
-				for (auto const& image: _mpeg2_decompressor->decompress_frame(_mpeg2_mono_reader->get_frame(entry_point + frame))) {
+				for (auto const& image: _mpeg2_decompressor->decompress_frame(_mpeg2_mono_frames->get(entry_point + frame))) {
 					video->emit(
 						film(),
 						/* XXX: should this be PADDED? */
@@ -229,46 +235,35 @@ DCPDecoder::pass ()
 		}
 	}
 
-	if (_sound_reader && (_decode_referenced || !_dcp_content->reference_audio())) {
+	if (_sound_frames && (_decode_referenced || !_dcp_content->reference_audio())) {
 		auto const entry_point = (*_reel)->main_sound()->entry_point().get_value_or(0);
-		auto sf = _sound_reader->get_frame (entry_point + frame);
+		auto sf = _sound_frames->get(entry_point + frame);
 		auto from = sf->data ();
 
 		int const channels = _dcp_content->audio->stream()->channels();
 		int const frames = sf->size() / (sf->bits() * channels / 8);
 		auto data = make_shared<AudioBuffers>(channels, frames);
-		auto data_data = data->data();
 
+		/* Convert all the samples, still interleaved, then split them into channels */
+		_sound_samples.resize(frames * channels);
 		switch (sf->bits()) {
 		case 24:
-		{
-			for (int i = 0; i < frames; ++i) {
-				for (int j = 0; j < channels; ++j) {
-					data_data[j][i] = static_cast<int>((from[0] << 8) | (from[1] << 16) | (from[2] << 24)) / static_cast<float> (INT_MAX - 256);
-					from += 3;
-				}
-			}
+			unpack_pcm_24(from, frames * channels, _sound_samples.data());
+			data->deinterleave_from(_sound_samples.data(), channels, frames, 0);
 			break;
-		}
 		case 16:
-		{
-			for (int i = 0; i < frames; ++i) {
-				for (int j = 0; j < channels; ++j) {
-					data_data[j][i] = static_cast<int>(from[0] << 16 | (from[1] << 24)) / static_cast<float> (INT_MAX - 256);
-					from += 2;
-				}
-			}
+			unpack_pcm_16(from, frames * channels, _sound_samples.data());
+			data->deinterleave_from(_sound_samples.data(), channels, frames, 0);
 			break;
 		}
-		}
 
 		audio->emit (film(), _dcp_content->audio->stream(), data, ContentTime::from_frames (_offset, vfr) + _next);
 	}
 
-	if (_atmos_reader) {
+	if (_atmos_frames) {
 		DCPOMATIC_ASSERT (_atmos_metadata);
 		auto const entry_point = (*_reel)->atmos()->entry_point().get_value_or(0);
-		atmos->emit (film(), _atmos_reader->get_frame(entry_point + frame), _offset + frame, *_atmos_metadata);
+		atmos->emit (film(), _atmos_frames->get(entry_point + frame), _offset + frame, *_atmos_metadata);
 	}
 
 	_next += ContentTime::from_frames (1, vfr);
@@ -404,6 +399,13 @@ DCPDecoder::next_reel ()
 void
 DCPDecoder::get_readers ()
 {
+	/* Stop reading ahead before we close the readers that are being read from */
+	_j2k_mono_frames.reset();
+	_j2k_stereo_frames.reset();
+	_mpeg2_mono_frames.reset();
+	_sound_frames.reset();
+	_atmos_frames.reset();
+
 	_j2k_mono_reader.reset();
 	_j2k_stereo_reader.reset();
 	_mpeg2_mono_reader.reset();
@@ -446,6 +448,51 @@ DCPDecoder::get_readers ()
 		_atmos_reader->set_check_hmac (false);
 		_atmos_metadata = AtmosMetadata (asset);
 	}
+
+	start_read_ahead ();
+}
+
+
+/** Set up background reading of frames from the current readers; nothing is actually read
+ *  until the first frame is asked for.
+ */
+void
+DCPDecoder::start_read_ahead ()
+{
+	auto end = [](shared_ptr<dcp::ReelFileAsset> asset) {
+		return asset->entry_point().get_value_or(0) + asset->duration();
+	};
+
+	if (_j2k_mono_reader) {
+		auto reader = _j2k_mono_reader;
+		_j2k_mono_frames.reset(
+			new ReadAhead<dcp::MonoJ2KPictureAssetReader>([reader](int64_t frame) { return reader->get_frame(frame); }, end((*_reel)->main_picture()), read_ahead_frames)
+			);
+	} else if (_j2k_stereo_reader) {
+		auto reader = _j2k_stereo_reader;
+		_j2k_stereo_frames.reset(
+			new ReadAhead<dcp::StereoJ2KPictureAssetReader>([reader](int64_t frame) { return reader->get_frame(frame); }, end((*_reel)->main_picture()), read_ahead_frames)
+			);
+	} else if (_mpeg2_mono_reader) {
+		auto reader = _mpeg2_mono_reader;
+		_mpeg2_mono_frames.reset(
+			new ReadAhead<dcp::MonoMPEG2PictureAssetReader>([reader](int64_t frame) { return reader->get_frame(frame); }, end((*_reel)->main_picture()), read_ahead_frames)
+			);
+	}
+
+	if (_sound_reader) {
+		auto reader = _sound_reader;
+		_sound_frames.reset(
+			new ReadAhead<dcp::SoundAssetReader>([reader](int64_t frame) { return reader->get_frame(frame); }, end((*_reel)->main_sound()), read_ahead_frames)
+			);
+	}
+
+	if (_atmos_reader) {
+		auto reader = _atmos_reader;
+		_atmos_frames.reset(
+			new ReadAhead<dcp::AtmosAssetReader>([reader](int64_t frame) { return reader->get_frame(frame); }, end((*_reel)->atmos()), read_ahead_frames)
+			);
+	}
 }
 
 
@@ -27,6 +27,8 @@
 #include "atmos_metadata.h"
 #include "decoder.h"
 #include "font_id_allocator.h"
+#include "frame_read_ahead.h"
+#include <dcp/atmos_asset_reader.h>
 #include <dcp/mono_j2k_picture_asset_reader.h>
 #include <dcp/stereo_j2k_picture_asset_reader.h>
 #include <dcp/mono_mpeg2_picture_asset_reader.h>
@@ -76,6 +78,7 @@ private:
 
 	void next_reel ();
 	void get_readers ();
+	void start_read_ahead ();
 	void pass_texts (dcpomatic::ContentTime next, dcp::Size size);
 	void pass_texts (
 		dcpomatic::ContentTime next,
@@ -107,7 +110,21 @@ private:
 	std::shared_ptr<dcp::AtmosAssetReader> _atmos_reader;
 	boost::optional<AtmosMetadata> _atmos_metadata;
 
+	template <class Reader>
+	using ReadAhead = FrameReadAhead<decltype(std::declval<Reader>().get_frame(0))>;
+
+	/* Frames from each of the readers above, read in the background.  Once these
+	 * are set up the readers must not be used directly.
+	 */
+	std::unique_ptr<ReadAhead<dcp::MonoJ2KPictureAssetReader>> _j2k_mono_frames;
+	std::unique_ptr<ReadAhead<dcp::StereoJ2KPictureAssetReader>> _j2k_stereo_frames;
+	std::unique_ptr<ReadAhead<dcp::MonoMPEG2PictureAssetReader>> _mpeg2_mono_frames;
+	std::unique_ptr<ReadAhead<dcp::SoundAssetReader>> _sound_frames;
+	std::unique_ptr<ReadAhead<dcp::AtmosAssetReader>> _atmos_frames;
+
 	std::shared_ptr<dcp::MPEG2Decompressor> _mpeg2_decompressor;
+	/** interleaved sound samples converted to float, kept to avoid re-allocating it for every frame */
+	std::vector<float> _sound_samples;
 
 	bool _decode_referenced = false;
 	boost::optional<int> _forced_reduction;
@@ -42,6 +42,7 @@
 #include "log.h"
 #include "player_video.h"
 #include "rng.h"
+#include "slice_threads.h"
 #include <libcxml/cxml.h>
 #include <dcp/openjpeg_image.h>
 #include <dcp/rgb_xyz.h>
@@ -54,6 +55,7 @@ LIBDCP_ENABLE_WARNINGS
 #include <boost/asio.hpp>
 #include <boost/thread.hpp>
 #include <stdint.h>
+#include <cstring>
 #include <iomanip>
 #include <iostream>
 
@@ -102,7 +104,23 @@ DCPVideo::convert_to_xyz(shared_ptr<const PlayerVideo> frame)
 	shared_ptr<dcp::OpenJPEGImage> xyz;
 
 	auto image = frame->image(bind(&PlayerVideo::keep_xyz_or_rgb, _1), VideoRange::FULL, false);
-	if (frame->colour_conversion()) {
+	if (frame->colour_conversion() && SliceThreads::instance()->threads() > 1) {
+		/* Convert bands of the image in parallel, then copy them into place */
+		auto const conversion = frame->colour_conversion().get();
+		auto const size = image->size();
+		xyz = make_shared<dcp::OpenJPEGImage>(size);
+		SliceThreads::instance()->run(size.height, 1, [image, xyz, conversion, size](int start, int end) {
+			auto band = dcp::rgb_to_xyz(
+				image->data()[0] + start * image->stride()[0],
+				dcp::Size(size.width, end - start),
+				image->stride()[0],
+				conversion
+				);
+			for (int c = 0; c < 3; ++c) {
+				memcpy(xyz->data(c) + start * size.width, band->data(c), size.width * (end - start) * sizeof(int));
+			}
+		});
+	} else if (frame->colour_conversion()) {
 		xyz = dcp::rgb_to_xyz(
 			image->data()[0],
 			image->size(),
@@ -129,13 +147,17 @@ DCPVideo::convert_to_xyz(uint16_t* dst) const
 {
 	auto image = _frame->image(bind(&PlayerVideo::keep_xyz_or_rgb, _1), VideoRange::FULL, false);
 	if (_frame->colour_conversion()) {
-		dcp::rgb_to_xyz(
-			image->data()[0],
-			dst,
-			image->size(),
-			image->stride()[0],
-			_frame->colour_conversion().get()
-			);
+		auto const conversion = _frame->colour_conversion().get();
+		auto const size = image->size();
+		SliceThreads::instance()->run(size.height, 1, [image, dst, conversion, size](int start, int end) {
+			dcp::rgb_to_xyz(
+				image->data()[0] + start * image->stride()[0],
+				dst + start * size.width * 3,
+				dcp::Size(size.width, end - start),
+				image->stride()[0],
+				conversion
+				);
+		});
 	}
 }
 
@@ -230,32 +252,82 @@ DCPVideo::encode_remotely(EncodeServerDescription serv, int timeout) const
 
 	socket->connect(serv.host_name(), ENCODE_FRAME_PORT);
 
+	send_to_server(socket);
+	auto encoded = receive_from_server(socket);
+	if (encoded.index != _index || encoded.eyes != eyes()) {
+		throw NetworkError(String::compose("Server returned frame %1 when %2 was expected", encoded.index, _index));
+	}
+
+	if (encoded.data.size() == 0) {
+		throw EncodeError(String::compose("Server could not encode frame %1", _index));
+	}
+
+	return encoded.data;
+}
+
+
+/** Send this frame to a remote server for encoding.  The server will start work
+ *  on it but will not send the result until it is asked for by receive_from_server().
+ *  Several frames may be sent down the same socket before asking for any results.
+ *  @param socket Socket connected to the server.
+ */
+void
+DCPVideo::send_to_server(shared_ptr<Socket> socket) const
+{
 	/* Collect all XML metadata */
 	xmlpp::Document doc;
 	auto root = doc.create_root_node("EncodingRequest");
 	cxml::add_text_child(root, "Version", fmt::to_string(SERVER_LINK_VERSION));
+	auto const compress = Config::instance()->compress_frames_for_servers() && _frame->has_raw_image();
+	if (compress) {
+		cxml::add_text_child(root, "Compression", "deflate");
+	}
 	add_metadata(root);
 
 	LOG_DEBUG_ENCODE(N_("Sending frame %1 to remote"), _index);
 
-	{
-		Socket::WriteDigestScope ds(socket);
+	/* Send the length of the XML metadata; a zero length here would be
+	 * a request for a result (see receive_from_server()).
+	 */
+	auto xml = doc.write_to_string("UTF-8");
+	socket->write(xml.bytes() + 1);
 
-		/* Send XML metadata */
-		auto xml = doc.write_to_string("UTF-8");
-		socket->write(xml.bytes() + 1);
-		socket->write((uint8_t *) xml.c_str(), xml.bytes() + 1);
+	Socket::WriteDigestScope ds(socket);
 
-		/* Send binary data */
-		LOG_TIMING("start-remote-send thread=%1", thread_id());
+	/* Send XML metadata */
+	socket->write((uint8_t *) xml.c_str(), xml.bytes() + 1);
+
+	/* Send binary data */
+	LOG_TIMING("start-remote-send thread=%1", thread_id());
+	if (compress) {
+		Socket::WriteCompressionScope cs(socket);
+		_frame->write_to_socket(socket);
+	} else {
 		_frame->write_to_socket(socket);
 	}
+}
+
+
+/** Ask a remote server for the next frame that it has finished encoding,
+ *  blocking until it is ready.  Frames are returned in the order that the
+ *  server finishes them, which is not necessarily the order in which they
+ *  were sent.  If the server could not encode the frame the data returned
+ *  will be empty; the socket can still be used.
+ *  @param socket Socket connected to the server, down which at least one
+ *  frame has been sent with send_to_server() and not yet received.
+ */
+DCPVideo::RemoteEncoded
+DCPVideo::receive_from_server(shared_ptr<Socket> socket)
+{
+	socket->write(uint32_t(0));
 
 	/* Read the response (JPEG2000-encoded data); this blocks until the data
 	   is ready and sent back.
 	*/
 	Socket::ReadDigestScope ds(socket);
 	LOG_TIMING("start-remote-encode thread=%1", thread_id());
+	auto const index = static_cast<int>(socket->read_uint32());
+	auto const eyes = static_cast<Eyes>(socket->read_uint32());
 	ArrayData e(socket->read_uint32());
 	LOG_TIMING("start-remote-receive thread=%1", thread_id());
 	socket->read(e.data(), e.size());
@@ -264,11 +336,12 @@ DCPVideo::encode_remotely(EncodeServerDescription serv, int timeout) const
 		throw NetworkError("Checksums do not match");
 	}
 
-	LOG_DEBUG_ENCODE(N_("Finished remotely-encoded frame %1"), _index);
+	LOG_DEBUG_ENCODE(N_("Finished remotely-encoded frame %1"), index);
 
-	return e;
+	return { index, eyes, e };
 }
 
+
 void
 DCPVideo::add_metadata(xmlpp::Element* el) const
 {
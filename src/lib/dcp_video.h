@@ -35,6 +35,7 @@
 
 class Log;
 class PlayerVideo;
+class Socket;
 
 
 /** @class DCPVideo
@@ -58,6 +59,18 @@ public:
 	dcp::ArrayData encode_locally() const;
 	dcp::ArrayData encode_remotely(EncodeServerDescription, int timeout = 30) const;
 
+	/** A frame which has been encoded by a remote server */
+	struct RemoteEncoded
+	{
+		int index;
+		Eyes eyes;
+		/** encoded data, or empty if the server could not encode the frame */
+		dcp::ArrayData data;
+	};
+
+	void send_to_server(std::shared_ptr<Socket> socket) const;
+	static RemoteEncoded receive_from_server(std::shared_ptr<Socket> socket);
+
 	int index() const {
 		return _index;
 	}
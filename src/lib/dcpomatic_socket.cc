@@ -146,6 +146,21 @@ Socket::connect(boost::asio::ip::address address, int port)
  */
 void
 Socket::write (uint8_t const * data, int size)
+{
+	if (_deflater) {
+		_deflater->add(data, size);
+	} else {
+		write_to_network(data, size);
+	}
+
+	if (_write_digester) {
+		_write_digester->add (data, static_cast<size_t>(size));
+	}
+}
+
+
+void
+Socket::write_to_network (uint8_t const * data, int size)
 {
 	set_deadline_from_now(_timeout);
 	boost::system::error_code ec = boost::asio::error::would_block;
@@ -159,10 +174,6 @@ Socket::write (uint8_t const * data, int size)
 	if (ec) {
 		throw NetworkError(String::compose(_("error during async_write (%1)"), error_details(ec)));
 	}
-
-	if (_write_digester) {
-		_write_digester->add (data, static_cast<size_t>(size));
-	}
 }
 
 
@@ -187,6 +198,23 @@ Socket::write (uint32_t v)
  */
 void
 Socket::read (uint8_t* data, int size)
+{
+	if (_inflater) {
+		_inflater->get(data, size);
+	} else {
+		read_from_network(data, size);
+	}
+
+	_bytes_read += size;
+
+	if (_read_digester) {
+		_read_digester->add (data, static_cast<size_t>(size));
+	}
+}
+
+
+void
+Socket::read_from_network (uint8_t* data, int size)
 {
 	set_deadline_from_now(_timeout);
 	boost::system::error_code ec = boost::asio::error::would_block;
@@ -201,9 +229,7 @@ Socket::read (uint8_t* data, int size)
 		throw NetworkError(String::compose(_("error during async_read (%1)"), error_details(ec)));
 	}
 
-	if (_read_digester) {
-		_read_digester->add (data, static_cast<size_t>(size));
-	}
+	_network_bytes_read += size;
 }
 
 
@@ -312,6 +338,125 @@ Socket::finish_write_digest ()
 }
 
 
+/** Write some compressed data to the network, preceded by its length.  A zero
+ *  length marks the end of the compressed data.
+ */
+void
+Socket::write_chunk (uint8_t const* data, int size)
+{
+	uint32_t length = htonl(size);
+	write_to_network(reinterpret_cast<uint8_t*>(&length), 4);
+	if (size > 0) {
+		write_to_network(data, size);
+	}
+}
+
+
+/** @return the next chunk of compressed data from the network, or an empty
+ *  vector if there is no more.
+ */
+std::vector<uint8_t>
+Socket::read_chunk ()
+{
+	uint32_t length;
+	read_from_network(reinterpret_cast<uint8_t*>(&length), 4);
+	length = ntohl(length);
+	/* Deflater never makes chunks bigger than this */
+	if (length > 1024 * 1024) {
+		throw NetworkError("Malformed compressed data (chunk too large)");
+	}
+
+	std::vector<uint8_t> chunk(length);
+	if (length > 0) {
+		read_from_network(chunk.data(), length);
+	}
+	return chunk;
+}
+
+
+void
+Socket::start_write_compression ()
+{
+	DCPOMATIC_ASSERT (!_deflater);
+	_deflater.reset (new Deflater([this](uint8_t const* data, int size) { write_chunk(data, size); }));
+}
+
+
+void
+Socket::finish_write_compression ()
+{
+	DCPOMATIC_ASSERT (_deflater);
+	/* Take _deflater away before we finish with it so that if anything goes wrong
+	 * we won't try to use it again.
+	 */
+	boost::scoped_ptr<Deflater> deflater;
+	deflater.swap (_deflater);
+	deflater->finish ();
+	write_chunk (nullptr, 0);
+}
+
+
+void
+Socket::start_read_compression ()
+{
+	DCPOMATIC_ASSERT (!_inflater);
+	_inflater.reset (new Inflater([this]() { return read_chunk(); }));
+}
+
+
+void
+Socket::finish_read_compression ()
+{
+	DCPOMATIC_ASSERT (_inflater);
+	_inflater.reset ();
+
+	/* Skip anything that is left, up to and including the end marker */
+	while (!read_chunk().empty()) {}
+}
+
+
+Socket::WriteCompressionScope::WriteCompressionScope (shared_ptr<Socket> socket)
+	: _socket (socket)
+{
+	socket->start_write_compression ();
+}
+
+
+Socket::WriteCompressionScope::~WriteCompressionScope ()
+{
+	auto sp = _socket.lock ();
+	if (sp) {
+		try {
+			sp->finish_write_compression ();
+		} catch (...) {
+			/* As with WriteDigestScope, if this fails something bad has happened
+			 * and the reader will find out.
+			 */
+		}
+	}
+}
+
+
+Socket::ReadCompressionScope::ReadCompressionScope (shared_ptr<Socket> socket)
+	: _socket (socket)
+{
+	socket->start_read_compression ();
+}
+
+
+Socket::ReadCompressionScope::~ReadCompressionScope ()
+{
+	auto sp = _socket.lock ();
+	if (sp) {
+		try {
+			sp->finish_read_compression ();
+		} catch (...) {
+			/* Any problem here will cause the next read to fail */
+		}
+	}
+}
+
+
 void
 Socket::set_send_buffer_size (int size)
 {
@@ -19,6 +19,7 @@
 */
 
 
+#include "deflater.h"
 #include "digester.h"
 #include "io_context.h"
 #include <boost/asio.hpp>
@@ -65,6 +66,18 @@ public:
 		return _socket.is_open();
 	}
 
+	/** @return number of bytes that have been returned by read() calls */
+	uint64_t bytes_read() const {
+		return _bytes_read;
+	}
+
+	/** @return number of bytes that have been read from the network, which will be
+	 *  less than bytes_read() if some data has been decompressed.
+	 */
+	uint64_t network_bytes_read() const {
+		return _network_bytes_read;
+	}
+
 	class ReadDigestScope
 	{
 	public:
@@ -87,6 +100,31 @@ public:
 		std::weak_ptr<Socket> _socket;
 	};
 
+	/** After one of these is created everything that is sent from the socket will be
+	 *  compressed.  The compressed data is sent in chunks as it becomes available,
+	 *  and when the CompressionScope is destroyed the last of it is sent.
+	 */
+	class WriteCompressionScope
+	{
+	public:
+		WriteCompressionScope (std::shared_ptr<Socket> socket);
+		~WriteCompressionScope ();
+	private:
+		std::weak_ptr<Socket> _socket;
+	};
+
+	/** After one of these is created everything that is read from the socket will be
+	 *  decompressed; the data must have been written with a WriteCompressionScope.
+	 */
+	class ReadCompressionScope
+	{
+	public:
+		ReadCompressionScope (std::shared_ptr<Socket> socket);
+		~ReadCompressionScope ();
+	private:
+		std::weak_ptr<Socket> _socket;
+	};
+
 private:
 	friend class DigestScope;
 
@@ -95,6 +133,14 @@ private:
 	bool check_read_digest ();
 	void start_write_digest ();
 	void finish_write_digest ();
+	void start_write_compression ();
+	void finish_write_compression ();
+	void start_read_compression ();
+	void finish_read_compression ();
+	void write_to_network (uint8_t const* data, int size);
+	void read_from_network (uint8_t* data, int size);
+	void write_chunk (uint8_t const* data, int size);
+	std::vector<uint8_t> read_chunk ();
 	void connect(boost::asio::ip::tcp::endpoint endpoint);
 #ifdef DCPOMATIC_HAVE_BOOST_ASIO_IP_BASIC_RESOLVER_RESULTS
 	void connect(boost::asio::ip::basic_resolver_results<boost::asio::ip::tcp> endpoints);
@@ -106,5 +152,9 @@ private:
 	int _timeout;
 	boost::scoped_ptr<Digester> _read_digester;
 	boost::scoped_ptr<Digester> _write_digester;
+	boost::scoped_ptr<Deflater> _deflater;
+	boost::scoped_ptr<Inflater> _inflater;
 	boost::optional<int> _send_buffer_size;
+	uint64_t _bytes_read = 0;
+	uint64_t _network_bytes_read = 0;
 };
@@ -0,0 +1,132 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#include "deflater.h"
+#include "exceptions.h"
+#include <cstring>
+
+#include "i18n.h"
+
+
+using std::function;
+using std::vector;
+
+
+/** Size of the chunks of compressed data that we pass to our output */
+static int const chunk_size = 1024 * 1024;
+
+
+Deflater::Deflater(function<void (uint8_t const*, int)> output)
+	: _output(output)
+	, _buffer(chunk_size)
+{
+	memset(&_stream, 0, sizeof(_stream));
+	if (deflateInit(&_stream, Z_BEST_SPEED) != Z_OK) {
+		throw EncodeError(N_("Could not set up zlib compression"));
+	}
+}
+
+
+Deflater::~Deflater()
+{
+	deflateEnd(&_stream);
+}
+
+
+void
+Deflater::add(uint8_t const* data, int size)
+{
+	_stream.next_in = const_cast<uint8_t*>(data);
+	_stream.avail_in = size;
+	run(Z_NO_FLUSH);
+}
+
+
+/** Compress anything that is left and pass it to the output */
+void
+Deflater::finish()
+{
+	_stream.next_in = nullptr;
+	_stream.avail_in = 0;
+	run(Z_FINISH);
+}
+
+
+void
+Deflater::run(int flush)
+{
+	do {
+		_stream.next_out = _buffer.data();
+		_stream.avail_out = _buffer.size();
+		if (deflate(&_stream, flush) == Z_STREAM_ERROR) {
+			throw EncodeError(N_("Could not compress data"));
+		}
+		auto const have = static_cast<int>(_buffer.size() - _stream.avail_out);
+		if (have > 0) {
+			_output(_buffer.data(), have);
+		}
+	} while (_stream.avail_out == 0);
+}
+
+
+Inflater::Inflater(function<vector<uint8_t> ()> input)
+	: _input(input)
+{
+	memset(&_stream, 0, sizeof(_stream));
+	if (inflateInit(&_stream) != Z_OK) {
+		throw DecodeError(N_("Could not set up zlib decompression"));
+	}
+}
+
+
+Inflater::~Inflater()
+{
+	inflateEnd(&_stream);
+}
+
+
+/** Fill a buffer with decompressed data, fetching more compressed data
+ *  from our input as required.
+ */
+void
+Inflater::get(uint8_t* data, int size)
+{
+	_stream.next_out = data;
+	_stream.avail_out = size;
+
+	while (_stream.avail_out > 0) {
+		if (_stream.avail_in == 0) {
+			_buffer = _input();
+			if (_buffer.empty()) {
+				throw DecodeError(N_("Compressed data ended early"));
+			}
+			_stream.next_in = _buffer.data();
+			_stream.avail_in = _buffer.size();
+		}
+
+		auto const r = inflate(&_stream, Z_NO_FLUSH);
+		if (r == Z_STREAM_END && _stream.avail_out > 0) {
+			throw DecodeError(N_("Compressed data ended early"));
+		} else if (r != Z_OK && r != Z_STREAM_END) {
+			throw DecodeError(N_("Could not decompress data"));
+		}
+	}
+}
@@ -0,0 +1,82 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#ifndef DCPOMATIC_DEFLATER_H
+#define DCPOMATIC_DEFLATER_H
+
+
+#include <zlib.h>
+#include <functional>
+#include <vector>
+#include <stdint.h>
+
+
+/** @class Deflater
+ *  @brief Compress a stream of data with zlib, optimising for speed rather than size.
+ *
+ *  Compressed data is passed to a handler in chunks as it becomes available.
+ */
+class Deflater
+{
+public:
+	explicit Deflater(std::function<void (uint8_t const*, int)> output);
+	~Deflater();
+
+	Deflater(Deflater const&) = delete;
+	Deflater& operator=(Deflater const&) = delete;
+
+	void add(uint8_t const* data, int size);
+	void finish();
+
+private:
+	void run(int flush);
+
+	z_stream _stream;
+	std::function<void (uint8_t const*, int)> _output;
+	std::vector<uint8_t> _buffer;
+};
+
+
+/** @class Inflater
+ *  @brief Decompress a stream of data that was made by a Deflater.
+ *
+ *  Compressed data is obtained on demand from a handler, which should return
+ *  the next chunk of data.
+ */
+class Inflater
+{
+public:
+	explicit Inflater(std::function<std::vector<uint8_t> ()> input);
+	~Inflater();
+
+	Inflater(Inflater const&) = delete;
+	Inflater& operator=(Inflater const&) = delete;
+
+	void get(uint8_t* data, int size);
+
+private:
+	z_stream _stream;
+	std::function<std::vector<uint8_t> ()> _input;
+	std::vector<uint8_t> _buffer;
+};
+
+
+#endif
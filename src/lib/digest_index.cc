@@ -0,0 +1,326 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+
+#include "cross.h"
+#include "dcpomatic_assert.h"
+#include "digest_index.h"
+#include "digester.h"
+#include "exceptions.h"
+#include <dcp/file.h>
+#include <dcp/filesystem.h>
+#include <dcp/warnings.h>
+#include <libcxml/cxml.h>
+LIBDCP_DISABLE_WARNINGS
+#include <libxml++/libxml++.h>
+LIBDCP_ENABLE_WARNINGS
+#include <fmt/format.h>
+#include <boost/algorithm/string.hpp>
+#include <functional>
+#include <future>
+
+#include "i18n.h"
+
+
+using std::min;
+using std::string;
+using std::vector;
+using boost::algorithm::trim;
+
+
+int const DigestIndex::_current_version = 2;
+size_t const DigestIndex::_max_entries = 4096;
+
+
+static
+string
+paths_key(vector<boost::filesystem::path> const& paths)
+{
+	Digester digester;
+	for (auto const& path: paths) {
+		auto const s = path.string();
+		digester.add(s.length());
+		digester.add(s);
+	}
+	return digester.get();
+}
+
+
+/** @return The same digest as simple_digest(paths) would, using one we calculated before if
+ *  none of the files that it came from have changed.
+ */
+string
+DigestIndex::digest(vector<boost::filesystem::path> const& paths)
+{
+	auto const key = paths_key(paths);
+
+	boost::optional<Entry> existing;
+	{
+		boost::mutex::scoped_lock lm(_mutex);
+		auto iter = _entries.find(key);
+		if (iter != _entries.end()) {
+			existing = iter->second;
+		}
+	}
+
+	/* Don't hold the lock while we look at the files, as they might be somewhere slow */
+	if (existing && up_to_date(*existing)) {
+		boost::mutex::scoped_lock lm(_mutex);
+		++_statistics.hits;
+		auto iter = _entries.find(key);
+		if (iter != _entries.end()) {
+			iter->second.last_used = ++_uses;
+		}
+		return existing->digest;
+	}
+
+	auto entry = calculate(paths);
+
+	boost::mutex::scoped_lock lm(_mutex);
+	++_statistics.misses;
+	entry.last_used = ++_uses;
+	_entries[key] = entry;
+	_dirty = true;
+	trim_entries();
+	return entry.digest;
+}
+
+
+/** @return true if none of the files that an entry was calculated from have changed */
+bool
+DigestIndex::up_to_date(Entry const& entry)
+{
+	for (auto const& file: entry.files) {
+		boost::system::error_code ec;
+		auto const size = dcp::filesystem::file_size(file.path, ec);
+		if (ec || size != file.size) {
+			return false;
+		}
+		auto const time = last_write_time_nanoseconds(file.path);
+		if (!time || *time != file.time) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+/** Calculate a digest in the same way as simple_digest(), but reading the head and
+ *  the tail of the files at the same time.
+ */
+DigestIndex::Entry
+DigestIndex::calculate(vector<boost::filesystem::path> const& paths)
+{
+	DCPOMATIC_ASSERT(!paths.empty());
+
+	/* Number of bytes to take from the start and end of the files */
+	boost::uintmax_t const size = 1000000;
+
+	struct Read
+	{
+		boost::filesystem::path path;
+		boost::uintmax_t length;
+		/** true to read from the end of the file, false to read from the start */
+		bool from_end;
+		char* destination;
+	};
+
+	vector<Read> head_reads;
+	vector<Read> tail_reads;
+	Entry entry;
+
+	vector<boost::optional<boost::uintmax_t>> sizes(paths.size());
+	auto file_size = [&paths, &sizes, &entry](size_t index) {
+		if (!sizes[index]) {
+			boost::system::error_code ec;
+			sizes[index] = dcp::filesystem::file_size(paths[index], ec);
+			if (ec) {
+				throw OpenFileError(paths[index].string(), ec.value(), OpenFileError::READ);
+			}
+			entry.files.push_back({paths[index], *sizes[index], last_write_time_nanoseconds(paths[index]).get_value_or(0)});
+		}
+		return *sizes[index];
+	};
+
+	vector<char> head(size);
+	boost::uintmax_t head_length = 0;
+	for (size_t i = 0; i < paths.size() && head_length < size; ++i) {
+		auto const this_time = min(size - head_length, file_size(i));
+		head_reads.push_back({paths[i], this_time, false, head.data() + head_length});
+		head_length += this_time;
+	}
+
+	vector<char> tail(size);
+	boost::uintmax_t tail_length = 0;
+	for (int i = static_cast<int>(paths.size()) - 1; i >= 0 && tail_length < size; --i) {
+		auto const this_time = min(size - tail_length, file_size(i));
+		tail_reads.push_back({paths[i], this_time, true, tail.data() + tail_length});
+		tail_length += this_time;
+	}
+
+	auto read_all = [](vector<Read> const& reads) {
+		for (auto const& read: reads) {
+			if (read.length == 0) {
+				continue;
+			}
+			dcp::File file(read.path, "rb");
+			if (!file) {
+				throw OpenFileError(read.path.string(), file.open_error(), OpenFileError::READ);
+			}
+			if (read.from_end) {
+				file.seek(-static_cast<int64_t>(read.length), SEEK_END);
+			}
+			file.checked_read(read.destination, read.length);
+		}
+	};
+
+	/* Read the tail in another thread while we read the head here; with many files
+	 * one thread per read would be far too many.
+	 */
+	auto tail_future = std::async(std::launch::async, read_all, std::cref(tail_reads));
+	read_all(head_reads);
+	tail_future.get();
+
+	Digester digester;
+	digester.add(head.data(), head_length);
+	digester.add(tail.data(), tail_length);
+	entry.digest = digester.get() + fmt::to_string(file_size(0));
+	return entry;
+}
+
+
+/** Remove the least-recently-used entries until we have no more than _max_entries.
+ *  A lock must be held on _mutex.
+ */
+void
+DigestIndex::trim_entries()
+{
+	while (_entries.size() > _max_entries) {
+		auto oldest = std::min_element(_entries.begin(), _entries.end(), [](std::pair<string const, Entry> const& a, std::pair<string const, Entry> const& b) {
+			return a.second.last_used < b.second.last_used;
+		});
+		_entries.erase(oldest);
+	}
+}
+
+
+DigestIndex::Statistics
+DigestIndex::statistics() const
+{
+	boost::mutex::scoped_lock lm(_mutex);
+	return _statistics;
+}
+
+
+/** Write the index to disk, if it has changed since it was last written */
+void
+DigestIndex::write() const
+{
+	boost::mutex::scoped_lock lm(_mutex);
+
+	if (!_dirty) {
+		return;
+	}
+
+	xmlpp::Document doc;
+	auto root = doc.create_root_node("DigestIndex");
+
+	cxml::add_text_child(root, "Version", fmt::to_string(_current_version));
+
+	for (auto const& i: _entries) {
+		auto entry = cxml::add_child(root, "Entry");
+		cxml::add_text_child(entry, "Key", i.first);
+		cxml::add_text_child(entry, "Digest", i.second.digest);
+		for (auto const& file: i.second.files) {
+			auto file_node = cxml::add_child(entry, "File");
+			cxml::add_text_child(file_node, "Path", file.path.string());
+			cxml::add_text_child(file_node, "Size", fmt::to_string(file.size));
+			cxml::add_text_child(file_node, "Time", fmt::to_string(file.time));
+		}
+	}
+
+	auto const target = write_path("digests.xml");
+
+	/* Write to a temporary file and then move it into place so that nobody
+	 * ever sees half an index.
+	 */
+	try {
+		auto const s = doc.write_to_string_formatted();
+		boost::filesystem::path tmp(string(target.string()).append(".tmp"));
+		dcp::File f(tmp, "w");
+		if (!f) {
+			throw FileError(_("Could not open file for writing"), tmp);
+		}
+		f.checked_write(s.c_str(), s.bytes());
+		f.close();
+		dcp::filesystem::rename(tmp, target);
+	} catch (xmlpp::exception& e) {
+		string s = e.what();
+		trim(s);
+		throw FileError(s, target);
+	}
+
+	_dirty = false;
+}
+
+
+void
+DigestIndex::read()
+try
+{
+	cxml::Document f("DigestIndex");
+	f.read_file(dcp::filesystem::fix_long_path(read_path("digests.xml")));
+
+	if (f.optional_number_child<int>("Version").get_value_or(0) != _current_version) {
+		/* Older indexes have times in seconds, which we can't compare with ours */
+		return;
+	}
+
+	boost::mutex::scoped_lock lm(_mutex);
+	for (auto entry_node: f.node_children("Entry")) {
+		Entry entry;
+		entry.digest = entry_node->string_child("Digest");
+		for (auto file_node: entry_node->node_children("File")) {
+			entry.files.push_back({
+				file_node->string_child("Path"),
+				file_node->number_child<boost::uintmax_t>("Size"),
+				file_node->number_child<int64_t>("Time")
+			});
+		}
+		entry.last_used = ++_uses;
+		_entries[entry_node->string_child("Key")] = entry;
+	}
+} catch (...) {
+	/* Never mind; we'll just have to calculate digests again */
+}
+
+
+DigestIndex*
+DigestIndex::instance()
+{
+	static auto instance = []() {
+		auto index = new DigestIndex();
+		index->read();
+		return index;
+	}();
+	return instance;
+}
@@ -0,0 +1,101 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+
+#ifndef DCPOMATIC_DIGEST_INDEX_H
+#define DCPOMATIC_DIGEST_INDEX_H
+
+
+#include "state.h"
+#include <boost/filesystem.hpp>
+#include <boost/thread/mutex.hpp>
+#include <map>
+#include <string>
+#include <vector>
+
+
+/** @class DigestIndex
+ *  @brief A record, kept on disk, of the digests that have been calculated for sets of files.
+ *
+ *  The digests are the same as those from simple_digest().  A stored digest is used as long as
+ *  the sizes and modification times of the files that it was calculated from have not changed.
+ */
+class DigestIndex : public State
+{
+public:
+	DigestIndex() = default;
+
+	std::string digest(std::vector<boost::filesystem::path> const& paths);
+
+	void read() override;
+	void write() const override;
+
+	struct Statistics
+	{
+		/** number of times digest() found a usable digest in the index */
+		int64_t hits = 0;
+		/** number of times digest() had to calculate a digest */
+		int64_t misses = 0;
+	};
+
+	Statistics statistics() const;
+
+	static DigestIndex* instance();
+
+private:
+	/** Details of a file that some digest was calculated from */
+	struct File
+	{
+		boost::filesystem::path path;
+		boost::uintmax_t size;
+		/** modification time in nanoseconds since the Unix epoch, as it is easy to
+		 *  change a file and its size more than once in the same second.
+		 */
+		int64_t time;
+	};
+
+	struct Entry
+	{
+		std::string digest;
+		/** The files that were read to calculate the digest */
+		std::vector<File> files;
+		/** Value of _uses when this entry was last used */
+		int64_t last_used = 0;
+	};
+
+	static bool up_to_date(Entry const& entry);
+	static Entry calculate(std::vector<boost::filesystem::path> const& paths);
+	void trim_entries();
+
+	mutable boost::mutex _mutex;
+	/** Entries indexed by a digest of the paths that they are for */
+	std::map<std::string, Entry> _entries;
+	int64_t _uses = 0;
+	/** true if _entries has changed since it was last written */
+	mutable bool _dirty = false;
+	Statistics _statistics;
+
+	static int const _current_version;
+	static size_t const _max_entries;
+};
+
+
+#endif
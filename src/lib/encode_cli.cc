@@ -38,6 +38,7 @@
 #include "log.h"
 #include "make_dcp.h"
 #include "ratio.h"
+#include "slice_threads.h"
 #include "transcode_job.h"
 #include "util.h"
 #include "variant.h"
@@ -620,6 +621,7 @@ encode_cli(int argc, char* argv[], function<void (string)> out, function<void ()
 	JobManager::drop();
 
 	EncodeServerFinder::drop();
+	SliceThreads::drop();
 
 	if (dcp_path && !error) {
 		out(fmt::format("{}\n", film->dir(film->dcp_name(false)).string()));
@@ -34,6 +34,7 @@
 #include "dcpomatic_socket.h"
 #include "encode_server.h"
 #include "encoded_log_entry.h"
+#include "exceptions.h"
 #include "image.h"
 #include "log.h"
 #include "player_video.h"
@@ -83,6 +84,8 @@ EncodeServer::EncodeServer (bool verbose, int num_threads)
 	, _verbose (verbose)
 	, _num_threads (num_threads)
 	, _frames_encoded(0)
+	, _bytes_received(0)
+	, _bytes_saved(0)
 {
 
 }
@@ -92,11 +95,29 @@ EncodeServer::~EncodeServer ()
 {
 	boost::this_thread::disable_interruption dis;
 
+	list<shared_ptr<Session>> sessions;
+
 	{
 		boost::mutex::scoped_lock lm (_mutex);
 		_terminate = true;
 		_empty_condition.notify_all ();
 		_full_condition.notify_all ();
+		sessions = _sessions;
+	}
+
+	for (auto session: sessions) {
+		{
+			boost::mutex::scoped_lock lm (session->mutex);
+			session->terminate = true;
+			session->condition.notify_all ();
+		}
+		session->socket->close ();
+	}
+
+	for (auto session: sessions) {
+		try {
+			session->thread.join ();
+		} catch (...) {}
 	}
 
 	try {
@@ -119,19 +140,69 @@ EncodeServer::~EncodeServer ()
 }
 
 
-/** @param after_read Filled in with gettimeofday() after reading the input from the network.
- *  @param after_encode Filled in with gettimeofday() after encoding the image.
+/** Read messages from a master until it closes the connection.  Each message is
+ *  either a frame to encode or a request to send back the next encoded frame.
  */
-int
-EncodeServer::process (shared_ptr<Socket> socket, struct timeval& after_read, struct timeval& after_encode)
+void
+EncodeServer::session_thread (shared_ptr<Session> session)
 {
-	Socket::ReadDigestScope ds (socket);
+	while (true) {
+		uint32_t length = 0;
+		try {
+			length = session->socket->read_uint32 ();
+		} catch (...) {
+			/* The master has closed the connection, or gone away */
+			break;
+		}
 
-	auto length = socket->read_uint32 ();
+		try {
+			if (length == 0) {
+				if (!send(session)) {
+					break;
+				}
+			} else {
+				receive(session, length);
+			}
+		} catch (std::exception& e) {
+			cerr << "Error: " << e.what() << "\n";
+			LOG_ERROR ("Error: %1", e.what());
+			break;
+		}
+	}
+
+	session->socket->close ();
+
+	auto const mb = [](int64_t bytes) {
+		return fmt::format("{:.1f}MB", bytes / 1048576.0);
+	};
+
+	LOG_GENERAL ("Connection closed after receiving %1 of frame data; compression saved %2", mb(session->bytes_received), mb(session->bytes_saved));
+	if (_verbose) {
+		cout << "Connection closed after receiving " << mb(session->bytes_received) << " of frame data; compression saved " << mb(session->bytes_saved) << ".\n";
+	}
+
+	boost::mutex::scoped_lock lm (session->mutex);
+	session->done = true;
+}
+
+
+/** Read a frame from a session's socket and queue it for encoding.
+ *  @param length Length of the XML metadata which comes before the frame's data.
+ */
+void
+EncodeServer::receive (shared_ptr<Session> session, uint32_t length)
+{
 	if (length > 65536) {
 		throw NetworkError("Malformed encode request (too large)");
 	}
 
+	auto socket = session->socket;
+
+	struct timeval start;
+	gettimeofday (&start, 0);
+
+	Socket::ReadDigestScope ds (socket);
+
 	scoped_array<char> buffer (new char[length]);
 	socket->read (reinterpret_cast<uint8_t*>(buffer.get()), length);
 
@@ -142,38 +213,139 @@ EncodeServer::process (shared_ptr<Socket> socket, struct timeval& after_read, st
 	   if it is the wrong version, but it doesn't hurt to make sure here.
 	*/
 	if (xml->number_child<int> ("Version") != SERVER_LINK_VERSION) {
-		cerr << "Mismatched server/client versions\n";
-		LOG_ERROR_NC ("Mismatched server/client versions");
-		return -1;
+		throw NetworkError ("Mismatched server/client versions");
+	}
+
+	auto const compression = xml->optional_string_child("Compression");
+	if (compression && *compression != "deflate") {
+		throw NetworkError (String::compose("Unknown compression %1 in encode request", *compression));
+	}
+
+	auto const bytes_before = socket->bytes_read ();
+	auto const network_bytes_before = socket->network_bytes_read ();
+
+	shared_ptr<PlayerVideo> pvf;
+	if (compression) {
+		Socket::ReadCompressionScope cs (socket);
+		pvf = make_shared<PlayerVideo>(xml, socket);
+	} else {
+		pvf = make_shared<PlayerVideo>(xml, socket);
 	}
 
-	auto pvf = make_shared<PlayerVideo>(xml, socket);
+	auto const network_bytes = static_cast<int64_t>(socket->network_bytes_read() - network_bytes_before);
+	auto const bytes_saved = static_cast<int64_t>(socket->bytes_read() - bytes_before) - network_bytes;
+	session->bytes_received += network_bytes;
+	session->bytes_saved += bytes_saved;
+	_bytes_received += network_bytes;
+	_bytes_saved += bytes_saved;
 
 	if (!ds.check()) {
 		throw NetworkError ("Checksums do not match");
 	}
 
-	DCPVideo dcp_video_frame (pvf, xml);
+	auto frame = make_shared<DCPVideo>(pvf, xml);
 
+	struct timeval after_read;
 	gettimeofday (&after_read, 0);
 
-	auto encoded = dcp_video_frame.encode_locally ();
+	{
+		boost::mutex::scoped_lock lm (session->mutex);
+		++session->in_flight;
+	}
 
-	gettimeofday (&after_encode, 0);
+	boost::mutex::scoped_lock lock (_mutex);
+
+	_waker.nudge ();
+
+	/* Wait until the queue has gone down a bit */
+	while (_queue.size() >= _worker_threads.size() * 2 && !_terminate) {
+		_full_condition.wait (lock);
+	}
+
+	_queue.push_back ({ session, frame, seconds(after_read) - seconds(start) });
+	_empty_condition.notify_all ();
+}
+
+
+/** Wait for one of a session's frames to finish encoding, then send it back.
+ *  @return false if the server is shutting down.
+ */
+bool
+EncodeServer::send (shared_ptr<Session> session)
+{
+	Session::Result result;
+
+	{
+		boost::mutex::scoped_lock lm (session->mutex);
+		if (session->in_flight == 0) {
+			throw NetworkError ("Encoded frame requested when none are being encoded");
+		}
+
+		while (session->finished.empty() && !session->terminate) {
+			session->condition.wait (lm);
+		}
+
+		if (session->terminate) {
+			return false;
+		}
+
+		result = session->finished.front ();
+		session->finished.pop_front ();
+		--session->in_flight;
+	}
+
+	struct timeval start;
+	gettimeofday (&start, 0);
+
+	auto socket = session->socket;
 
 	try {
 		Socket::WriteDigestScope ds (socket);
-		socket->write (encoded.size());
-		socket->write (encoded.data(), encoded.size());
+		socket->write (static_cast<uint32_t>(result.index));
+		socket->write (static_cast<uint32_t>(result.eyes));
+		if (result.data) {
+			socket->write (result.data->size());
+			socket->write (result.data->data(), result.data->size());
+		} else {
+			/* Tell the master that this frame failed; the connection can carry on being used */
+			socket->write (uint32_t(0));
+		}
 	} catch (std::exception& e) {
-		cerr << "Send failed; frame " << dcp_video_frame.index() << "\n";
-		LOG_ERROR ("Send failed; frame %1", dcp_video_frame.index());
+		cerr << "Send failed; frame " << result.index << "\n";
+		LOG_ERROR ("Send failed; frame %1", result.index);
 		throw;
 	}
 
+	if (!result.data) {
+		cerr << "Could not encode frame " << result.index << "\n";
+		LOG_ERROR ("Could not encode frame %1", result.index);
+		return true;
+	}
+
+	struct timeval end;
+	gettimeofday (&end, 0);
+
 	++_frames_encoded;
 
-	return dcp_video_frame.index ();
+	string ip;
+	try {
+		ip = socket->socket().remote_endpoint().address().to_string();
+	} catch (...) {}
+
+	auto e = make_shared<EncodedLogEntry>(
+		result.index, ip,
+		result.receive,
+		result.encode,
+		seconds(end) - seconds(start)
+		);
+
+	if (_verbose) {
+		cout << e->get() << "\n";
+	}
+
+	dcpomatic_log->log (e);
+
+	return true;
 }
 
 
@@ -190,24 +362,29 @@ EncodeServer::worker_thread ()
 			return;
 		}
 
-		auto socket = _queue.front ();
+		auto request = _queue.front ();
 		_queue.pop_front ();
 
+		_full_condition.notify_all ();
+
 		lock.unlock ();
 
-		int frame = -1;
-		string ip;
+		{
+			boost::mutex::scoped_lock lm (request.session->mutex);
+			if (request.session->done) {
+				/* The master has gone away, so there's no point encoding this */
+				continue;
+			}
+		}
 
 		struct timeval start;
-		struct timeval after_read;
-		struct timeval after_encode;
 		struct timeval end;
 
 		gettimeofday (&start, 0);
 
+		shared_ptr<ArrayData> encoded;
 		try {
-			frame = process (socket, after_read, after_encode);
-			ip = socket->socket().remote_endpoint().address().to_string();
+			encoded = make_shared<ArrayData>(request.frame->encode_locally());
 		} catch (std::exception& e) {
 			cerr << "Error: " << e.what() << "\n";
 			LOG_ERROR ("Error: %1", e.what());
@@ -215,29 +392,15 @@ EncodeServer::worker_thread ()
 
 		gettimeofday (&end, 0);
 
-		socket.reset ();
-
-		lock.lock ();
-
-		if (frame >= 0) {
-			struct timeval end;
-			gettimeofday (&end, 0);
-
-			auto e = make_shared<EncodedLogEntry>(
-				frame, ip,
-				seconds(after_read) - seconds(start),
-				seconds(after_encode) - seconds(after_read),
-				seconds(end) - seconds(after_encode)
-				);
-
-			if (_verbose) {
-				cout << e->get() << "\n";
-			}
-
-			dcpomatic_log->log (e);
-		}
-
-		_full_condition.notify_all ();
+		boost::mutex::scoped_lock lm (request.session->mutex);
+		request.session->finished.push_back ({
+			request.frame->index(),
+			request.frame->eyes(),
+			encoded,
+			request.receive,
+			seconds(end) - seconds(start)
+		});
+		request.session->condition.notify_all ();
 	}
 }
 
@@ -341,13 +504,30 @@ EncodeServer::handle (shared_ptr<Socket> socket)
 {
 	boost::mutex::scoped_lock lock (_mutex);
 
-	_waker.nudge ();
+	if (_terminate) {
+		return;
+	}
 
-	/* Wait until the queue has gone down a bit */
-	while (_queue.size() >= _worker_threads.size() * 2 && !_terminate) {
-		_full_condition.wait (lock);
+	/* Tidy up any sessions whose masters have gone away */
+	auto i = _sessions.begin ();
+	while (i != _sessions.end()) {
+		bool done = false;
+		{
+			boost::mutex::scoped_lock lm ((*i)->mutex);
+			done = (*i)->done;
+		}
+		if (done) {
+			(*i)->thread.join ();
+			i = _sessions.erase (i);
+		} else {
+			++i;
+		}
 	}
 
-	_queue.push_back (socket);
-	_empty_condition.notify_all ();
+	auto session = make_shared<Session>(socket);
+	session->thread = thread (bind(&EncodeServer::session_thread, this, session));
+#ifdef DCPOMATIC_LINUX
+	pthread_setname_np (session->thread.native_handle(), "encode-server-session");
+#endif
+	_sessions.push_back (session);
 }
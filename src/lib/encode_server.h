@@ -31,13 +31,17 @@
 #include "cross.h"
 #include "exception_store.h"
 #include "server.h"
+#include "types.h"
+#include <dcp/array_data.h>
 #include <boost/asio.hpp>
 #include <boost/atomic.hpp>
 #include <boost/thread.hpp>
 #include <boost/thread/condition.hpp>
+#include <list>
 #include <string>
 
 
+class DCPVideo;
 class Log;
 class Socket;
 
@@ -58,21 +62,82 @@ public:
 		return _frames_encoded;
 	}
 
+	/** @return number of bytes of frame data that have been received from the network */
+	int64_t bytes_received() const {
+		return _bytes_received;
+	}
+
+	/** @return number of bytes of network transfer that have been saved by compression */
+	int64_t bytes_saved() const {
+		return _bytes_saved;
+	}
+
 private:
+	/** A connection from a master, down which any number of frames may be sent */
+	struct Session
+	{
+		explicit Session(std::shared_ptr<Socket> socket_)
+			: socket(socket_)
+		{}
+
+		std::shared_ptr<Socket> socket;
+		boost::thread thread;
+
+		/** One frame which has finished encoding and is waiting to be sent back */
+		struct Result
+		{
+			int index = 0;
+			Eyes eyes = Eyes::BOTH;
+			/** encoded data, or empty if the encode failed */
+			std::shared_ptr<dcp::ArrayData> data;
+			/** time taken to receive the frame, in seconds */
+			double receive = 0;
+			/** time taken to encode the frame, in seconds */
+			double encode = 0;
+		};
+
+		/** mutex for the things below */
+		boost::mutex mutex;
+		/** condition to signal a change to finished */
+		boost::condition condition;
+		std::list<Result> finished;
+		/** number of frames that we have received but not yet sent back */
+		int in_flight = 0;
+		bool terminate = false;
+		bool done = false;
+
+		/* These are only used by the session's thread */
+		int64_t bytes_received = 0;
+		int64_t bytes_saved = 0;
+	};
+
+	/** A frame received from a master, waiting for a worker to encode it */
+	struct Request
+	{
+		std::shared_ptr<Session> session;
+		std::shared_ptr<DCPVideo> frame;
+		double receive;
+	};
+
 	void handle (std::shared_ptr<Socket>) override;
 	void worker_thread ();
-	int process (std::shared_ptr<Socket> socket, struct timeval &, struct timeval &);
+	void session_thread (std::shared_ptr<Session> session);
+	void receive (std::shared_ptr<Session> session, uint32_t length);
+	bool send (std::shared_ptr<Session> session);
 	void broadcast_thread ();
 	void broadcast_received ();
 
 	boost::thread_group _worker_threads;
-	std::list<std::shared_ptr<Socket>> _queue;
+	std::list<Request> _queue;
+	std::list<std::shared_ptr<Session>> _sessions;
 	boost::condition _full_condition;
 	boost::condition _empty_condition;
 	bool _verbose;
 	int _num_threads;
 	Waker _waker;
 	boost::atomic<int> _frames_encoded;
+	boost::atomic<int64_t> _bytes_received;
+	boost::atomic<int64_t> _bytes_saved;
 
 	struct Broadcast {
 
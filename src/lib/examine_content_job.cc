@@ -20,10 +20,14 @@
 
 
 #include "content.h"
+#include "dcpomatic_assert.h"
 #include "examine_content_job.h"
 #include "film.h"
 #include "log.h"
+#include "util.h"
 #include <boost/filesystem.hpp>
+#include <boost/thread.hpp>
+#include <algorithm>
 #include <iostream>
 
 #include "i18n.h"
@@ -31,15 +35,28 @@
 
 using std::string;
 using std::cout;
+using std::make_shared;
 using std::shared_ptr;
+using std::vector;
+using std::weak_ptr;
+
+
+int const ExamineContentJob::max_threads = 4;
 
 
 ExamineContentJob::ExamineContentJob(shared_ptr<const Film> film, shared_ptr<Content> content, bool tolerant)
+	: ExamineContentJob(film, vector<shared_ptr<Content>>{content}, tolerant)
+{
+
+}
+
+
+ExamineContentJob::ExamineContentJob(shared_ptr<const Film> film, vector<shared_ptr<Content>> content, bool tolerant)
 	: Job(film)
 	, _content(content)
 	, _tolerant(tolerant)
 {
-
+	DCPOMATIC_ASSERT(!_content.empty());
 }
 
 
@@ -66,7 +83,166 @@ ExamineContentJob::json_name () const
 void
 ExamineContentJob::run ()
 {
-	_content->examine(_film, shared_from_this(), _tolerant);
+	if (_content.size() == 1) {
+		_content[0]->examine(_film, shared_from_this(), _tolerant);
+		emit(boost::bind(boost::ref(ContentExamined), weak_ptr<Content>(_content[0])));
+	} else {
+		run_batch();
+	}
+
 	set_progress (1);
 	set_state (FINISHED_OK);
 }
+
+
+/** Examine all our content using a few threads.  Each piece of content reports its progress
+ *  to its own (unstarted) job in _items, and we combine those into our own progress.
+ */
+void
+ExamineContentJob::run_batch ()
+{
+	{
+		boost::mutex::scoped_lock lm(_mutex);
+		for (auto i: _content) {
+			_items.push_back(make_shared<ExamineContentJob>(_film, i, _tolerant));
+		}
+		_done.assign(_content.size(), false);
+		_errors.assign(_content.size(), std::exception_ptr());
+		_next = 0;
+	}
+
+	auto const threads = std::min(static_cast<int>(_content.size()), max_threads);
+	LOG_GENERAL("Examining %1 pieces of content using %2 threads", _content.size(), threads);
+
+	boost::thread_group workers;
+	for (int i = 0; i < threads; ++i) {
+		workers.create_thread(boost::bind(&ExamineContentJob::examine_thread, this));
+	}
+
+	try {
+		/* Index of the first piece of content that we have not yet announced */
+		size_t announced = 0;
+		while (announced < _content.size()) {
+			vector<shared_ptr<Content>> examined;
+			{
+				boost::mutex::scoped_lock lm(_mutex);
+				if (!_done[announced]) {
+					/* Wake up now and again to update our progress */
+					_examined.timed_wait(lm, boost::get_system_time() + boost::posix_time::milliseconds(250));
+				}
+				while (announced < _content.size() && _done[announced]) {
+					if (!_errors[announced]) {
+						examined.push_back(_content[announced]);
+					}
+					++announced;
+				}
+			}
+
+			for (auto i: examined) {
+				emit(boost::bind(boost::ref(ContentExamined), weak_ptr<Content>(i)));
+			}
+
+			update_progress();
+		}
+	} catch (...) {
+		workers.interrupt_all();
+		workers.join_all();
+		throw;
+	}
+
+	workers.join_all();
+
+	/* Content which examined successfully has already been announced, so now report the
+	   first problem (if there was one) in the usual way.
+	*/
+	for (auto i: _errors) {
+		if (i) {
+			std::rethrow_exception(i);
+		}
+	}
+}
+
+
+void
+ExamineContentJob::examine_thread ()
+try
+{
+	start_of_thread("ExamineContentJob");
+
+	while (true) {
+		check_for_interruption_or_pause();
+
+		shared_ptr<ExamineContentJob> item;
+		size_t index;
+		{
+			boost::mutex::scoped_lock lm(_mutex);
+			if (_next == _content.size()) {
+				return;
+			}
+			index = _next++;
+			item = _items[index];
+			item->set_state(RUNNING);
+			if (paused_by_user() || paused_by_priority()) {
+				item->pause_by_user();
+			}
+		}
+
+		std::exception_ptr error;
+		try {
+			_content[index]->examine(_film, item, _tolerant);
+		} catch (boost::thread_interrupted&) {
+			throw;
+		} catch (...) {
+			error = std::current_exception();
+		}
+
+		item->set_progress(1, true);
+		item->set_state(error ? FINISHED_ERROR : FINISHED_OK);
+
+		boost::mutex::scoped_lock lm(_mutex);
+		_done[index] = true;
+		_errors[index] = error;
+		_examined.notify_all();
+	}
+}
+catch (boost::thread_interrupted&)
+{
+	/* The job has been cancelled */
+}
+
+
+void
+ExamineContentJob::update_progress ()
+{
+	float total = 0;
+	{
+		boost::mutex::scoped_lock lm(_mutex);
+		for (size_t i = 0; i < _items.size(); ++i) {
+			total += _done[i] ? 1 : _items[i]->progress().get_value_or(0);
+		}
+	}
+
+	set_progress(total / _content.size());
+}
+
+
+void
+ExamineContentJob::pause ()
+{
+	boost::mutex::scoped_lock lm(_mutex);
+	for (auto i: _items) {
+		i->pause_by_user();
+	}
+}
+
+
+void
+ExamineContentJob::resume ()
+{
+	Job::resume();
+
+	boost::mutex::scoped_lock lm(_mutex);
+	for (auto i: _items) {
+		i->resume();
+	}
+}
@@ -20,27 +20,69 @@
 
 
 #include "job.h"
+#include <boost/signals2.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/thread/mutex.hpp>
+#include <exception>
+#include <vector>
 
 
 class Content;
 
 
+/** @class ExamineContentJob
+ *  @brief A job to examine one or more pieces of content.
+ *
+ *  When there is more than one piece of content they are examined in parallel,
+ *  and ContentExamined is emitted for each as soon as it (and everything before it
+ *  in the list) has been examined, so that callers can use content without waiting
+ *  for the whole batch.
+ */
 class ExamineContentJob : public Job
 {
 public:
 	ExamineContentJob(std::shared_ptr<const Film> film, std::shared_ptr<Content> content, bool tolerant);
+	ExamineContentJob(std::shared_ptr<const Film> film, std::vector<std::shared_ptr<Content>> content, bool tolerant);
 	~ExamineContentJob ();
 
 	std::string name () const override;
 	std::string json_name () const override;
 	void run () override;
+	void pause () override;
+	void resume () override;
+	Resource resource () const override {
+		return Resource::IO;
+	}
 
-	std::shared_ptr<Content> content () const {
+	std::vector<std::shared_ptr<Content>> content () const {
 		return _content;
 	}
 
+	/** Emitted from the UI thread, in the order that the content was given to the constructor,
+	 *  when a piece of content has been examined successfully.
+	 */
+	boost::signals2::signal<void (std::weak_ptr<Content>)> ContentExamined;
+
+	/** Maximum number of pieces of content to examine at the same time */
+	static int const max_threads;
+
 private:
-	std::shared_ptr<Content> _content;
+	void run_batch ();
+	void examine_thread ();
+	void update_progress ();
+
+	std::vector<std::shared_ptr<Content>> _content;
 
 	bool _tolerant;
+
+	/** mutex for the batch state below */
+	boost::mutex _mutex;
+	/** condition to signal when a piece of content has been examined */
+	boost::condition _examined;
+	/** jobs used to collect progress from each examination in a batch; they are never started */
+	std::vector<std::shared_ptr<ExamineContentJob>> _items;
+	std::vector<bool> _done;
+	std::vector<std::exception_ptr> _errors;
+	/** index of the next piece of content to be examined */
+	size_t _next = 0;
 };
@@ -33,12 +33,14 @@
 #include "ffmpeg_audio_stream.h"
 #include "ffmpeg_content.h"
 #include "ffmpeg_decoder.h"
+#include "ffmpeg_packet_image_proxy.h"
 #include "ffmpeg_subtitle_stream.h"
 #include "film.h"
 #include "filter.h"
 #include "frame_interval_checker.h"
 #include "image.h"
 #include "log.h"
+#include "pcm_unpack.h"
 #include "raw_image_proxy.h"
 #include "text_content.h"
 #include "text_decoder.h"
@@ -85,6 +87,16 @@ FFmpegDecoder::FFmpegDecoder (shared_ptr<const Film> film, shared_ptr<const FFmp
 		/* It doesn't matter what size or pixel format this is, it just needs to be black */
 		_black_image = make_shared<Image>(AV_PIX_FMT_RGB24, dcp::Size (128, 128), Image::Alignment::PADDED);
 		_black_image->make_black ();
+		/* If each video packet can be decoded on its own, and we don't need to filter the
+		 * decoded frames, we can leave the decoding to whoever eventually needs the image.
+		 */
+		_pass_video_packets =
+			_video_stream &&
+			c->filters().empty() &&
+			FFmpegPacketImageProxy::suitable(_format_context->streams[_video_stream.get()]->codecpar);
+		if (_pass_video_packets) {
+			LOG_GENERAL_NC("Passing on video packets without decoding them");
+		}
 	} else {
 		_pts_offset = {};
 	}
@@ -236,7 +248,15 @@ FFmpegDecoder::pass ()
 	auto fc = _ffmpeg_content;
 
 	if (_video_stream && si == _video_stream.get() && video && !video->ignore()) {
-		decode_and_process_video_packet (packet);
+		optional<int64_t> timestamp;
+		if (_pass_video_packets) {
+			timestamp = packet_best_effort_timestamp (packet);
+		}
+		if (timestamp) {
+			process_video_packet (packet, *timestamp);
+		} else {
+			decode_and_process_video_packet (packet);
+		}
 	} else if (fc->subtitle_stream() && fc->subtitle_stream()->uses_index(_format_context, si) && !only_text()->ignore()) {
 		decode_and_process_subtitle_packet (packet);
 	} else if (audio) {
@@ -274,96 +294,49 @@ deinterleave_audio(AVFrame* frame)
 		return audio;
 	}
 
+	/* Interleaved formats are converted to float, still interleaved, and then split into channels */
+	std::vector<float> samples;
+
 	switch (format) {
 	case AV_SAMPLE_FMT_U8:
-	{
-		auto p = reinterpret_cast<uint8_t *> (frame->data[0]);
-		int sample = 0;
-		int channel = 0;
-		for (int i = 0; i < total_samples; ++i) {
-			data[channel][sample] = float(*p++) / (1 << 23);
-
-			++channel;
-			if (channel == channels) {
-				channel = 0;
-				++sample;
-			}
-		}
-	}
-	break;
+		samples.resize(total_samples);
+		unpack_u8(reinterpret_cast<uint8_t*>(frame->data[0]), total_samples, samples.data());
+		audio->deinterleave_from(samples.data(), channels, frames, 0);
+		break;
 
 	case AV_SAMPLE_FMT_S16:
-	{
-		auto p = reinterpret_cast<int16_t *> (frame->data[0]);
-		int sample = 0;
-		int channel = 0;
-		for (int i = 0; i < total_samples; ++i) {
-			data[channel][sample] = float(*p++) / (1 << 15);
-
-			++channel;
-			if (channel == channels) {
-				channel = 0;
-				++sample;
-			}
-		}
-	}
-	break;
+		samples.resize(total_samples);
+		unpack_s16(reinterpret_cast<int16_t*>(frame->data[0]), total_samples, samples.data());
+		audio->deinterleave_from(samples.data(), channels, frames, 0);
+		break;
 
 	case AV_SAMPLE_FMT_S16P:
 	{
 		auto p = reinterpret_cast<int16_t **> (frame->data);
 		for (int i = 0; i < channels; ++i) {
-			for (int j = 0; j < frames; ++j) {
-				data[i][j] = static_cast<float>(p[i][j]) / (1 << 15);
-			}
+			unpack_s16(p[i], frames, data[i]);
 		}
 	}
 	break;
 
 	case AV_SAMPLE_FMT_S32:
-	{
-		auto p = reinterpret_cast<int32_t *> (frame->data[0]);
-		int sample = 0;
-		int channel = 0;
-		for (int i = 0; i < total_samples; ++i) {
-			data[channel][sample] = static_cast<float>(*p++) / 2147483648;
-
-			++channel;
-			if (channel == channels) {
-				channel = 0;
-				++sample;
-			}
-		}
-	}
-	break;
+		samples.resize(total_samples);
+		unpack_s32(reinterpret_cast<int32_t*>(frame->data[0]), total_samples, samples.data());
+		audio->deinterleave_from(samples.data(), channels, frames, 0);
+		break;
 
 	case AV_SAMPLE_FMT_S32P:
 	{
 		auto p = reinterpret_cast<int32_t **> (frame->data);
 		for (int i = 0; i < channels; ++i) {
-			for (int j = 0; j < frames; ++j) {
-				data[i][j] = static_cast<float>(p[i][j]) / 2147483648;
-			}
+			unpack_s32(p[i], frames, data[i]);
 		}
 	}
 	break;
 
 	case AV_SAMPLE_FMT_FLT:
-	{
-		auto p = reinterpret_cast<float*> (frame->data[0]);
-		int sample = 0;
-		int channel = 0;
-		for (int i = 0; i < total_samples; ++i) {
-			data[channel][sample] = *p++;
-
-			++channel;
-			if (channel == channels) {
-				channel = 0;
-				++sample;
-			}
-		}
-	}
-	break;
+		audio->deinterleave_from(reinterpret_cast<float*>(frame->data[0]), channels, frames, 0);
+		break;
 
 	case AV_SAMPLE_FMT_FLTP:
 	{
@@ -444,6 +417,8 @@ FFmpegDecoder::seek (ContentTime time, bool accurate)
 	*/
 	_filter_graphs.clear();
 
+	_packet_timestamp_state = {};
+
 	if (video_codec_context ()) {
 		avcodec_flush_buffers (video_codec_context());
 	}
@@ -637,6 +612,58 @@ FFmpegDecoder::process_video_frame ()
 }
 
 
+/** Guess the timestamp of a video packet in the same way as FFmpeg's guess_correct_pts()
+ *  does to give best_effort_timestamp for the frames that we decode, so that frames
+ *  passed on as packets are timed just as they would have been if we had decoded them.
+ *  @return Timestamp in the stream's time base, or none if the packet has neither PTS nor DTS.
+ */
+optional<int64_t>
+FFmpegDecoder::packet_best_effort_timestamp (AVPacket const* packet)
+{
+	auto& state = _packet_timestamp_state;
+
+	if (packet->dts != AV_NOPTS_VALUE) {
+		state.num_faulty_dts += packet->dts <= state.last_dts;
+		state.last_dts = packet->dts;
+	} else if (packet->pts != AV_NOPTS_VALUE) {
+		state.last_dts = packet->pts;
+	}
+
+	if (packet->pts != AV_NOPTS_VALUE) {
+		state.num_faulty_pts += packet->pts <= state.last_pts;
+		state.last_pts = packet->pts;
+	} else if (packet->dts != AV_NOPTS_VALUE) {
+		state.last_pts = packet->dts;
+	}
+
+	if ((state.num_faulty_pts <= state.num_faulty_dts || packet->dts == AV_NOPTS_VALUE) && packet->pts != AV_NOPTS_VALUE) {
+		return packet->pts;
+	} else if (packet->dts != AV_NOPTS_VALUE) {
+		return packet->dts;
+	}
+
+	return {};
+}
+
+
+/** Emit a video packet, without decoding it, for a stream whose packets can each
+ *  be decoded on their own.
+ *  @param timestamp Timestamp of the packet in the stream's time base.
+ */
+void
+FFmpegDecoder::process_video_packet (AVPacket const* packet, int64_t timestamp)
+{
+	auto const stream = _format_context->streams[_video_stream.get()];
+	double const pts = timestamp * av_q2d(stream->time_base) + _pts_offset.seconds();
+
+	video->emit (
+		film(),
+		make_shared<FFmpegPacketImageProxy>(packet, stream->codecpar),
+		ContentTime::from_seconds(pts)
+		);
+}
+
+
 void
 FFmpegDecoder::decode_and_process_subtitle_packet (AVPacket* packet)
 {
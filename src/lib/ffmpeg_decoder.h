@@ -40,6 +40,7 @@ class FFmpegAudioStream;
 class Image;
 class Log;
 class VideoFilterGraph;
+struct ffmpeg_packet_image_proxy_decode_test;
 struct ffmpeg_pts_offset_test;
 
 
@@ -55,6 +56,7 @@ public:
 	void seek (dcpomatic::ContentTime time, bool) override;
 
 private:
+	friend struct ::ffmpeg_packet_image_proxy_decode_test;
 	friend struct ::ffmpeg_pts_offset_test;
 
 	enum class FlushResult {
@@ -71,6 +73,8 @@ private:
 	void process_audio_frame (std::shared_ptr<FFmpegAudioStream> stream);
 
 	void process_video_frame ();
+	void process_video_packet (AVPacket const* packet, int64_t timestamp);
+	boost::optional<int64_t> packet_best_effort_timestamp (AVPacket const* packet);
 
 	bool decode_and_process_video_packet (AVPacket* packet);
 	void decode_and_process_audio_packet (AVPacket* packet);
@@ -87,6 +91,22 @@ private:
 	VideoFilterGraphSet _filter_graphs;
 
 	dcpomatic::ContentTime _pts_offset;
+	/** true to pass video packets on without decoding them, leaving that to be
+	 *  done by an encoder thread or server later.
+	 */
+	bool _pass_video_packets = false;
+
+	/** State used to guess the timestamp of video packets that we pass on, in
+	 *  the same way that FFmpeg guesses best_effort_timestamp for decoded frames.
+	 */
+	struct PacketTimestampState {
+		int64_t num_faulty_pts = 0;
+		int64_t num_faulty_dts = 0;
+		int64_t last_pts = INT64_MIN;
+		int64_t last_dts = INT64_MIN;
+	};
+
+	PacketTimestampState _packet_timestamp_state;
 	boost::optional<dcpomatic::ContentTime> _current_subtitle_to;
 	/** true if we have a subtitle which has not had emit_stop called for it yet */
 	bool _have_current_subtitle = false;
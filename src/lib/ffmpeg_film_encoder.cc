@@ -174,8 +174,7 @@ FFmpegFilmEncoder::go()
 
 	auto const video_frame = DCPTime::from_frames (1, _film->video_frame_rate ());
 	int const audio_frames = video_frame.frames_round(_film->audio_frame_rate());
-	std::vector<float> interleaved(_output_audio_channels * audio_frames);
-	auto deinterleaved = make_shared<AudioBuffers>(_output_audio_channels, audio_frames);
+	auto audio = make_shared<AudioBuffers>(_output_audio_channels, audio_frames);
 	int const gets_per_frame = _film->three_d() ? 2 : 1;
 	for (DCPTime time; time < _film->length(); time += video_frame) {
 
@@ -217,15 +216,8 @@ FFmpegFilmEncoder::go()
 
 		waker.nudge ();
 
-		_butler.get_audio(Butler::Behaviour::BLOCKING, interleaved.data(), audio_frames);
-		/* XXX: inefficient; butler interleaves and we deinterleave again */
-		float* p = interleaved.data();
-		for (int j = 0; j < audio_frames; ++j) {
-			for (int k = 0; k < _output_audio_channels; ++k) {
-				deinterleaved->data(k)[j] = *p++;
-			}
-		}
-		encoder->audio (deinterleaved);
+		_butler.get_audio(Butler::Behaviour::BLOCKING, audio.get(), audio_frames);
+		encoder->audio (audio);
 	}
 
 	for (auto i: file_encoders) {
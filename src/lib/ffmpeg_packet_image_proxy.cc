@@ -0,0 +1,246 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#include "compose.hpp"
+#include "dcpomatic_assert.h"
+#include "dcpomatic_socket.h"
+#include "exceptions.h"
+#include "ffmpeg_packet_image_proxy.h"
+#include "image.h"
+#include <dcp/scope_guard.h>
+#include <dcp/warnings.h>
+#include <libcxml/cxml.h>
+LIBDCP_DISABLE_WARNINGS
+extern "C" {
+#include <libavutil/pixdesc.h>
+}
+#include <libxml++/libxml++.h>
+LIBDCP_ENABLE_WARNINGS
+#include <fmt/format.h>
+
+#include "i18n.h"
+
+
+using std::dynamic_pointer_cast;
+using std::make_shared;
+using std::shared_ptr;
+using boost::optional;
+
+
+FFmpegPacketImageProxy::FFmpegPacketImageProxy (AVPacket const* packet, AVCodecParameters const* parameters)
+	: _data (packet->data, packet->size)
+	, _codec_id (parameters->codec_id)
+	, _codec_tag (parameters->codec_tag)
+	, _size (parameters->width, parameters->height)
+	, _format (parameters->format)
+	, _bits_per_coded_sample (parameters->bits_per_coded_sample)
+	, _profile (parameters->profile)
+	, _extradata (parameters->extradata_size > 0 ? dcp::ArrayData(parameters->extradata, parameters->extradata_size) : dcp::ArrayData())
+{
+
+}
+
+
+FFmpegPacketImageProxy::FFmpegPacketImageProxy (shared_ptr<cxml::Node> xml, shared_ptr<Socket> socket)
+	: _codec_id (static_cast<AVCodecID>(xml->number_child<int>("CodecId")))
+	, _codec_tag (xml->number_child<uint32_t>("CodecTag"))
+	, _size (xml->number_child<int>("Width"), xml->number_child<int>("Height"))
+	, _format (xml->number_child<int>("PixelFormat"))
+	, _bits_per_coded_sample (xml->number_child<int>("BitsPerCodedSample"))
+	, _profile (xml->number_child<int>("Profile"))
+{
+	/* Check what we have been told before we allocate anything based on it */
+	if (_size.width <= 0 || _size.height <= 0 || _size.width > max_dimension || _size.height > max_dimension) {
+		throw NetworkError(String::compose("Bad image size %1x%2 for FFmpeg packet", _size.width, _size.height));
+	}
+
+	if (!avcodec_find_decoder(_codec_id)) {
+		throw NetworkError(String::compose("No decoder for codec %1 of FFmpeg packet", static_cast<int>(_codec_id)));
+	}
+
+	auto const extradata_size = xml->number_child<int64_t>("ExtradataSize");
+	if (extradata_size < 0 || extradata_size > max_extradata_size) {
+		throw NetworkError(String::compose("Bad extradata size %1 for FFmpeg packet", extradata_size));
+	}
+
+	/* Even uncompressed video shouldn't need more than this */
+	int64_t const max_data_size = int64_t(_size.width) * _size.height * 16 + 1024 * 1024;
+	auto const data_size = xml->number_child<int64_t>("DataSize");
+	if (data_size <= 0 || data_size > max_data_size) {
+		throw NetworkError(String::compose("Bad data size %1 for %2x%3 FFmpeg packet", data_size, _size.width, _size.height));
+	}
+
+	_extradata = dcp::ArrayData(extradata_size);
+	if (_extradata.size() > 0) {
+		socket->read (_extradata.data(), _extradata.size());
+	}
+
+	_data = dcp::ArrayData(data_size);
+	socket->read (_data.data(), _data.size());
+}
+
+
+/** @return true if packets from a stream with the given parameters can each be decoded on their own */
+bool
+FFmpegPacketImageProxy::suitable (AVCodecParameters const* parameters)
+{
+	auto descriptor = avcodec_descriptor_get (parameters->codec_id);
+	if (!descriptor || !(descriptor->props & AV_CODEC_PROP_INTRA_ONLY)) {
+		return false;
+	}
+
+	/* Palettes come in packet side data, which we don't keep */
+	auto pixel_format = av_pix_fmt_desc_get (static_cast<AVPixelFormat>(parameters->format));
+	if (pixel_format && (pixel_format->flags & AV_PIX_FMT_FLAG_PAL)) {
+		return false;
+	}
+
+	return avcodec_find_decoder(parameters->codec_id) != nullptr;
+}
+
+
+ImageProxy::Result
+FFmpegPacketImageProxy::image (Image::Alignment alignment, optional<dcp::Size>) const
+{
+	auto constexpr name_for_errors = "FFmpegPacketImageProxy::image";
+
+	boost::mutex::scoped_lock lm (_mutex);
+
+	if (_image) {
+		return Result (Image::ensure_alignment(_image, alignment), 0);
+	}
+
+	auto codec = avcodec_find_decoder (_codec_id);
+	DCPOMATIC_ASSERT (codec);
+
+	auto context = avcodec_alloc_context3 (codec);
+	if (!context) {
+		throw DecodeError (N_("avcodec_alloc_context3"), name_for_errors);
+	}
+
+	auto frame = av_frame_alloc ();
+	auto packet = av_packet_alloc ();
+
+	dcp::ScopeGuard sg = [&context, &frame, &packet]() {
+		av_packet_free (&packet);
+		av_frame_free (&frame);
+		avcodec_free_context (&context);
+	};
+
+	if (!frame || !packet) {
+		throw std::bad_alloc ();
+	}
+
+	context->codec_tag = _codec_tag;
+	context->width = _size.width;
+	context->height = _size.height;
+	context->pix_fmt = static_cast<AVPixelFormat>(_format);
+	context->bits_per_coded_sample = _bits_per_coded_sample;
+	context->profile = _profile;
+	/* We are probably being called from one of many threads already */
+	context->thread_count = 1;
+
+	if (_extradata.size() > 0) {
+		context->extradata = static_cast<uint8_t*>(av_mallocz(_extradata.size() + AV_INPUT_BUFFER_PADDING_SIZE));
+		if (!context->extradata) {
+			throw std::bad_alloc ();
+		}
+		memcpy (context->extradata, _extradata.data(), _extradata.size());
+		context->extradata_size = _extradata.size();
+	}
+
+	int r = avcodec_open2 (context, codec, 0);
+	if (r < 0) {
+		throw DecodeError (N_("avcodec_open2"), name_for_errors, r);
+	}
+
+	r = av_new_packet (packet, _data.size());
+	if (r < 0) {
+		throw DecodeError (N_("av_new_packet"), name_for_errors, r);
+	}
+	memcpy (packet->data, _data.data(), _data.size());
+
+	r = avcodec_send_packet (context, packet);
+	if (r < 0) {
+		throw DecodeError (N_("avcodec_send_packet"), name_for_errors, r);
+	}
+
+	/* Flush so that decoders which would otherwise hold on to the frame give it up */
+	avcodec_send_packet (context, nullptr);
+
+	r = avcodec_receive_frame (context, frame);
+	if (r < 0) {
+		throw DecodeError (N_("avcodec_receive_frame"), name_for_errors, r);
+	}
+
+	_image = make_shared<Image>(frame, alignment);
+
+	return Result (_image, 0);
+}
+
+
+void
+FFmpegPacketImageProxy::add_metadata(xmlpp::Element* element) const
+{
+	cxml::add_text_child(element, "Type", N_("FFmpegPacket"));
+	cxml::add_text_child(element, "CodecId", fmt::to_string(static_cast<int>(_codec_id)));
+	cxml::add_text_child(element, "CodecTag", fmt::to_string(_codec_tag));
+	cxml::add_text_child(element, "Width", fmt::to_string(_size.width));
+	cxml::add_text_child(element, "Height", fmt::to_string(_size.height));
+	cxml::add_text_child(element, "PixelFormat", fmt::to_string(_format));
+	cxml::add_text_child(element, "BitsPerCodedSample", fmt::to_string(_bits_per_coded_sample));
+	cxml::add_text_child(element, "Profile", fmt::to_string(_profile));
+	cxml::add_text_child(element, "ExtradataSize", fmt::to_string(_extradata.size()));
+	cxml::add_text_child(element, "DataSize", fmt::to_string(_data.size()));
+}
+
+
+void
+FFmpegPacketImageProxy::write_to_socket (shared_ptr<Socket> socket) const
+{
+	if (_extradata.size() > 0) {
+		socket->write (_extradata.data(), _extradata.size());
+	}
+	socket->write (_data.data(), _data.size());
+}
+
+
+bool
+FFmpegPacketImageProxy::same (shared_ptr<const ImageProxy> other) const
+{
+	auto pp = dynamic_pointer_cast<const FFmpegPacketImageProxy>(other);
+	if (!pp) {
+		return false;
+	}
+
+	return _codec_id == pp->_codec_id && _data == pp->_data;
+}
+
+
+size_t
+FFmpegPacketImageProxy::memory_used () const
+{
+	size_t m = _data.size() + _extradata.size();
+	if (_image) {
+		m += _image->memory_used();
+	}
+	return m;
+}
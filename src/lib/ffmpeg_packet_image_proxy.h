@@ -0,0 +1,80 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#ifndef DCPOMATIC_FFMPEG_PACKET_IMAGE_PROXY_H
+#define DCPOMATIC_FFMPEG_PACKET_IMAGE_PROXY_H
+
+
+#include "image_proxy.h"
+#include <dcp/array_data.h>
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+#include <boost/thread/mutex.hpp>
+
+
+/** @class FFmpegPacketImageProxy
+ *  @brief An ImageProxy which holds a single still-compressed packet of video,
+ *  as it came out of the demuxer, from a stream which has no inter-frame coding.
+ *
+ *  Holding on to the packet means that the master need not decode things like
+ *  ProRes or DNxHD; that can instead be done in the encoding threads, or on an
+ *  encoding server, which is sent only the packet.
+ */
+class FFmpegPacketImageProxy : public ImageProxy
+{
+public:
+	FFmpegPacketImageProxy (AVPacket const* packet, AVCodecParameters const* parameters);
+	FFmpegPacketImageProxy (std::shared_ptr<cxml::Node> xml, std::shared_ptr<Socket> socket);
+
+	Result image (
+		Image::Alignment alignment,
+		boost::optional<dcp::Size> size = boost::optional<dcp::Size> ()
+		) const override;
+
+	void add_metadata(xmlpp::Element*) const override;
+	void write_to_socket (std::shared_ptr<Socket>) const override;
+	bool same (std::shared_ptr<const ImageProxy> other) const override;
+	size_t memory_used () const override;
+
+	static bool suitable (AVCodecParameters const* parameters);
+
+private:
+	/* Limits on what we will accept when reading a packet from a socket */
+	static int constexpr max_dimension = 65536;
+	static int constexpr max_extradata_size = 16 * 1024 * 1024;
+
+	dcp::ArrayData _data;
+	/* Things from the AVCodecParameters that the decoder may need */
+	AVCodecID _codec_id;
+	uint32_t _codec_tag;
+	dcp::Size _size;
+	int _format;
+	int _bits_per_coded_sample;
+	int _profile;
+	dcp::ArrayData _extradata;
+
+	mutable std::shared_ptr<const Image> _image;
+	mutable boost::mutex _mutex;
+};
+
+
+#endif
@@ -1336,30 +1336,16 @@ Film::set_isdcf_date_today()
 }
 
 
+/** @return path of a file that the writer can use to hold encoded frames for a reel
+ *  while it waits for earlier ones.
+ */
 boost::filesystem::path
-Film::j2c_path(int reel, Frame frame, Eyes eyes, bool tmp) const
+Film::j2c_spill_path(int reel) const
 {
 	boost::filesystem::path p;
 	p /= "j2c";
 	p /= video_identifier();
-
-	char buffer[256];
-	snprintf(buffer, sizeof(buffer), "%08d_%08" PRId64, reel, frame);
-	string s(buffer);
-
-	if (eyes == Eyes::LEFT) {
-		s += ".L";
-	} else if (eyes == Eyes::RIGHT) {
-		s += ".R";
-	}
-
-	s += ".j2c";
-
-	if (tmp) {
-		s += ".tmp";
-	}
-
-	p /= s;
+	p /= fmt::format("{:08d}.spill", reel);
 	return file(p);
 }
 
@@ -1417,27 +1403,39 @@ Film::content() const
 void
 Film::examine_and_add_content(shared_ptr<Content> content, bool disable_audio_analysis)
 {
-	if (dynamic_pointer_cast<FFmpegContent>(content) && _directory) {
-		run_ffprobe(content->path(0), file("ffprobe.log"));
+	examine_and_add_content(ContentList{content}, disable_audio_analysis);
+}
+
+/** Examine some content in a single job, adding each piece to the film as soon as it
+ *  has been examined successfully.  The content is added in the order given.
+ */
+void
+Film::examine_and_add_content(ContentList const& content, bool disable_audio_analysis)
+{
+	if (content.empty()) {
+		return;
+	}
+
+	if (_directory) {
+		for (auto i: content) {
+			if (dynamic_pointer_cast<FFmpegContent>(i)) {
+				run_ffprobe(i->path(0), file("ffprobe.log"));
+			}
+		}
 	}
 
 	auto j = make_shared<ExamineContentJob>(shared_from_this(), content, false);
 
 	_job_connections.push_back(
-		j->Finished.connect(bind(&Film::maybe_add_content, this, weak_ptr<Job>(j), weak_ptr<Content>(content), disable_audio_analysis))
+		j->ContentExamined.connect(bind(&Film::maybe_add_content, this, _1, disable_audio_analysis))
 		);
 
 	JobManager::instance()->add(j);
 }
 
 void
-Film::maybe_add_content(weak_ptr<Job> j, weak_ptr<Content> c, bool disable_audio_analysis)
+Film::maybe_add_content(weak_ptr<Content> c, bool disable_audio_analysis)
 {
-	auto job = j.lock();
-	if (!job || !job->finished_ok()) {
-		return;
-	}
-
 	auto content = c.lock();
 	if (!content) {
 		return;
@@ -101,7 +101,7 @@ public:
 	Film(Film const&) = delete;
 	Film& operator=(Film const&) = delete;
 
-	boost::filesystem::path j2c_path(int, Frame, Eyes, bool) const;
+	boost::filesystem::path j2c_spill_path(int reel) const;
 
 	boost::filesystem::path audio_analysis_path(std::shared_ptr<const Playlist>) const;
 	boost::filesystem::path subtitle_analysis_path(std::shared_ptr<const Content>) const;
@@ -378,6 +378,7 @@ public:
 	void set_name(std::string);
 	void set_use_isdcf_name(bool);
 	void examine_and_add_content(std::shared_ptr<Content> content, bool disable_audio_analysis = false);
+	void examine_and_add_content(ContentList const& content, bool disable_audio_analysis = false);
 	void add_content(std::shared_ptr<Content>);
 	void remove_content(std::shared_ptr<Content>);
 	void remove_content(ContentList);
@@ -476,7 +477,7 @@ private:
 	void playlist_order_changed();
 	void playlist_content_change(ChangeType type, std::weak_ptr<Content>, int, bool frequent);
 	void playlist_length_change();
-	void maybe_add_content(std::weak_ptr<Job>, std::weak_ptr<Content>, bool disable_audio_analysis);
+	void maybe_add_content(std::weak_ptr<Content>, bool disable_audio_analysis);
 	void audio_analysis_finished();
 	void check_settings_consistency();
 	void maybe_set_container_and_resolution();
@@ -20,9 +20,13 @@
 
 
 #include "content.h"
+#include "digest_index.h"
+#include "exceptions.h"
 #include "find_missing.h"
 #include "util.h"
 #include <dcp/filesystem.h>
+#include <fmt/format.h>
+#include <boost/algorithm/string.hpp>
 
 
 using std::map;
@@ -112,11 +116,21 @@ search_by_digest(Replacements& replacement_paths, boost::filesystem::path direct
 	boost::system::error_code ec;
 	for (auto candidate: dcp::filesystem::directory_iterator(directory, ec)) {
 		if (dcp::filesystem::is_regular_file(candidate.path())) {
-			auto const candidate_digest = simple_digest({candidate.path()});
-			for (auto& replacement: replacement_paths) {
-				DCPOMATIC_ASSERT(replacement.first->number_of_paths() == 1)
-				if (replacement.first->digest() == candidate_digest) {
-					replacement.second = { candidate.path() };
+			/* Our digests end with the size of the file, so there's no need to calculate the
+			 * digest of a candidate unless its size matches one of the content we are looking for.
+			 */
+			boost::system::error_code size_ec;
+			auto const size = fmt::to_string(dcp::filesystem::file_size(candidate.path(), size_ec));
+			auto const possible = !size_ec && std::any_of(replacement_paths.begin(), replacement_paths.end(), [&size](Replacements::value_type const& replacement) {
+				return boost::algorithm::ends_with(replacement.first->digest(), size);
+			});
+			if (possible) {
+				auto const candidate_digest = DigestIndex::instance()->digest({candidate.path()});
+				for (auto& replacement: replacement_paths) {
+					DCPOMATIC_ASSERT(replacement.first->number_of_paths() == 1)
+					if (replacement.first->digest() == candidate_digest) {
+						replacement.second = { candidate.path() };
+					}
 				}
 			}
 		} else if (dcp::filesystem::is_directory(candidate.path()) && depth <= 2) {
@@ -144,7 +158,7 @@ dcpomatic::find_missing (vector<shared_ptr<Content>> content_to_fix, boost::file
 	for (auto content: content_to_fix) {
 		auto const& repl = name_replacement_paths[content];
 		bool const replacements_exist = std::all_of(repl.begin(), repl.end(), [](path p) { return exists(p); });
-		if (replacements_exist && simple_digest(name_replacement_paths[content]) == content->digest()) {
+		if (replacements_exist && DigestIndex::instance()->digest(name_replacement_paths[content]) == content->digest()) {
 			content->set_paths (repl);
 		} else {
 			/* Put it on the list to look for by digest, if possible */
@@ -170,6 +184,12 @@ dcpomatic::find_missing (vector<shared_ptr<Content>> content_to_fix, boost::file
 		}
 	}
 
+	try {
+		DigestIndex::instance()->write();
+	} catch (FileError&) {
+		/* Never mind; we'll just have to calculate digests again next time */
+	}
+
 	/* Check fonts */
 	for (auto content: content_to_fix) {
 		map<boost::filesystem::path, boost::filesystem::path> fonts;
@@ -0,0 +1,210 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+
+#ifndef DCPOMATIC_FRAME_READ_AHEAD_H
+#define DCPOMATIC_FRAME_READ_AHEAD_H
+
+
+#include "dcpomatic_assert.h"
+#include <boost/optional.hpp>
+#include <boost/thread.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/thread/mutex.hpp>
+#include <deque>
+#include <exception>
+#include <functional>
+
+
+/** @class FrameReadAhead
+ *  @brief Read numbered frames from something (e.g. an asset reader) in a separate thread,
+ *  keeping a few frames ahead of the frame that was last asked for.
+ *
+ *  Once a FrameReadAhead has been made for a reader, the reader must only be used from
+ *  inside the read function given to the constructor.
+ */
+template <class T>
+class FrameReadAhead
+{
+public:
+	/** @param read Function to read a frame.
+	 *  @param end Index of the frame after the last one that can be read.
+	 *  @param size Maximum number of frames to read ahead.
+	 */
+	FrameReadAhead(std::function<T (int64_t)> read, int64_t end, int size)
+		: _read(read)
+		, _end(end)
+		, _size(size)
+	{
+		DCPOMATIC_ASSERT(_size > 0);
+		_thread = boost::thread(boost::bind(&FrameReadAhead::thread, this));
+	}
+
+	~FrameReadAhead()
+	{
+		{
+			boost::mutex::scoped_lock lm(_mutex);
+			_stop = true;
+		}
+		_space.notify_all();
+
+		try {
+			_thread.join();
+		} catch (...) {}
+	}
+
+	FrameReadAhead(FrameReadAhead const&) = delete;
+	FrameReadAhead& operator=(FrameReadAhead const&) = delete;
+
+	/** @return a frame, waiting for it to be read if necessary.  Any exception thrown
+	 *  when reading the frame will be thrown here.  Asking for a frame other than the
+	 *  one after the last one returned is allowed, but will discard anything that has
+	 *  been read ahead.
+	 */
+	T get(int64_t frame)
+	{
+		boost::mutex::scoped_lock lm(_mutex);
+
+		/* Skip anything before the frame that we want */
+		while (!_frames.empty() && _frames.front().frame < frame) {
+			_frames.pop_front();
+		}
+
+		if (frame >= _end) {
+			/* We don't read ahead past _end, but if we are asked for something there
+			 * we must read it (so that the caller gets whatever the read function gives,
+			 * or throws).
+			 */
+			_end = frame + 1;
+		}
+
+		bool const coming =
+			_started && (
+				(!_frames.empty() && _frames.front().frame == frame) ||
+				(_frames.empty() && (_next == frame || (_reading && *_reading == frame)))
+			);
+
+		if (!coming) {
+			/* This frame isn't next in line, so start again from it */
+			_frames.clear();
+			++_generation;
+			_next = frame;
+			_started = true;
+		}
+
+		_space.notify_all();
+
+		while (true) {
+			while (!_frames.empty() && _frames.front().frame < frame) {
+				_frames.pop_front();
+			}
+			if (!_frames.empty()) {
+				break;
+			}
+			_ready.wait(lm);
+		}
+
+		DCPOMATIC_ASSERT(_frames.front().frame == frame);
+		auto item = _frames.front();
+		_frames.pop_front();
+		_space.notify_all();
+
+		if (item.error) {
+			std::rethrow_exception(item.error);
+		}
+
+		return item.value;
+	}
+
+private:
+	void thread()
+	{
+		while (true) {
+			int64_t frame;
+			int generation;
+
+			{
+				boost::mutex::scoped_lock lm(_mutex);
+				while (!_stop && (!_started || static_cast<int>(_frames.size()) >= _size || _next >= _end)) {
+					_space.wait(lm);
+				}
+
+				if (_stop) {
+					return;
+				}
+
+				frame = _next++;
+				generation = _generation;
+				_reading = frame;
+			}
+
+			Item item;
+			item.frame = frame;
+			try {
+				item.value = _read(frame);
+			} catch (...) {
+				item.error = std::current_exception();
+			}
+
+			boost::mutex::scoped_lock lm(_mutex);
+			_reading = boost::none;
+			if (generation == _generation) {
+				/* Nobody has asked for a different frame while we were reading, so this is still wanted */
+				_frames.push_back(item);
+				_ready.notify_all();
+			}
+		}
+	}
+
+	struct Item
+	{
+		int64_t frame = 0;
+		T value;
+		std::exception_ptr error;
+	};
+
+	std::function<T (int64_t)> _read;
+
+	/** mutex for everything below here except _thread */
+	boost::mutex _mutex;
+	/** condition to signal when there is space for more frames, or we have been asked for a new frame */
+	boost::condition _space;
+	/** condition to signal when a frame has been read */
+	boost::condition _ready;
+	/** frames that have been read, in order */
+	std::deque<Item> _frames;
+	/** true if we have been asked for a frame yet */
+	bool _started = false;
+	/** next frame to read */
+	int64_t _next = 0;
+	/** frame that is currently being read, if any */
+	boost::optional<int64_t> _reading;
+	int64_t _end;
+	int _size;
+	/** incremented whenever we restart reading from a new place */
+	int _generation = 0;
+	bool _stop = false;
+
+	boost::thread _thread;
+};
+
+
+#endif
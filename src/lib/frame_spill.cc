@@ -0,0 +1,148 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#include "dcpomatic_assert.h"
+#include "exceptions.h"
+#include "frame_spill.h"
+
+
+using std::make_pair;
+using std::make_shared;
+using std::shared_ptr;
+
+
+FrameSpill::FrameSpill(boost::filesystem::path path)
+	: _path(path)
+	, _file(path, "w+b")
+{
+	if (!_file) {
+		throw OpenFileError(path, _file.open_error(), OpenFileError::READ_WRITE);
+	}
+}
+
+
+FrameSpill::~FrameSpill()
+{
+	_file.close();
+	boost::system::error_code ec;
+	boost::filesystem::remove(_path, ec);
+}
+
+
+/** Add a frame to the file.  If a frame with the same index and eyes is already
+ *  in the file it will be replaced.
+ */
+void
+FrameSpill::put(Frame frame, Eyes eyes, dcp::Data const& data)
+{
+	auto const key = make_pair(frame, eyes);
+	auto existing = _index.find(key);
+	if (existing != _index.end()) {
+		release(existing->second);
+		_index.erase(existing);
+	}
+
+	auto const offset = allocate(data.size());
+	_file.seek(offset, SEEK_SET);
+	_file.checked_write(data.data(), data.size());
+	_index[key] = { offset, data.size() };
+}
+
+
+/** Take a frame out of the file */
+shared_ptr<dcp::ArrayData>
+FrameSpill::get(Frame frame, Eyes eyes)
+{
+	auto iter = _index.find(make_pair(frame, eyes));
+	DCPOMATIC_ASSERT(iter != _index.end());
+
+	auto data = make_shared<dcp::ArrayData>(iter->second.size);
+	_file.seek(iter->second.offset, SEEK_SET);
+	_file.checked_read(data->data(), iter->second.size);
+
+	release(iter->second);
+	_index.erase(iter);
+
+	return data;
+}
+
+
+bool
+FrameSpill::has(Frame frame, Eyes eyes) const
+{
+	return _index.find(make_pair(frame, eyes)) != _index.end();
+}
+
+
+/** @return offset of some space in the file to write size bytes to; this will be the first
+ *  unused space that is big enough, or the end of the file.
+ */
+int64_t
+FrameSpill::allocate(int size)
+{
+	for (auto i = _free.begin(); i != _free.end(); ++i) {
+		if (i->second >= size) {
+			auto const offset = i->first;
+			auto const left = i->second - size;
+			_free.erase(i);
+			if (left > 0) {
+				_free[offset + size] = left;
+			}
+			return offset;
+		}
+	}
+
+	auto const offset = _end;
+	_end += size;
+	return offset;
+}
+
+
+/** Mark the space used by an entry as unused, joining it up with any unused space either side */
+void
+FrameSpill::release(Entry entry)
+{
+	auto offset = entry.offset;
+	int64_t size = entry.size;
+
+	auto next = _free.find(offset + size);
+	if (next != _free.end()) {
+		size += next->second;
+		_free.erase(next);
+	}
+
+	auto previous = _free.lower_bound(offset);
+	if (previous != _free.begin()) {
+		--previous;
+		if (previous->first + previous->second == offset) {
+			offset = previous->first;
+			size += previous->second;
+			_free.erase(previous);
+		}
+	}
+
+	if (offset + size == _end) {
+		/* This space is at the end, so the file can just get shorter */
+		_end = offset;
+	} else {
+		_free[offset] = size;
+	}
+}
@@ -0,0 +1,85 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#ifndef DCPOMATIC_FRAME_SPILL_H
+#define DCPOMATIC_FRAME_SPILL_H
+
+
+#include "types.h"
+#include <dcp/array_data.h>
+#include <dcp/file.h>
+#include <boost/filesystem.hpp>
+#include <map>
+#include <memory>
+
+
+/** @class FrameSpill
+ *  @brief A single file which holds encoded frames that the writer can't keep in memory
+ *  until it is ready to write them.
+ *
+ *  An index of where each frame is in the file is kept in memory.  The space left by a
+ *  frame which is taken out is re-used by later frames which fit into it, so the file
+ *  only needs to be as big as the most data that has been in it at once, rather than
+ *  growing while there is always something in it.  The file is removed when the
+ *  FrameSpill is destroyed.
+ *
+ *  This class is not thread-safe.
+ */
+class FrameSpill
+{
+public:
+	explicit FrameSpill(boost::filesystem::path path);
+	~FrameSpill();
+
+	FrameSpill(FrameSpill const&) = delete;
+	FrameSpill& operator=(FrameSpill const&) = delete;
+
+	void put(Frame frame, Eyes eyes, dcp::Data const& data);
+	std::shared_ptr<dcp::ArrayData> get(Frame frame, Eyes eyes);
+
+	bool has(Frame frame, Eyes eyes) const;
+
+	/** @return size of the part of the file that is in use, in bytes */
+	int64_t size() const {
+		return _end;
+	}
+
+private:
+	struct Entry
+	{
+		int64_t offset;
+		int size;
+	};
+
+	int64_t allocate(int size);
+	void release(Entry entry);
+
+	boost::filesystem::path _path;
+	dcp::File _file;
+	std::map<std::pair<Frame, Eyes>, Entry> _index;
+	/** unused parts of the file before _end; offset to size */
+	std::map<int64_t, int64_t> _free;
+	/** offset of the end of the data in the file */
+	int64_t _end = 0;
+};
+
+
+#endif
@@ -31,20 +31,22 @@
 #include "film.h"
 #include "font.h"
 #include "hints.h"
+#include "image.h"
+#include "image_png.h"
 #include "maths_util.h"
 #include "player.h"
+#include "playlist.h"
 #include "ratio.h"
 #include "text_content.h"
+#include "util.h"
 #include "variant.h"
 #include "video_content.h"
-#include "writer.h"
-#include <dcp/cpl.h>
 #include <dcp/filesystem.h>
-#include <dcp/reel.h>
-#include <dcp/reel_text_asset.h>
 #include <fmt/format.h>
 #include <boost/algorithm/string.hpp>
 #include <iostream>
+#include <set>
+#include <tuple>
 
 #include "i18n.h"
 
@@ -54,6 +56,7 @@ using std::make_shared;
 using std::max;
 using std::shared_ptr;
 using std::string;
+using std::vector;
 using std::weak_ptr;
 using boost::optional;
 using namespace dcpomatic;
@@ -68,6 +71,10 @@ using namespace boost::placeholders;
 #define SIZE_SLACK 4096
 
 
+boost::mutex Hints::_text_cache_mutex;
+std::map<string, shared_ptr<const Hints::TextEvents>> Hints::_text_cache;
+
+
 /* When writing hints:
  * - put quotation marks around the name of a GUI tab that you are referring to (e.g. "DCP" or "DCP→Video" tab)
  */
@@ -75,7 +82,6 @@ using namespace boost::placeholders;
 
 Hints::Hints(weak_ptr<const Film> weak_film)
 	: WeakConstFilm(weak_film)
-	, _writer(make_shared<Writer>(weak_film, weak_ptr<Job>(), film()->dir("hints") / dcpomatic::get_process_id(), true))
 	, _analyser(film(), film()->playlist(), true, [](float) {})
 	, _stop(false)
 {
@@ -368,14 +374,6 @@ Hints::check_loudness()
 }
 
 
-static
-bool
-subtitle_mxf_too_big(shared_ptr<dcp::TextAsset> asset)
-{
-	return asset && asset->file() && dcp::filesystem::file_size(*asset->file()) >= (MAX_TEXT_MXF_SIZE - SIZE_SLACK);
-}
-
-
 void
 Hints::check_out_of_range_markers()
 {
@@ -389,68 +387,299 @@ Hints::check_out_of_range_markers()
 
 
 void
-Hints::scan_content(shared_ptr<const Film> film)
+Hints::scan_audio(shared_ptr<const Film> film)
 {
-	auto const check_loudness_done = check_loudness();
+	if (check_loudness() || _disable_audio_analysis) {
+		/* We already loaded a suitable analysis, or we've been told not to make one */
+		return;
+	}
 
-	auto content = film->playlist()->content();
-	auto iter = std::find_if(content.begin(), content.end(), [](shared_ptr<const Content> content) {
-		auto text_iter = std::find_if(content->text.begin(), content->text.end(), [](shared_ptr<const TextContent> text) {
-			return text->use();
-		});
-		return text_iter != content->text.end();
-	});
+	emit(boost::bind(boost::ref(Progress), _("Examining audio")));
 
-	auto const have_text = iter != content.end();
+	auto player = make_shared<Player>(film, Image::Alignment::COMPACT, false);
+	player->set_ignore_video();
+	player->set_ignore_text();
+	player->Audio.connect(boost::bind(&Hints::audio, this, _1, _2));
 
-	if (check_loudness_done && !have_text) {
-		/* We don't need to check loudness, and we don't have any active text to check,
-		 * so a scan of the content is pointless.
-		 */
-		return;
+	struct timeval last_pulse;
+	gettimeofday(&last_pulse, 0);
+
+	while (!player->pass()) {
+
+		struct timeval now;
+		gettimeofday(&now, 0);
+		if ((seconds(now) - seconds(last_pulse)) > 1) {
+			if (_stop) {
+				return;
+			}
+			emit(boost::bind(boost::ref(Pulse)));
+			last_pulse = now;
+		}
 	}
 
-	if (check_loudness_done && have_text) {
-		emit(boost::bind(boost::ref(Progress), _("Examining subtitles and closed captions")));
-	} else if (!check_loudness_done && !have_text) {
-		emit(boost::bind(boost::ref(Progress), _("Examining audio")));
-	} else {
-		emit(boost::bind(boost::ref(Progress), _("Examining audio, subtitles and closed captions")));
+	_analyser.finish();
+	_analyser.get().write(film->audio_analysis_path(film->playlist()));
+	check_loudness();
+}
+
+
+/** @return string which changes when anything changes that affects the text which a Player
+ *  would emit from some content.
+ */
+static
+string
+text_cache_key(shared_ptr<const Film> film, shared_ptr<const Content> content)
+{
+	auto key = fmt::format("{}_{}_{}_{}", content->identifier(), film->video_frame_rate(), film->frame_size().width, film->frame_size().height);
+	for (auto text: content->text) {
+		key += fmt::format(
+			"_{}_{}_{}_{}_{}",
+			text->identifier(),
+			text->use() ? 1 : 0,
+			text->burn() ? 1 : 0,
+			static_cast<int>(text->type()),
+			text->dcp_track() ? text->dcp_track()->summary() : ""
+			);
 	}
+	return key;
+}
 
-	auto player = make_shared<Player>(film, Image::Alignment::COMPACT, false);
-	player->set_ignore_video();
-	if (check_loudness_done || _disable_audio_analysis) {
-		/* We don't need to analyse audio because we already loaded a suitable analysis */
-		player->set_ignore_audio();
-	} else {
-		/* Send auto to the analyser to check loudness */
-		player->Audio.connect(boost::bind(&Hints::audio, this, _1, _2));
+
+/** @return the text which a Player emits from some content, either from our cache or by
+ *  running a Player over just that content.  Returns nullptr if we were stopped.
+ */
+shared_ptr<const Hints::TextEvents>
+Hints::content_text(shared_ptr<const Film> film, shared_ptr<Content> content)
+{
+	auto const key = text_cache_key(film, content);
+
+	{
+		boost::mutex::scoped_lock lm(_text_cache_mutex);
+		auto cached = _text_cache.find(key);
+		if (cached != _text_cache.end()) {
+			return cached->second;
+		}
 	}
-	player->Text.connect(boost::bind(&Hints::text, this, _1, _2, _3, _4));
+
+	++_text_scans;
+
+	auto events = make_shared<TextEvents>();
+
+	auto playlist = make_shared<Playlist>();
+	playlist->add(film, content);
+
+	auto player = make_shared<Player>(film, playlist, false);
+	player->set_ignore_video();
+	player->set_ignore_audio();
+	player->Text.connect(
+		[events](PlayerText text, TextType type, optional<DCPTextTrack> track, DCPTimePeriod period) {
+			TextEvent event;
+			event.type = type;
+			event.track = track.get_value_or(DCPTextTrack());
+			event.period = period;
+			for (auto const& bitmap: text.bitmap) {
+				event.png_size += image_as_png(bitmap.image).size();
+			}
+			text.bitmap.clear();
+			event.text = text;
+			events->push_back(event);
+		});
 
 	struct timeval last_pulse;
 	gettimeofday(&last_pulse, 0);
 
-	_writer->write(player->get_subtitle_fonts());
-
 	while (!player->pass()) {
 
 		struct timeval now;
 		gettimeofday(&now, 0);
 		if ((seconds(now) - seconds(last_pulse)) > 1) {
 			if (_stop) {
-				return;
+				return {};
 			}
 			emit(boost::bind(boost::ref(Pulse)));
 			last_pulse = now;
 		}
 	}
 
-	if (!check_loudness_done) {
-		_analyser.finish();
-		_analyser.get().write(film->audio_analysis_path(film->playlist()));
-		check_loudness();
+	boost::mutex::scoped_lock lm(_text_cache_mutex);
+	_text_cache[key] = events;
+	return events;
+}
+
+
+/** Look at the subtitles and closed captions that our DCP will have.  Text from each piece of
+ *  content is cached, so only content which has changed since the last time we looked is scanned.
+ */
+void
+Hints::scan_text(shared_ptr<const Film> film)
+{
+	vector<shared_ptr<Content>> with_text;
+	for (auto content: film->playlist()->content()) {
+		auto used = std::find_if(content->text.begin(), content->text.end(), [](shared_ptr<const TextContent> text) {
+			return text->use();
+		});
+		if (used != content->text.end()) {
+			with_text.push_back(content);
+		}
+	}
+
+	if (with_text.empty()) {
+		return;
+	}
+
+	emit(boost::bind(boost::ref(Progress), _("Examining subtitles and closed captions")));
+
+	vector<TextEvent> events;
+	std::set<string> keys;
+	for (auto content: with_text) {
+		auto content_events = content_text(film, content);
+		if (!content_events) {
+			/* We were stopped */
+			return;
+		}
+		keys.insert(text_cache_key(film, content));
+		events.insert(events.end(), content_events->begin(), content_events->end());
+	}
+
+	{
+		/* Forget about text from content that is no longer in the film, or has changed */
+		boost::mutex::scoped_lock lm(_text_cache_mutex);
+		for (auto i = _text_cache.begin(); i != _text_cache.end(); ) {
+			if (keys.find(i->first) == keys.end()) {
+				i = _text_cache.erase(i);
+			} else {
+				++i;
+			}
+		}
+	}
+
+	std::stable_sort(events.begin(), events.end(), [](TextEvent const& a, TextEvent const& b) {
+		return a.period.from < b.period.from;
+	});
+
+	for (auto const& event: events) {
+		text(event.text, event.type, event.period);
+	}
+
+	if (_long_subtitle && !_very_long_subtitle) {
+		hint(_("At least one of your subtitle lines has more than 52 characters.  It is recommended to make each line 52 characters at most in length."));
+	} else if (_very_long_subtitle) {
+		hint(_("At least one of your subtitle lines has more than 79 characters.  You should make each line 79 characters at most in length."));
+	}
+
+	check_text_sizes(film, events);
+}
+
+
+/** @return an estimate of the number of bytes that some text will need in subtitle or closed caption XML */
+static
+size_t
+estimated_xml_size(PlayerText const& text, bool with_image)
+{
+	/* <Subtitle> with spot number, in/out times and fades */
+	size_t size = 160;
+	for (auto const& string: text.string) {
+		/* <Font> and <Text> with alignments, positions, direction, colours and so on */
+		size += 160 + string.text().length();
+	}
+	if (with_image) {
+		/* <Image> with alignments, positions and an ID */
+		size += 180;
+	}
+	return size;
+}
+
+
+/** Estimate the size of the subtitle and closed caption files that each reel of our DCP will have, and
+ *  warn if any will be too big.  This is much quicker than writing the files to see.
+ */
+void
+Hints::check_text_sizes(shared_ptr<const Film> film, vector<TextEvent> const& events)
+{
+	struct Asset
+	{
+		size_t xml = 0;
+		size_t png = 0;
+		std::set<shared_ptr<dcpomatic::Font>> fonts;
+	};
+
+	/* Assets indexed by reel, type and (for closed captions) track */
+	std::map<std::tuple<int, TextType, DCPTextTrack>, Asset> assets;
+
+	auto const reels = film->reels();
+	for (auto const& event: events) {
+		auto reel = std::find_if(reels.begin(), reels.end(), [&event](DCPTimePeriod const& reel) {
+			return reel.contains(event.period.from);
+		});
+		if (reel == reels.end()) {
+			continue;
+		}
+		auto const track = event.type == TextType::CLOSED_CAPTION ? event.track : DCPTextTrack();
+		auto& asset = assets[std::make_tuple(static_cast<int>(std::distance(reels.begin(), reel)), event.type, track)];
+		asset.xml += estimated_xml_size(event.text, event.png_size > 0);
+		asset.png += event.png_size;
+		for (auto const& string: event.text.string) {
+			asset.fonts.insert(string.font);
+		}
+	}
+
+	auto font_size = [](shared_ptr<dcpomatic::Font> font) -> size_t {
+		if (font) {
+			auto const content = font->content();
+			if (content.data) {
+				return content.data->size();
+			} else if (content.file) {
+				return dcp::filesystem::file_size(*content.file);
+			}
+		}
+		return dcp::filesystem::file_size(default_font_file());
+	};
+
+	bool ccap_xml_too_big = false;
+	bool ccap_mxf_too_big = false;
+	bool subs_mxf_too_big = false;
+
+	for (auto const& i: assets) {
+		auto const& asset = i.second;
+		/* Interop texts are XML with separate PNG and font files; SMPTE puts everything in the MXF */
+		size_t total = asset.xml;
+		if (!film->interop()) {
+			total += asset.png;
+			for (auto font: asset.fonts) {
+				total += font_size(font);
+			}
+		}
+		bool const mxf_too_big = total >= (MAX_TEXT_MXF_SIZE - SIZE_SLACK);
+
+		switch (std::get<1>(i.first)) {
+		case TextType::CLOSED_CAPTION:
+			if (asset.xml > static_cast<size_t>(MAX_CLOSED_CAPTION_XML_SIZE - SIZE_SLACK) && !ccap_xml_too_big) {
+				hint(_(
+						"At least one of your closed caption files' XML part is larger than " MAX_CLOSED_CAPTION_XML_SIZE_TEXT
+						".  You should divide the DCP into shorter reels."
+				       ));
+				ccap_xml_too_big = true;
+			}
+			if (mxf_too_big && !ccap_mxf_too_big) {
+				hint(_(
+						"At least one of your closed caption files is larger than " MAX_TEXT_MXF_SIZE_TEXT
+						" in total.  You should divide the DCP into shorter reels."
+				       ));
+				ccap_mxf_too_big = true;
+			}
+			break;
+		case TextType::OPEN_SUBTITLE:
+			if (mxf_too_big && !subs_mxf_too_big) {
+				hint(_(
+						"At least one of your subtitle files is larger than " MAX_TEXT_MXF_SIZE_TEXT " in total.  "
+						"You should divide the DCP into shorter reels."
+				       ));
+				subs_mxf_too_big = true;
+			}
+			break;
+		default:
+			break;
+		}
 	}
 }
 
@@ -489,52 +718,15 @@ try
 	check_8_or_16_audio_channels();
 	check_video_alpha();
 
-	scan_content(film);
-
-	if (_long_subtitle && !_very_long_subtitle) {
-		hint(_("At least one of your subtitle lines has more than 52 characters.  It is recommended to make each line 52 characters at most in length."));
-	} else if (_very_long_subtitle) {
-		hint(_("At least one of your subtitle lines has more than 79 characters.  You should make each line 79 characters at most in length."));
+	scan_audio(film);
+	if (_stop) {
+		return;
 	}
 
-	bool ccap_xml_too_big = false;
-	bool ccap_mxf_too_big = false;
-	bool subs_mxf_too_big = false;
-
-	auto dcp_dir = film->dir("hints") / dcpomatic::get_process_id();
-	dcp::filesystem::remove_all(dcp_dir);
-
-	_writer->finish();
-
-	dcp::DCP dcp(dcp_dir);
-	dcp.read();
-	DCPOMATIC_ASSERT(dcp.cpls().size() == 1);
-	for (auto reel: dcp.cpls()[0]->reels()) {
-		for (auto ccap: reel->closed_captions()) {
-			if (ccap->asset() && ccap->asset()->xml_as_string().length() > static_cast<size_t>(MAX_CLOSED_CAPTION_XML_SIZE - SIZE_SLACK) && !ccap_xml_too_big) {
-				hint(_(
-						"At least one of your closed caption files' XML part is larger than " MAX_CLOSED_CAPTION_XML_SIZE_TEXT
-						".  You should divide the DCP into shorter reels."
-				       ));
-				ccap_xml_too_big = true;
-			}
-			if (subtitle_mxf_too_big(ccap->asset()) && !ccap_mxf_too_big) {
-				hint(_(
-						"At least one of your closed caption files is larger than " MAX_TEXT_MXF_SIZE_TEXT
-						" in total.  You should divide the DCP into shorter reels."
-				       ));
-				ccap_mxf_too_big = true;
-			}
-		}
-		if (reel->main_subtitle() && subtitle_mxf_too_big(reel->main_subtitle()->asset()) && !subs_mxf_too_big) {
-			hint(_(
-					"At least one of your subtitle files is larger than " MAX_TEXT_MXF_SIZE_TEXT " in total.  "
-					"You should divide the DCP into shorter reels."
-			       ));
-			subs_mxf_too_big = true;
-		}
+	scan_text(film);
+	if (_stop) {
+		return;
 	}
-	dcp::filesystem::remove_all(dcp_dir);
 
 	emit(boost::bind(boost::ref(Finished)));
 }
@@ -564,10 +756,8 @@ Hints::audio(shared_ptr<AudioBuffers> audio, DCPTime time)
 
 
 void
-Hints::text(PlayerText text, TextType type, optional<DCPTextTrack> track, DCPTimePeriod period)
+Hints::text(PlayerText text, TextType type, DCPTimePeriod period)
 {
-	_writer->write(text, type, track, period);
-
 	switch (type) {
 	case TextType::CLOSED_CAPTION:
 		closed_caption(text, period);
@@ -28,12 +28,14 @@
 #include "weak_film.h"
 #include <boost/atomic.hpp>
 #include <boost/signals2.hpp>
+#include <boost/thread/mutex.hpp>
+#include <map>
 #include <string>
 #include <vector>
 
 
+class Content;
 class Film;
-class Writer;
 
 
 class Hints : public Signaller, public ExceptionStore, public WeakConstFilm
@@ -54,15 +56,36 @@ public:
 	void disable_audio_analysis() {
 		_disable_audio_analysis = true;
 	}
+	/** @return number of pieces of content whose text had to be examined, rather than coming from the cache */
+	int text_scans() const {
+		return _text_scans;
+	}
 
 private:
 	friend struct hint_subtitle_too_early;
 
+	/** Some text that a Player emitted */
+	struct TextEvent
+	{
+		TextType type;
+		DCPTextTrack track;
+		dcpomatic::DCPTimePeriod period;
+		/** The text, with any bitmaps removed */
+		PlayerText text;
+		/** Total size of any bitmaps when they are written as PNG */
+		size_t png_size = 0;
+	};
+
+	typedef std::vector<TextEvent> TextEvents;
+
 	void thread();
-	void scan_content(std::shared_ptr<const Film> film);
+	void scan_audio(std::shared_ptr<const Film> film);
+	void scan_text(std::shared_ptr<const Film> film);
+	std::shared_ptr<const TextEvents> content_text(std::shared_ptr<const Film> film, std::shared_ptr<Content> content);
+	void check_text_sizes(std::shared_ptr<const Film> film, std::vector<TextEvent> const& events);
 	void hint(std::string h);
 	void audio(std::shared_ptr<AudioBuffers> audio, dcpomatic::DCPTime time);
-	void text(PlayerText text, TextType type, boost::optional<DCPTextTrack> track, dcpomatic::DCPTimePeriod period);
+	void text(PlayerText text, TextType type, dcpomatic::DCPTimePeriod period);
 	void closed_caption(PlayerText text, dcpomatic::DCPTimePeriod period);
 	void open_subtitle(PlayerText text, dcpomatic::DCPTimePeriod period);
 
@@ -89,11 +112,6 @@ private:
 	void check_video_alpha();
 
 	boost::thread _thread;
-	/** This is used to make a partial DCP containing only the subtitles and closed captions that
-	 *  our final DCP will have.  This means we can see how big the files will be and warn if they
-	 *  will be too big.
-	 */
-	std::shared_ptr<Writer> _writer;
 
 	AudioAnalyser _analyser;
 
@@ -113,4 +131,10 @@ private:
 	boost::atomic<bool> _stop;
 
 	bool _disable_audio_analysis = false;
+	int _text_scans = 0;
+
+	/** Mutex to protect _text_cache */
+	static boost::mutex _text_cache_mutex;
+	/** Text that has been found in content by previous scans, indexed by text_cache_key() */
+	static std::map<std::string, std::shared_ptr<const TextEvents>> _text_cache;
 };
@@ -27,12 +27,14 @@
 #include "compose.hpp"
 #include "dcpomatic_assert.h"
 #include "dcpomatic_socket.h"
-#include "enum_indexed_vector.h"
 #include "exceptions.h"
 #include "image.h"
+#include "image_pool.h"
 #include "maths_util.h"
-#include "memory_util.h"
 #include "rect.h"
+#include "slice_threads.h"
+#include "sws_context_cache.h"
+#include "target_clones.h"
 #include "timer.h"
 #include <dcp/rgb_xyz.h>
 #include <dcp/transfer_function.h>
@@ -48,6 +50,7 @@ LIBDCP_ENABLE_WARNINGS
 #if HAVE_VALGRIND_MEMCHECK_H
 #include <valgrind/memcheck.h>
 #endif
+#include <algorithm>
 #include <iostream>
 
 
@@ -61,7 +64,6 @@ using std::make_shared;
 using std::max;
 using std::min;
 using std::pair;
-using std::runtime_error;
 using std::shared_ptr;
 using std::string;
 using std::vector;
@@ -241,41 +243,6 @@ Image::crop_scale_window (
 	dcp::Size cropped_size;
 	std::tie(scale_in_data, cropped_size) = crop_source_pointers(crop);
 
-	/* Scale context for a scale from cropped_size to inter_size */
-	auto scale_context = sws_getContext (
-			cropped_size.width, cropped_size.height, pixel_format(),
-			inter_size.width, inter_size.height, out_format,
-			fast ? SWS_FAST_BILINEAR : SWS_BICUBIC, 0, 0, 0
-		);
-
-	if (!scale_context) {
-		throw runtime_error (N_("Could not allocate SwsContext"));
-	}
-
-	DCPOMATIC_ASSERT (yuv_to_rgb < dcp::YUVToRGB::COUNT);
-	EnumIndexedVector<int, dcp::YUVToRGB> lut;
-	lut[dcp::YUVToRGB::REC601] = SWS_CS_ITU601;
-	lut[dcp::YUVToRGB::REC709] = SWS_CS_ITU709;
-	lut[dcp::YUVToRGB::REC2020] = SWS_CS_BT2020;
-
-	/* The 3rd parameter here is:
-	   0 -> source range MPEG (i.e. "video", 16-235)
-	   1 -> source range JPEG (i.e. "full", 0-255)
-	   And the 5th:
-	   0 -> destination range MPEG (i.e. "video", 16-235)
-	   1 -> destination range JPEG (i.e. "full", 0-255)
-
-	   But remember: sws_setColorspaceDetails ignores these
-	   parameters unless the both source and destination images
-	   are isYUV or isGray.  (If either is not, it uses video range).
-	*/
-	sws_setColorspaceDetails (
-		scale_context,
-		sws_getCoefficients(lut[yuv_to_rgb]), video_range == VideoRange::VIDEO ? 0 : 1,
-		sws_getCoefficients(lut[yuv_to_rgb]), out_video_range == VideoRange::VIDEO ? 0 : 1,
-		0, 1 << 16, 1 << 16
-		);
-
 	auto out_desc = av_pix_fmt_desc_get (out_format);
 	if (!out_desc) {
 		throw PixelFormatError ("crop_scale_window()", out_format);
@@ -293,15 +260,21 @@ Image::crop_scale_window (
 		scale_out_data[c] = out->data()[c] + x + out->stride()[c] * (corner.y / out->vertical_factor(c));
 	}
 
-	sws_scale (
-		scale_context,
+	/* Scale from cropped_size to inter_size */
+	SwsContextCache::scale (
+		{
+			cropped_size, pixel_format(),
+			inter_size, out_format,
+			fast ? SWS_FAST_BILINEAR : SWS_BICUBIC,
+			yuv_to_rgb,
+			video_range == VideoRange::FULL,
+			out_video_range == VideoRange::FULL,
+			SliceThreads::instance()->threads()
+		},
 		scale_in_data.data(), stride(),
-		0, cropped_size.height,
 		scale_out_data, out->stride()
 		);
 
-	sws_freeContext (scale_context);
-
 	/* There are some cases where there will be unwanted image data left in the image at this point:
 	 *
 	 * 1. When we are cropping without any scaling or pixel format conversion.
@@ -354,47 +327,20 @@ Image::scale (dcp::Size out_size, dcp::YUVToRGB yuv_to_rgb, AVPixelFormat out_fo
 	DCPOMATIC_ASSERT(out_size.height > 0);
 
 	auto scaled = make_shared<Image>(out_format, out_size, out_alignment);
-	auto scale_context = sws_getContext (
-		size().width, size().height, pixel_format(),
-		out_size.width, out_size.height, out_format,
-		(fast ? SWS_FAST_BILINEAR : SWS_BICUBIC) | SWS_ACCURATE_RND, 0, 0, 0
-		);
-
-	DCPOMATIC_ASSERT(scale_context);
-
-	DCPOMATIC_ASSERT (yuv_to_rgb < dcp::YUVToRGB::COUNT);
-	EnumIndexedVector<int, dcp::YUVToRGB> lut;
-	lut[dcp::YUVToRGB::REC601] = SWS_CS_ITU601;
-	lut[dcp::YUVToRGB::REC709] = SWS_CS_ITU709;
-	lut[dcp::YUVToRGB::REC2020] = SWS_CS_BT2020;
-
-	/* The 3rd parameter here is:
-	   0 -> source range MPEG (i.e. "video", 16-235)
-	   1 -> source range JPEG (i.e. "full", 0-255)
-	   And the 5th:
-	   0 -> destination range MPEG (i.e. "video", 16-235)
-	   1 -> destination range JPEG (i.e. "full", 0-255)
-
-	   But remember: sws_setColorspaceDetails ignores these
-	   parameters unless the corresponding image isYUV or isGray.
-	   (If it's neither, it uses video range).
-	*/
-	sws_setColorspaceDetails (
-		scale_context,
-		sws_getCoefficients(lut[yuv_to_rgb]), 0,
-		sws_getCoefficients(lut[yuv_to_rgb]), 0,
-		0, 1 << 16, 1 << 16
-		);
-
-	sws_scale (
-		scale_context,
+	SwsContextCache::scale (
+		{
+			size(), pixel_format(),
+			out_size, out_format,
+			(fast ? SWS_FAST_BILINEAR : SWS_BICUBIC) | SWS_ACCURATE_RND,
+			yuv_to_rgb,
+			false,
+			false,
+			SliceThreads::instance()->threads()
+		},
 		data(), stride(),
-		0, size().height,
 		scaled->data(), scaled->stride()
 		);
 
-	sws_freeContext (scale_context);
-
 	return scaled;
 }
 
@@ -405,15 +351,11 @@ Image::yuv_16_black (uint16_t v, bool alpha)
 {
 	memset (data()[0], 0, sample_size(0).height * stride()[0]);
 	for (int i = 1; i < 3; ++i) {
-		auto p = reinterpret_cast<int16_t*> (data()[i]);
-		int const lines = sample_size(i).height;
-		for (int y = 0; y < lines; ++y) {
-			/* We divide by 2 here because we are writing 2 bytes at a time */
-			for (int x = 0; x < line_size()[i] / 2; ++x) {
-				p[x] = v;
-			}
-			p += stride()[i] / 2;
-		}
+		/* Fill the padding at the end of each line too, so that this is one long run
+		 * which the compiler can vectorise.  We divide by 2 here because we are writing
+		 * 2 bytes at a time.
+		 */
+		std::fill_n(reinterpret_cast<uint16_t*>(data()[i]), sample_size(i).height * stride()[i] / 2, v);
 	}
 
 	if (alpha) {
@@ -665,15 +607,10 @@ struct OtherRGBParams
 	dcp::Size size;
 	uint8_t* const* data;
 	int const* stride;
-	int bpp;
 
 	uint8_t* line_pointer(int y) const {
 		return data[0] + y * stride[0];
 	}
-
-	float alpha_divisor() const {
-		return pow(2, bpp * 2) - 1;
-	}
 };
 
 
@@ -688,271 +625,275 @@ struct OtherYUVParams
 
 	uint8_t* const* alpha_data;
 	int const* alpha_stride;
-	int alpha_bpp;
 };
 
 
-template <class OtherType>
-void
-alpha_blend_onto_rgb24(TargetParams const& target, OtherRGBParams const& other, int red, int blue, std::function<float (OtherType*)> get, int value_divisor)
+/** Description of a BGRA image being blended onto something */
+struct BGRASource
 {
-	/* Going onto RGB24.  First byte is red, second green, third blue */
-	auto const alpha_divisor = other.alpha_divisor();
-	for (int ty = target.start_y, oy = other.start_y; ty < target.size.height && oy < other.size.height; ++ty, ++oy) {
-		auto tp = target.line_pointer(ty);
-		auto op = reinterpret_cast<OtherType*>(other.line_pointer(oy));
-		for (int tx = target.start_x, ox = other.start_x; tx < target.size.width && ox < other.size.width; ++tx, ++ox) {
-			float const alpha = get(op + 3) / alpha_divisor;
-			tp[0] = (get(op + red) / value_divisor) * alpha + tp[0] * (1 - alpha);
-			tp[1] = (get(op + 1) / value_divisor) * alpha + tp[1] * (1 - alpha);
-			tp[2] = (get(op + blue) / value_divisor) * alpha + tp[2] * (1 - alpha);
-
-			tp += target.bpp;
-			op += other.bpp / sizeof(OtherType);
-		}
+	using Type = uint8_t;
+	static constexpr int bytes_per_pixel = 4;
+	static constexpr int red = 2;
+	static constexpr int blue = 0;
+	/** amount to divide values by to get 8-bit values */
+	static constexpr int divisor_to_8_bit = 1;
+	/** amount to multiply values by to get 16-bit values */
+	static constexpr int scale_to_16_bit = 256;
+
+	static float get(Type const* p) {
+		return *p;
+	}
+
+	static float alpha(uint8_t const* pixel) {
+		return pixel[3] / 255.0f;
+	}
+
+	static bool transparent(uint8_t const* pixel) {
+		return pixel[3] == 0;
+	}
+};
+
+
+/** Description of an RGBA image being blended onto something */
+struct RGBASource : public BGRASource
+{
+	static constexpr int red = 0;
+	static constexpr int blue = 2;
+};
+
+
+/** Description of an RGBA64BE image being blended onto something */
+struct RGBA64BESource
+{
+	using Type = uint16_t;
+	static constexpr int bytes_per_pixel = 8;
+	static constexpr int red = 0;
+	static constexpr int blue = 2;
+	/** amount to divide values by to get 8-bit values */
+	static constexpr int divisor_to_8_bit = 256;
+	/** amount to multiply values by to get 16-bit values */
+	static constexpr int scale_to_16_bit = 1;
+
+	static float get(Type const* p) {
+		return (*p >> 8) | ((*p & 0xff) << 8);
+	}
+
+	static float alpha(uint8_t const* pixel) {
+		return ((pixel[6] << 8) | pixel[7]) / 65535.0f;
+	}
+
+	static bool transparent(uint8_t const* pixel) {
+		return pixel[6] == 0 && pixel[7] == 0;
 	}
+};
+
+
+/** Find the part of a line of a Source image which is not completely transparent.
+ *  @param line First pixel to look at.
+ *  @param width Number of pixels to look at.
+ *  @return Index of the first non-transparent pixel and one past the last; these are
+ *  the same if the whole line is transparent.
+ */
+template <class Source>
+pair<int, int>
+visible_span(uint8_t const* line, int width)
+{
+	int first = 0;
+	while (first < width && Source::transparent(line + first * Source::bytes_per_pixel)) {
+		++first;
+	}
+
+	int last = width;
+	while (last > first && Source::transparent(line + (last - 1) * Source::bytes_per_pixel)) {
+		--last;
+	}
+
+	return { first, last };
 }
 
 
-template <class OtherType>
+/** Blend a Source image onto some RGB-ish target, skipping any parts of the source which are
+ *  completely transparent (since blending those would leave the target unchanged).
+ *  @param blend Function to blend one pixel; it is passed pointers to the target and source pixels.
+ */
+template <class Source, class TargetType, int target_bpp, class Blend>
+DCPOMATIC_TARGET_CLONES
 void
-alpha_blend_onto_bgra(TargetParams const& target, OtherRGBParams const& other, int red, int blue, std::function<float (OtherType*)> get, int value_divisor)
-{
-	auto const alpha_divisor = other.alpha_divisor();
-	for (int ty = target.start_y, oy = other.start_y; ty < target.size.height && oy < other.size.height; ++ty, ++oy) {
-		auto tp = target.line_pointer(ty);
-		auto op = reinterpret_cast<OtherType*>(other.line_pointer(oy));
-		for (int tx = target.start_x, ox = other.start_x; tx < target.size.width && ox < other.size.width; ++tx, ++ox) {
-			float const alpha = get(op + 3) / alpha_divisor;
-			tp[0] = (get(op + blue) / value_divisor) * alpha + tp[0] * (1 - alpha);
-			tp[1] = (get(op + 1) / value_divisor) * alpha + tp[1] * (1 - alpha);
-			tp[2] = (get(op + red) / value_divisor) * alpha + tp[2] * (1 - alpha);
-			tp[3] = (get(op + 3) / value_divisor) * alpha + tp[3] * (1 - alpha);
-
-			tp += target.bpp;
-			op += other.bpp / sizeof(OtherType);
+alpha_blend_onto_rgb(TargetParams const& target, OtherRGBParams const& other, Blend blend)
+{
+	using SourceType = typename Source::Type;
+
+	int const width = min(target.size.width - target.start_x, other.size.width - other.start_x);
+	int const height = min(target.size.height - target.start_y, other.size.height - other.start_y);
+
+	for (int y = 0; y < height; ++y) {
+		auto const other_line = other.line_pointer(other.start_y + y);
+		auto const span = visible_span<Source>(other_line, width);
+		auto tp = reinterpret_cast<TargetType*>(target.line_pointer(target.start_y + y) + span.first * target_bpp);
+		auto op = reinterpret_cast<SourceType const*>(other_line + span.first * Source::bytes_per_pixel);
+		for (int x = span.first; x < span.second; ++x) {
+			blend(tp, op);
+			tp += target_bpp / sizeof(TargetType);
+			op += Source::bytes_per_pixel / sizeof(SourceType);
 		}
 	}
 }
 
 
-template <class OtherType>
+template <class Source>
 void
-alpha_blend_onto_rgba(TargetParams const& target, OtherRGBParams const& other, int red, int blue, std::function<float (OtherType*)> get, int value_divisor)
-{
-	auto const alpha_divisor = other.alpha_divisor();
-	for (int ty = target.start_y, oy = other.start_y; ty < target.size.height && oy < other.size.height; ++ty, ++oy) {
-		auto tp = target.line_pointer(ty);
-		auto op = reinterpret_cast<OtherType*>(other.line_pointer(oy));
-		for (int tx = target.start_x, ox = other.start_x; tx < target.size.width && ox < other.size.width; ++tx, ++ox) {
-			float const alpha = get(op + 3) / alpha_divisor;
-			tp[0] = (get(op + red) / value_divisor) * alpha + tp[0] * (1 - alpha);
-			tp[1] = (get(op + 1) / value_divisor) * alpha + tp[1] * (1 - alpha);
-			tp[2] = (get(op + blue) / value_divisor) * alpha + tp[2] * (1 - alpha);
-			tp[3] = (get(op + 3) / value_divisor) * alpha + tp[3] * (1 - alpha);
-
-			tp += target.bpp;
-			op += other.bpp / sizeof(OtherType);
-		}
-	}
+alpha_blend_onto_rgb24(TargetParams const& target, OtherRGBParams const& other)
+{
+	/* Going onto RGB24.  First byte is red, second green, third blue */
+	alpha_blend_onto_rgb<Source, uint8_t, 3>(target, other, [](uint8_t* tp, typename Source::Type const* op) {
+		float const alpha = Source::alpha(reinterpret_cast<uint8_t const*>(op));
+		tp[0] = (Source::get(op + Source::red) / Source::divisor_to_8_bit) * alpha + tp[0] * (1 - alpha);
+		tp[1] = (Source::get(op + 1) / Source::divisor_to_8_bit) * alpha + tp[1] * (1 - alpha);
+		tp[2] = (Source::get(op + Source::blue) / Source::divisor_to_8_bit) * alpha + tp[2] * (1 - alpha);
+	});
 }
 
 
-template <class OtherType>
+template <class Source>
 void
-alpha_blend_onto_rgb48le(TargetParams const& target, OtherRGBParams const& other, int red, int blue, std::function<float (OtherType*)> get, int value_scale)
-{
-	auto const alpha_divisor = other.alpha_divisor();
-	for (int ty = target.start_y, oy = other.start_y; ty < target.size.height && oy < other.size.height; ++ty, ++oy) {
-		auto tp = reinterpret_cast<uint16_t*>(target.line_pointer(ty));
-		auto op = reinterpret_cast<OtherType*>(other.line_pointer(oy));
-		for (int tx = target.start_x, ox = other.start_x; tx < target.size.width && ox < other.size.width; ++tx, ++ox) {
-			float const alpha = get(op + 3) / alpha_divisor;
-			tp[0] = get(op + red) * value_scale * alpha + tp[0] * (1 - alpha);
-			tp[1] = get(op + 1) * value_scale * alpha + tp[1] * (1 - alpha);
-			tp[2] = get(op + blue) * value_scale * alpha + tp[2] * (1 - alpha);
-
-			tp += target.bpp / 2;
-			op += other.bpp / sizeof(OtherType);
-		}
-	}
+alpha_blend_onto_bgra(TargetParams const& target, OtherRGBParams const& other)
+{
+	alpha_blend_onto_rgb<Source, uint8_t, 4>(target, other, [](uint8_t* tp, typename Source::Type const* op) {
+		float const alpha = Source::alpha(reinterpret_cast<uint8_t const*>(op));
+		tp[0] = (Source::get(op + Source::blue) / Source::divisor_to_8_bit) * alpha + tp[0] * (1 - alpha);
+		tp[1] = (Source::get(op + 1) / Source::divisor_to_8_bit) * alpha + tp[1] * (1 - alpha);
+		tp[2] = (Source::get(op + Source::red) / Source::divisor_to_8_bit) * alpha + tp[2] * (1 - alpha);
+		tp[3] = (Source::get(op + 3) / Source::divisor_to_8_bit) * alpha + tp[3] * (1 - alpha);
+	});
+}
+
+
+template <class Source>
+void
+alpha_blend_onto_rgba(TargetParams const& target, OtherRGBParams const& other)
+{
+	alpha_blend_onto_rgb<Source, uint8_t, 4>(target, other, [](uint8_t* tp, typename Source::Type const* op) {
+		float const alpha = Source::alpha(reinterpret_cast<uint8_t const*>(op));
+		tp[0] = (Source::get(op + Source::red) / Source::divisor_to_8_bit) * alpha + tp[0] * (1 - alpha);
+		tp[1] = (Source::get(op + 1) / Source::divisor_to_8_bit) * alpha + tp[1] * (1 - alpha);
+		tp[2] = (Source::get(op + Source::blue) / Source::divisor_to_8_bit) * alpha + tp[2] * (1 - alpha);
+		tp[3] = (Source::get(op + 3) / Source::divisor_to_8_bit) * alpha + tp[3] * (1 - alpha);
+	});
+}
+
+
+template <class Source>
+void
+alpha_blend_onto_rgb48le(TargetParams const& target, OtherRGBParams const& other)
+{
+	alpha_blend_onto_rgb<Source, uint16_t, 6>(target, other, [](uint16_t* tp, typename Source::Type const* op) {
+		float const alpha = Source::alpha(reinterpret_cast<uint8_t const*>(op));
+		tp[0] = Source::get(op + Source::red) * Source::scale_to_16_bit * alpha + tp[0] * (1 - alpha);
+		tp[1] = Source::get(op + 1) * Source::scale_to_16_bit * alpha + tp[1] * (1 - alpha);
+		tp[2] = Source::get(op + Source::blue) * Source::scale_to_16_bit * alpha + tp[2] * (1 - alpha);
+	});
 }
 
 
-template <class OtherType>
+template <class Source>
 void
-alpha_blend_onto_xyz12le(TargetParams const& target, OtherRGBParams const& other, int red, int blue, std::function<float (OtherType*)> get, int value_divisor)
+alpha_blend_onto_xyz12le(TargetParams const& target, OtherRGBParams const& other)
 {
-	auto const alpha_divisor = other.alpha_divisor();
 	auto conv = dcp::ColourConversion::srgb_to_xyz();
 	double fast_matrix[9];
 	dcp::combined_rgb_to_xyz(conv, fast_matrix);
 	auto lut_in = conv.in()->double_lut(0, 1, 8, false);
 	auto lut_out = conv.out()->int_lut(0, 1, 16, true, 65535);
-	for (int ty = target.start_y, oy = other.start_y; ty < target.size.height && oy < other.size.height; ++ty, ++oy) {
-		auto tp = reinterpret_cast<uint16_t*>(target.data[0] + ty * target.stride[0] + target.start_x * target.bpp);
-		auto op = reinterpret_cast<OtherType*>(other.data[0] + oy * other.stride[0]);
-		for (int tx = target.start_x, ox = other.start_x; tx < target.size.width && ox < other.size.width; ++tx, ++ox) {
-			float const alpha = get(op + 3) / alpha_divisor;
-
-			/* Convert sRGB to XYZ; op is BGRA.  First, input gamma LUT */
-			double const r = lut_in[get(op + red) / value_divisor];
-			double const g = lut_in[get(op + 1) / value_divisor];
-			double const b = lut_in[get(op + blue) / value_divisor];
-
-			/* RGB to XYZ, including Bradford transform and DCI companding */
-			double const x = max(0.0, min(1.0, r * fast_matrix[0] + g * fast_matrix[1] + b * fast_matrix[2]));
-			double const y = max(0.0, min(1.0, r * fast_matrix[3] + g * fast_matrix[4] + b * fast_matrix[5]));
-			double const z = max(0.0, min(1.0, r * fast_matrix[6] + g * fast_matrix[7] + b * fast_matrix[8]));
-
-			/* Out gamma LUT and blend */
-			tp[0] = lut_out[lrint(x * 65535)] * alpha + tp[0] * (1 - alpha);
-			tp[1] = lut_out[lrint(y * 65535)] * alpha + tp[1] * (1 - alpha);
-			tp[2] = lut_out[lrint(z * 65535)] * alpha + tp[2] * (1 - alpha);
-
-			tp += target.bpp / 2;
-			op += other.bpp / sizeof(OtherType);
-		}
-	}
-}
 
+	alpha_blend_onto_rgb<Source, uint16_t, 6>(target, other, [&](uint16_t* tp, typename Source::Type const* op) {
+		float const alpha = Source::alpha(reinterpret_cast<uint8_t const*>(op));
 
-static
-void
-alpha_blend_onto_yuv420p(TargetParams const& target, OtherYUVParams const& other, std::function<float (uint8_t* data)> get_alpha)
-{
-	auto const ts = target.size;
-	auto const os = other.size;
-	for (int ty = target.start_y, oy = other.start_y; ty < ts.height && oy < os.height; ++ty, ++oy) {
-		int const hty = ty / 2;
-		int const hoy = oy / 2;
-		uint8_t* tY = target.data[0] + (ty * target.stride[0]) + target.start_x;
-		uint8_t* tU = target.data[1] + (hty * target.stride[1]) + target.start_x / 2;
-		uint8_t* tV = target.data[2] + (hty * target.stride[2]) + target.start_x / 2;
-		uint8_t* oY = other.data[0] + (oy * other.stride[0]) + other.start_x;
-		uint8_t* oU = other.data[1] + (hoy * other.stride[1]) + other.start_x / 2;
-		uint8_t* oV = other.data[2] + (hoy * other.stride[2]) + other.start_x / 2;
-		uint8_t* alpha = other.alpha_data[0] + (oy * other.alpha_stride[0]) + other.start_x * other.alpha_bpp;
-		for (int tx = target.start_x, ox = other.start_x; tx < ts.width && ox < os.width; ++tx, ++ox) {
-			float const a = get_alpha(alpha);
-			*tY = *oY * a + *tY * (1 - a);
-			*tU = *oU * a + *tU * (1 - a);
-			*tV = *oV * a + *tV * (1 - a);
-			++tY;
-			++oY;
-			if (tx % 2) {
-				++tU;
-				++tV;
-			}
-			if (ox % 2) {
-				++oU;
-				++oV;
-			}
-			alpha += other.alpha_bpp;
-		}
-	}
+		/* Convert sRGB to XYZ.  First, input gamma LUT */
+		double const r = lut_in[Source::get(op + Source::red) / Source::divisor_to_8_bit];
+		double const g = lut_in[Source::get(op + 1) / Source::divisor_to_8_bit];
+		double const b = lut_in[Source::get(op + Source::blue) / Source::divisor_to_8_bit];
+
+		/* RGB to XYZ, including Bradford transform and DCI companding */
+		double const x = max(0.0, min(1.0, r * fast_matrix[0] + g * fast_matrix[1] + b * fast_matrix[2]));
+		double const y = max(0.0, min(1.0, r * fast_matrix[3] + g * fast_matrix[4] + b * fast_matrix[5]));
+		double const z = max(0.0, min(1.0, r * fast_matrix[6] + g * fast_matrix[7] + b * fast_matrix[8]));
+
+		/* Out gamma LUT and blend */
+		tp[0] = lut_out[lrint(x * 65535)] * alpha + tp[0] * (1 - alpha);
+		tp[1] = lut_out[lrint(y * 65535)] * alpha + tp[1] * (1 - alpha);
+		tp[2] = lut_out[lrint(z * 65535)] * alpha + tp[2] * (1 - alpha);
+	});
 }
 
 
-static
+/** Blend a Source image, which has been converted to the target's YUV format, onto the target.
+ *  Completely transparent parts of the source are skipped.
+ *  @param Sample Type of each sample in the target.
+ *  @param x_shift log2 of the horizontal chroma subsampling factor.
+ *  @param y_shift log2 of the vertical chroma subsampling factor.
+ */
+template <class Source, class Sample, int x_shift, int y_shift>
+DCPOMATIC_TARGET_CLONES
 void
-alpha_blend_onto_yuv420p10(TargetParams const& target, OtherYUVParams const& other, std::function<float (uint8_t* data)> get_alpha)
-{
-	auto const ts = target.size;
-	auto const os = other.size;
-	for (int ty = target.start_y, oy = other.start_y; ty < ts.height && oy < os.height; ++ty, ++oy) {
-		int const hty = ty / 2;
-		int const hoy = oy / 2;
-		uint16_t* tY = reinterpret_cast<uint16_t*>(target.data[0] + (ty * target.stride[0])) + target.start_x;
-		uint16_t* tU = reinterpret_cast<uint16_t*>(target.data[1] + (hty * target.stride[1])) + target.start_x / 2;
-		uint16_t* tV = reinterpret_cast<uint16_t*>(target.data[2] + (hty * target.stride[2])) + target.start_x / 2;
-		uint16_t* oY = reinterpret_cast<uint16_t*>(other.data[0] + (oy * other.stride[0])) + other.start_x;
-		uint16_t* oU = reinterpret_cast<uint16_t*>(other.data[1] + (hoy * other.stride[1])) + other.start_x / 2;
-		uint16_t* oV = reinterpret_cast<uint16_t*>(other.data[2] + (hoy * other.stride[2])) + other.start_x / 2;
-		uint8_t* alpha = other.alpha_data[0] + (oy * other.alpha_stride[0]) + other.start_x * other.alpha_bpp;
-		for (int tx = target.start_x, ox = other.start_x; tx < ts.width && ox < os.width; ++tx, ++ox) {
-			float const a = get_alpha(alpha);
-			*tY = *oY * a + *tY * (1 - a);
-			*tU = *oU * a + *tU * (1 - a);
-			*tV = *oV * a + *tV * (1 - a);
-			++tY;
-			++oY;
-			if (tx % 2) {
-				++tU;
-				++tV;
-			}
-			if (ox % 2) {
-				++oU;
-				++oV;
-			}
-			alpha += other.alpha_bpp;
+alpha_blend_onto_yuv(TargetParams const& target, OtherYUVParams const& other)
+{
+	int const width = min(target.size.width - target.start_x, other.size.width - other.start_x);
+	int const height = min(target.size.height - target.start_y, other.size.height - other.start_y);
+
+	for (int y = 0; y < height; ++y) {
+		int const ty = target.start_y + y;
+		int const oy = other.start_y + y;
+		uint8_t const* alpha = other.alpha_data[0] + (oy * other.alpha_stride[0]) + other.start_x * Source::bytes_per_pixel;
+		auto const span = visible_span<Source>(alpha, width);
+		if (span.first == span.second) {
+			continue;
 		}
-	}
-}
 
+		auto tY = reinterpret_cast<Sample*>(target.data[0] + (ty * target.stride[0]));
+		auto tU = reinterpret_cast<Sample*>(target.data[1] + ((ty >> y_shift) * target.stride[1]));
+		auto tV = reinterpret_cast<Sample*>(target.data[2] + ((ty >> y_shift) * target.stride[2]));
+		auto oY = reinterpret_cast<Sample const*>(other.data[0] + (oy * other.stride[0]));
+		auto oU = reinterpret_cast<Sample const*>(other.data[1] + ((oy >> y_shift) * other.stride[1]));
+		auto oV = reinterpret_cast<Sample const*>(other.data[2] + ((oy >> y_shift) * other.stride[2]));
+
+		/* Luma and chroma are done separately as, with subsampled chroma, one chroma sample is
+		 * blended more than once and that would stop the luma loop being vectorised.
+		 */
+		for (int x = span.first; x < span.second; ++x) {
+			int const tx = target.start_x + x;
+			int const ox = other.start_x + x;
+			float const a = Source::alpha(alpha + x * Source::bytes_per_pixel);
+			tY[tx] = oY[ox] * a + tY[tx] * (1 - a);
+		}
 
-static
-void
-alpha_blend_onto_yuv422p9or10le(TargetParams const& target, OtherYUVParams const& other, std::function<float (uint8_t* data)> get_alpha)
-{
-	auto const ts = target.size;
-	auto const os = other.size;
-	for (int ty = target.start_y, oy = other.start_y; ty < ts.height && oy < os.height; ++ty, ++oy) {
-		uint16_t* tY = reinterpret_cast<uint16_t*>(target.data[0] + (ty * target.stride[0])) + target.start_x;
-		uint16_t* tU = reinterpret_cast<uint16_t*>(target.data[1] + (ty * target.stride[1])) + target.start_x / 2;
-		uint16_t* tV = reinterpret_cast<uint16_t*>(target.data[2] + (ty * target.stride[2])) + target.start_x / 2;
-		uint16_t* oY = reinterpret_cast<uint16_t*>(other.data[0] + (oy * other.stride[0])) + other.start_x;
-		uint16_t* oU = reinterpret_cast<uint16_t*>(other.data[1] + (oy * other.stride[1])) + other.start_x / 2;
-		uint16_t* oV = reinterpret_cast<uint16_t*>(other.data[2] + (oy * other.stride[2])) + other.start_x / 2;
-		uint8_t* alpha = other.alpha_data[0] + (oy * other.alpha_stride[0]) + other.start_x * other.alpha_bpp;
-		for (int tx = target.start_x, ox = other.start_x; tx < ts.width && ox < os.width; ++tx, ++ox) {
-			float const a = get_alpha(alpha);
-			*tY = *oY * a + *tY * (1 - a);
-			*tU = *oU * a + *tU * (1 - a);
-			*tV = *oV * a + *tV * (1 - a);
-			++tY;
-			++oY;
-			if (tx % 2) {
-				++tU;
-				++tV;
-			}
-			if (ox % 2) {
-				++oU;
-				++oV;
-			}
-			alpha += other.alpha_bpp;
+		for (int x = span.first; x < span.second; ++x) {
+			int const tx = target.start_x + x;
+			int const ox = other.start_x + x;
+			float const a = Source::alpha(alpha + x * Source::bytes_per_pixel);
+			tU[tx >> x_shift] = oU[ox >> x_shift] * a + tU[tx >> x_shift] * (1 - a);
+			tV[tx >> x_shift] = oV[ox >> x_shift] * a + tV[tx >> x_shift] * (1 - a);
 		}
 	}
 }
 
 
-static
+/** Call a blending function with a description of the pixel format of the other image */
+template <class Blend>
 void
-alpha_blend_onto_yuv444p9or10le(TargetParams const& target, OtherYUVParams const& other, std::function<float (uint8_t* data)> get_alpha)
-{
-	auto const ts = target.size;
-	auto const os = other.size;
-	for (int ty = target.start_y, oy = other.start_y; ty < ts.height && oy < os.height; ++ty, ++oy) {
-		uint16_t* tY = reinterpret_cast<uint16_t*>(target.data[0] + (ty * target.stride[0])) + target.start_x;
-		uint16_t* tU = reinterpret_cast<uint16_t*>(target.data[1] + (ty * target.stride[1])) + target.start_x;
-		uint16_t* tV = reinterpret_cast<uint16_t*>(target.data[2] + (ty * target.stride[2])) + target.start_x;
-		uint16_t* oY = reinterpret_cast<uint16_t*>(other.data[0] + (oy * other.stride[0])) + other.start_x;
-		uint16_t* oU = reinterpret_cast<uint16_t*>(other.data[1] + (oy * other.stride[1])) + other.start_x;
-		uint16_t* oV = reinterpret_cast<uint16_t*>(other.data[2] + (oy * other.stride[2])) + other.start_x;
-		uint8_t* alpha = other.alpha_data[0] + (oy * other.alpha_stride[0]) + other.start_x * other.alpha_bpp;
-		for (int tx = target.start_x, ox = other.start_x; tx < ts.width && ox < os.width; ++tx, ++ox) {
-			float const a = get_alpha(alpha);
-			*tY = *oY * a + *tY * (1 - a);
-			*tU = *oU * a + *tU * (1 - a);
-			*tV = *oV * a + *tV * (1 - a);
-			++tY;
-			++oY;
-			++tU;
-			++tV;
-			++oU;
-			++oV;
-			alpha += other.alpha_bpp;
-		}
+with_source(AVPixelFormat other_format, Blend blend)
+{
+	switch (other_format) {
+	case AV_PIX_FMT_BGRA:
+		blend(BGRASource());
+		break;
+	case AV_PIX_FMT_RGBA:
+		blend(RGBASource());
+		break;
+	case AV_PIX_FMT_RGBA64BE:
+		blend(RGBA64BESource());
+		break;
+	default:
+		DCPOMATIC_ASSERT(false);
 	}
 }
 
@@ -966,9 +907,6 @@ Image::alpha_blend (shared_ptr<const Image> other, Position<int> position)
 		other->pixel_format() == AV_PIX_FMT_RGBA64BE
 		);
 
-	int const blue = other->pixel_format() == AV_PIX_FMT_BGRA ? 0 : 2;
-	int const red = other->pixel_format() == AV_PIX_FMT_BGRA ? 2 : 0;
-
 	int start_tx = position.x;
 	int start_ox = 0;
 
@@ -999,8 +937,7 @@ Image::alpha_blend (shared_ptr<const Image> other, Position<int> position)
 		start_oy,
 		other->size(),
 		other->data(),
-		other->stride(),
-		other->pixel_format() == AV_PIX_FMT_RGBA64BE ? 8 : 4
+		other->stride()
 	};
 
 	OtherYUVParams other_yuv_params = {
@@ -1009,124 +946,67 @@ Image::alpha_blend (shared_ptr<const Image> other, Position<int> position)
 		other->size(),
 		other->data(),
 		other->stride(),
-		nullptr,
-		nullptr,
-		other->pixel_format() == AV_PIX_FMT_RGBA64BE ? 8 : 4
-	};
-
-	auto byteswap = [](uint16_t* p) {
-		return (*p >> 8) | ((*p & 0xff) << 8);
-	};
-
-	auto pass = [](uint8_t* p) {
-		return *p;
+		other->data(),
+		other->stride()
 	};
 
-	auto get_alpha_64be = [](uint8_t* p) {
-		return ((static_cast<int16_t>(p[6]) << 8) | p[7]) / 65535.0f;
-	};
+	auto const other_format = other->pixel_format();
 
-	auto get_alpha_byte = [](uint8_t* p) {
-		return p[3] / 255.0f;
+	/* The YUV versions blend a copy of the other image which has been converted to our format,
+	 * taking alpha from the original.
+	 */
+	auto convert_other = [this, other, &other_yuv_params]() {
+		auto yuv = other->convert_pixel_format (dcp::YUVToRGB::REC709, _pixel_format, Alignment::COMPACT, false);
+		other_yuv_params.data = yuv->data();
+		other_yuv_params.stride = yuv->stride();
+		return yuv;
 	};
 
 	switch (_pixel_format) {
 	case AV_PIX_FMT_RGB24:
 		target_params.bpp = 3;
-		if (other->pixel_format() == AV_PIX_FMT_RGBA64BE) {
-			alpha_blend_onto_rgb24<uint16_t>(target_params, other_rgb_params, red, blue, byteswap, 256);
-		} else {
-			alpha_blend_onto_rgb24<uint8_t>(target_params, other_rgb_params, red, blue, pass, 1);
-		}
+		with_source(other_format, [&](auto source) { alpha_blend_onto_rgb24<decltype(source)>(target_params, other_rgb_params); });
 		break;
 	case AV_PIX_FMT_BGRA:
 		target_params.bpp = 4;
-		if (other->pixel_format() == AV_PIX_FMT_RGBA64BE) {
-			alpha_blend_onto_bgra<uint16_t>(target_params, other_rgb_params, red, blue, byteswap, 256);
-		} else {
-			alpha_blend_onto_bgra<uint8_t>(target_params, other_rgb_params, red, blue, pass, 1);
-		}
+		with_source(other_format, [&](auto source) { alpha_blend_onto_bgra<decltype(source)>(target_params, other_rgb_params); });
 		break;
 	case AV_PIX_FMT_RGBA:
 		target_params.bpp = 4;
-		if (other->pixel_format() == AV_PIX_FMT_RGBA64BE) {
-			alpha_blend_onto_rgba<uint16_t>(target_params, other_rgb_params, red, blue, byteswap, 256);
-		} else {
-			alpha_blend_onto_rgba<uint8_t>(target_params, other_rgb_params, red, blue, pass, 1);
-		}
+		with_source(other_format, [&](auto source) { alpha_blend_onto_rgba<decltype(source)>(target_params, other_rgb_params); });
 		break;
 	case AV_PIX_FMT_RGB48LE:
 		target_params.bpp = 6;
-		if (other->pixel_format() == AV_PIX_FMT_RGBA64BE) {
-			alpha_blend_onto_rgb48le<uint16_t>(target_params, other_rgb_params, red, blue, byteswap, 1);
-		} else {
-			alpha_blend_onto_rgb48le<uint8_t>(target_params, other_rgb_params, red, blue, pass, 256);
-		}
+		with_source(other_format, [&](auto source) { alpha_blend_onto_rgb48le<decltype(source)>(target_params, other_rgb_params); });
 		break;
 	case AV_PIX_FMT_XYZ12LE:
 		target_params.bpp = 6;
-		if (other->pixel_format() == AV_PIX_FMT_RGBA64BE) {
-			alpha_blend_onto_xyz12le<uint16_t>(target_params, other_rgb_params, red, blue, byteswap, 256);
-		} else {
-			alpha_blend_onto_xyz12le<uint8_t>(target_params, other_rgb_params, red, blue, pass, 1);
-		}
+		with_source(other_format, [&](auto source) { alpha_blend_onto_xyz12le<decltype(source)>(target_params, other_rgb_params); });
 		break;
 	case AV_PIX_FMT_YUV420P:
 	{
-		auto yuv = other->convert_pixel_format (dcp::YUVToRGB::REC709, _pixel_format, Alignment::COMPACT, false);
-		other_yuv_params.data = yuv->data();
-		other_yuv_params.stride = yuv->stride();
-		other_yuv_params.alpha_data = other->data();
-		other_yuv_params.alpha_stride = other->stride();
-		if (other->pixel_format() == AV_PIX_FMT_RGBA64BE) {
-			alpha_blend_onto_yuv420p(target_params, other_yuv_params, get_alpha_64be);
-		} else {
-			alpha_blend_onto_yuv420p(target_params, other_yuv_params, get_alpha_byte);
-		}
+		auto yuv = convert_other();
+		with_source(other_format, [&](auto source) { alpha_blend_onto_yuv<decltype(source), uint8_t, 1, 1>(target_params, other_yuv_params); });
 		break;
 	}
 	case AV_PIX_FMT_YUV420P10:
 	{
-		auto yuv = other->convert_pixel_format (dcp::YUVToRGB::REC709, _pixel_format, Alignment::COMPACT, false);
-		other_yuv_params.data = yuv->data();
-		other_yuv_params.stride = yuv->stride();
-		other_yuv_params.alpha_data = other->data();
-		other_yuv_params.alpha_stride = other->stride();
-		if (other->pixel_format() == AV_PIX_FMT_RGBA64BE) {
-			alpha_blend_onto_yuv420p10(target_params, other_yuv_params, get_alpha_64be);
-		} else {
-			alpha_blend_onto_yuv420p10(target_params, other_yuv_params, get_alpha_byte);
-		}
+		auto yuv = convert_other();
+		with_source(other_format, [&](auto source) { alpha_blend_onto_yuv<decltype(source), uint16_t, 1, 1>(target_params, other_yuv_params); });
 		break;
 	}
 	case AV_PIX_FMT_YUV422P9LE:
 	case AV_PIX_FMT_YUV422P10LE:
 	{
-		auto yuv = other->convert_pixel_format (dcp::YUVToRGB::REC709, _pixel_format, Alignment::COMPACT, false);
-		other_yuv_params.data = yuv->data();
-		other_yuv_params.stride = yuv->stride();
-		other_yuv_params.alpha_data = other->data();
-		other_yuv_params.alpha_stride = other->stride();
-		if (other->pixel_format() == AV_PIX_FMT_RGBA64BE) {
-			alpha_blend_onto_yuv422p9or10le(target_params, other_yuv_params, get_alpha_64be);
-		} else {
-			alpha_blend_onto_yuv422p9or10le(target_params, other_yuv_params, get_alpha_byte);
-		}
+		auto yuv = convert_other();
+		with_source(other_format, [&](auto source) { alpha_blend_onto_yuv<decltype(source), uint16_t, 1, 0>(target_params, other_yuv_params); });
 		break;
 	}
 	case AV_PIX_FMT_YUV444P9LE:
 	case AV_PIX_FMT_YUV444P10LE:
 	{
-		auto yuv = other->convert_pixel_format (dcp::YUVToRGB::REC709, _pixel_format, Alignment::COMPACT, false);
-		other_yuv_params.data = yuv->data();
-		other_yuv_params.stride = yuv->stride();
-		other_yuv_params.alpha_data = other->data();
-		other_yuv_params.alpha_stride = other->stride();
-		if (other->pixel_format() == AV_PIX_FMT_RGBA64BE) {
-			alpha_blend_onto_yuv444p9or10le(target_params, other_yuv_params, get_alpha_64be);
-		} else {
-			alpha_blend_onto_yuv444p9or10le(target_params, other_yuv_params, get_alpha_byte);
-		}
+		auto yuv = convert_other();
+		with_source(other_format, [&](auto source) { alpha_blend_onto_yuv<decltype(source), uint16_t, 0, 0>(target_params, other_yuv_params); });
 		break;
 	}
 	default:
@@ -1245,13 +1125,8 @@ Image::Image (AVPixelFormat p, dcp::Size s, Alignment alignment)
 void
 Image::allocate ()
 {
-	_data = (uint8_t **) wrapped_av_malloc (4 * sizeof (uint8_t *));
 	_data[0] = _data[1] = _data[2] = _data[3] = 0;
-
-	_line_size = (int *) wrapped_av_malloc (4 * sizeof (int));
 	_line_size[0] = _line_size[1] = _line_size[2] = _line_size[3] = 0;
-
-	_stride = (int *) wrapped_av_malloc (4 * sizeof (int));
 	_stride[0] = _stride[1] = _stride[2] = _stride[3] = 0;
 
 	auto stride_round_up = [](int stride, int t) {
@@ -1300,17 +1175,25 @@ Image::allocate ()
 		   |XXXwrittenXXX|<------line-size------------->|XXXwrittenXXXXXXwrittenXXX
 		                                                               ^^^^ out of bounds
 		*/
-		_data[i] = (uint8_t *) wrapped_av_malloc (_stride[i] * (sample_size(i).height + 1) + ALIGNMENT);
+		_data[i] = ImagePool::instance()->get(allocation_size(i));
 #if HAVE_VALGRIND_MEMCHECK_H
 		/* The data between the end of the line size and the stride is undefined but processed by
 		   libswscale, causing lots of valgrind errors.  Mark it all defined to quell these errors.
 		*/
-		VALGRIND_MAKE_MEM_DEFINED (_data[i], _stride[i] * (sample_size(i).height + 1) + ALIGNMENT);
+		VALGRIND_MAKE_MEM_DEFINED (_data[i], allocation_size(i));
 #endif
 	}
 }
 
 
+/** @return number of bytes that allocate() gets for a plane; see the comment there for why */
+size_t
+Image::allocation_size (int plane) const
+{
+	return _stride[plane] * (sample_size(plane).height + 1) + ALIGNMENT;
+}
+
+
 Image::Image (Image const & other)
 	: std::enable_shared_from_this<Image>(other)
 	, _size (other._size)
@@ -1408,12 +1291,8 @@ Image::swap (Image & other)
 Image::~Image ()
 {
 	for (int i = 0; i < planes(); ++i) {
-		av_free (_data[i]);
+		ImagePool::instance()->put(_data[i], allocation_size(i));
 	}
-
-	av_free (_data);
-	av_free (_line_size);
-	av_free (_stride);
 }
 
 
@@ -1508,6 +1387,107 @@ operator== (Image const & a, Image const & b)
 }
 
 
+/** Split this image into horizontal bands and call a task for each plane of each band,
+ *  possibly running the bands in parallel.
+ *  @param task Task to run, which is passed the plane index and the first line of the band
+ *  within that plane and the line after its last.
+ */
+void
+Image::for_each_band(std::function<void (int plane, int start, int end)> task)
+{
+	int alignment = 1;
+	for (int c = 0; c < planes(); ++c) {
+		alignment = max(alignment, vertical_factor(c));
+	}
+
+	int const height = size().height;
+	SliceThreads::instance()->run(height, alignment, [this, task, height](int start, int end) {
+		for (int c = 0; c < planes(); ++c) {
+			auto const factor = vertical_factor(c);
+			task(c, start / factor, end == height ? sample_size(c).height : end / factor);
+		}
+	});
+}
+
+
+/** Round to the nearest integer, with ties going to the even one, which is what lrintf()
+ *  does in the default rounding mode.  Unlike lrintf() this can be vectorised.
+ *  Only valid for |x| < 2^22.
+ */
+static inline float
+round_to_nearest(float x)
+{
+	/* 1.5 * 2^23; adding this leaves no bits for anything after the point */
+	float constexpr magic = 12582912.0f;
+	return (x + magic) - magic;
+}
+
+
+DCPOMATIC_TARGET_CLONES
+static void
+fade_line_8(uint8_t* p, int samples, float f)
+{
+	for (int i = 0; i < samples; ++i) {
+		p[i] = int(float(p[i]) * f);
+	}
+}
+
+
+DCPOMATIC_TARGET_CLONES
+static void
+fade_line_16(uint16_t* p, int samples, float f)
+{
+	for (int i = 0; i < samples; ++i) {
+		p[i] = int(float(p[i]) * f);
+	}
+}
+
+
+/** Fade a line of chroma samples towards a given black value */
+DCPOMATIC_TARGET_CLONES
+static void
+fade_chroma_line_8(uint8_t* p, int samples, float f, int black)
+{
+	for (int i = 0; i < samples; ++i) {
+		p[i] = black + int((int(p[i]) - black) * f);
+	}
+}
+
+
+/** Fade a line of chroma samples towards a given black value */
+DCPOMATIC_TARGET_CLONES
+static void
+fade_chroma_line_16(uint16_t* p, int samples, float f, int black)
+{
+	for (int i = 0; i < samples; ++i) {
+		p[i] = black + int((int(p[i]) - black) * f);
+	}
+}
+
+
+DCPOMATIC_TARGET_CLONES
+static void
+video_range_to_full_range_line_8(uint8_t* p, int samples, float factor)
+{
+	for (int i = 0; i < samples; ++i) {
+		p[i] = min(max(round_to_nearest((p[i] - 16) * factor), 0.0f), 255.0f);
+	}
+}
+
+
+/** @param offset Value of video-range black.
+ *  @param maximum Maximum value of a full-range sample.
+ */
+DCPOMATIC_TARGET_CLONES
+static void
+video_range_to_full_range_line_16(uint16_t* p, int samples, float factor, int offset, float maximum)
+{
+	for (int i = 0; i < samples; ++i) {
+		p[i] = min(max(round_to_nearest((p[i] - offset) * factor), 0.0f), maximum);
+	}
+}
+
+
 /** Fade the image.
  *  @param f Amount to fade by; 0 is black, 1 is no fade.
  */
@@ -1521,108 +1501,64 @@ Image::fade (float f)
 
 	switch (_pixel_format) {
 	case AV_PIX_FMT_YUV420P:
-	{
-		/* Y */
-		uint8_t* p = data()[0];
-		int const lines = sample_size(0).height;
-		for (int y = 0; y < lines; ++y) {
-			uint8_t* q = p;
-			for (int x = 0; x < line_size()[0]; ++x) {
-				*q = int(float(*q) * f);
-				++q;
-			}
-			p += stride()[0];
-		}
-
-		/* U, V */
-		for (int c = 1; c < 3; ++c) {
-			uint8_t* p = data()[c];
-			int const lines = sample_size(c).height;
-			for (int y = 0; y < lines; ++y) {
-				uint8_t* q = p;
-				for (int x = 0; x < line_size()[c]; ++x) {
-					*q = eight_bit_uv + int((int(*q) - eight_bit_uv) * f);
-					++q;
+		for_each_band([this, f](int c, int start, int end) {
+			uint8_t* p = data()[c] + start * stride()[c];
+			for (int y = start; y < end; ++y) {
+				if (c == 0) {
+					/* Y */
+					fade_line_8(p, line_size()[c], f);
+				} else {
+					/* U, V */
+					fade_chroma_line_8(p, line_size()[c], f, eight_bit_uv);
 				}
 				p += stride()[c];
 			}
-		}
-
+		});
 		break;
-	}
 
 	case AV_PIX_FMT_RGB24:
-	{
 		/* 8-bit */
-		uint8_t* p = data()[0];
-		int const lines = sample_size(0).height;
-		for (int y = 0; y < lines; ++y) {
-			uint8_t* q = p;
-			for (int x = 0; x < line_size()[0]; ++x) {
-				*q = int (float (*q) * f);
-				++q;
+		for_each_band([this, f](int c, int start, int end) {
+			uint8_t* p = data()[c] + start * stride()[c];
+			for (int y = start; y < end; ++y) {
+				fade_line_8(p, line_size()[c], f);
+				p += stride()[c];
 			}
-			p += stride()[0];
-		}
+		});
 		break;
-	}
 
 	case AV_PIX_FMT_XYZ12LE:
 	case AV_PIX_FMT_RGB48LE:
 		/* 16-bit little-endian */
-		for (int c = 0; c < 3; ++c) {
+		for_each_band([this, f](int c, int start, int end) {
 			int const stride_pixels = stride()[c] / 2;
 			int const line_size_pixels = line_size()[c] / 2;
-			uint16_t* p = reinterpret_cast<uint16_t*> (data()[c]);
-			int const lines = sample_size(c).height;
-			for (int y = 0; y < lines; ++y) {
-				uint16_t* q = p;
-				for (int x = 0; x < line_size_pixels; ++x) {
-					*q = int (float (*q) * f);
-					++q;
-				}
+			uint16_t* p = reinterpret_cast<uint16_t*> (data()[c]) + start * stride_pixels;
+			for (int y = start; y < end; ++y) {
+				fade_line_16(p, line_size_pixels, f);
 				p += stride_pixels;
 			}
-		}
+		});
 		break;
 
 	case AV_PIX_FMT_YUV422P10LE:
-	{
-		/* Y */
-		{
-			int const stride_pixels = stride()[0] / 2;
-			int const line_size_pixels = line_size()[0] / 2;
-			uint16_t* p = reinterpret_cast<uint16_t*> (data()[0]);
-			int const lines = sample_size(0).height;
-			for (int y = 0; y < lines; ++y) {
-				uint16_t* q = p;
-				for (int x = 0; x < line_size_pixels; ++x) {
-					*q = int(float(*q) * f);
-					++q;
-				}
-				p += stride_pixels;
-			}
-		}
-
-		/* U, V */
-		for (int c = 1; c < 3; ++c) {
+		for_each_band([this, f](int c, int start, int end) {
 			int const stride_pixels = stride()[c] / 2;
 			int const line_size_pixels = line_size()[c] / 2;
-			uint16_t* p = reinterpret_cast<uint16_t*> (data()[c]);
-			int const lines = sample_size(c).height;
-			for (int y = 0; y < lines; ++y) {
-				uint16_t* q = p;
-				for (int x = 0; x < line_size_pixels; ++x) {
-					*q = ten_bit_uv + int((int(*q) - ten_bit_uv) * f);
-					++q;
+			uint16_t* p = reinterpret_cast<uint16_t*> (data()[c]) + start * stride_pixels;
+			for (int y = start; y < end; ++y) {
+				if (c == 0) {
+					/* Y */
+					fade_line_16(p, line_size_pixels, f);
+				} else {
+					/* U, V */
+					fade_chroma_line_16(p, line_size_pixels, f, ten_bit_uv);
 				}
 				p += stride_pixels;
 			}
-		}
+		});
 		break;
 
-	}
-
 	default:
 		throw PixelFormatError ("fade()", _pixel_format);
 	}
@@ -1658,49 +1594,39 @@ Image::video_range_to_full_range ()
 	case AV_PIX_FMT_RGB24:
 	{
 		float const factor = 256.0 / 219.0;
-		uint8_t* p = data()[0];
-		int const lines = sample_size(0).height;
-		for (int y = 0; y < lines; ++y) {
-			uint8_t* q = p;
-			for (int x = 0; x < line_size()[0]; ++x) {
-				*q = clamp(lrintf((*q - 16) * factor), 0L, 255L);
-				++q;
+		for_each_band([this, factor](int c, int start, int end) {
+			uint8_t* p = data()[c] + start * stride()[c];
+			for (int y = start; y < end; ++y) {
+				video_range_to_full_range_line_8(p, line_size()[c], factor);
+				p += stride()[c];
 			}
-			p += stride()[0];
-		}
+		});
 		break;
 	}
 	case AV_PIX_FMT_RGB48LE:
 	{
 		float const factor = 65536.0 / 56064.0;
-		uint16_t* p = reinterpret_cast<uint16_t*>(data()[0]);
-		int const lines = sample_size(0).height;
-		for (int y = 0; y < lines; ++y) {
-			uint16_t* q = p;
-			int const line_size_pixels = line_size()[0] / 2;
-			for (int x = 0; x < line_size_pixels; ++x) {
-				*q = clamp(lrintf((*q - 4096) * factor), 0L, 65535L);
-				++q;
+		for_each_band([this, factor](int c, int start, int end) {
+			int const stride_pixels = stride()[c] / 2;
+			uint16_t* p = reinterpret_cast<uint16_t*>(data()[c]) + start * stride_pixels;
+			for (int y = start; y < end; ++y) {
+				video_range_to_full_range_line_16(p, line_size()[c] / 2, factor, 4096, 65535);
+				p += stride_pixels;
 			}
-			p += stride()[0] / 2;
-		}
+		});
 		break;
 	}
 	case AV_PIX_FMT_GBRP12LE:
 	{
 		float const factor = 4096.0 / 3504.0;
-		for (int c = 0; c < 3; ++c) {
-			uint16_t* p = reinterpret_cast<uint16_t*>(data()[c]);
-			int const lines = sample_size(c).height;
-			for (int y = 0; y < lines; ++y) {
-				uint16_t* q = p;
-				int const line_size_pixels = line_size()[c] / 2;
-				for (int x = 0; x < line_size_pixels; ++x) {
-					*q = clamp(lrintf((*q - 256) * factor), 0L, 4095L);
-					++q;
-				}
+		for_each_band([this, factor](int c, int start, int end) {
+			int const stride_pixels = stride()[c] / 2;
+			uint16_t* p = reinterpret_cast<uint16_t*>(data()[c]) + start * stride_pixels;
+			for (int y = start; y < end; ++y) {
+				video_range_to_full_range_line_16(p, line_size()[c] / 2, factor, 256, 4095);
+				p += stride_pixels;
 			}
-		}
+		});
 		break;
 	}
 	default:
@@ -35,6 +35,7 @@ extern "C" {
 }
 #include <dcp/array_data.h>
 #include <dcp/colour_conversion.h>
+#include <functional>
 
 
 struct AVFrame;
@@ -108,20 +109,23 @@ public:
 private:
 	friend struct pixel_formats_test;
 	friend struct make_part_black_test;
+	friend struct video_range_to_full_range_test;
 
 	void allocate ();
+	size_t allocation_size (int plane) const;
 	void swap (Image &);
 	void make_part_black (int x, int w);
 	void yuv_16_black (uint16_t, bool);
 	static uint16_t swap_16 (uint16_t);
 	void video_range_to_full_range ();
+	void for_each_band(std::function<void (int plane, int start, int end)> task);
 	std::pair<std::vector<uint8_t*>, dcp::Size> crop_source_pointers(Crop crop) const;
 
 	dcp::Size _size;
 	AVPixelFormat _pixel_format; ///< FFmpeg's way of describing the pixel format of this Image
-	uint8_t** _data; ///< array of pointers to components
-	int* _line_size; ///< array of sizes of the data in each line, in bytes (without any alignment padding bytes)
-	int* _stride; ///< array of strides for each line, in bytes (including any alignment padding bytes)
+	uint8_t* _data[4]; ///< array of pointers to components
+	int _line_size[4]; ///< array of sizes of the data in each line, in bytes (without any alignment padding bytes)
+	int _stride[4]; ///< array of strides for each line, in bytes (including any alignment padding bytes)
 	Alignment _alignment;
 };
 
@@ -0,0 +1,145 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#include "config.h"
+#include "dcpomatic_assert.h"
+#include "image_pool.h"
+#include "memory_util.h"
+#include <dcp/warnings.h>
+LIBDCP_DISABLE_WARNINGS
+extern "C" {
+#include <libavutil/mem.h>
+}
+LIBDCP_ENABLE_WARNINGS
+#include <algorithm>
+
+
+using std::min;
+
+
+ImagePool*
+ImagePool::instance()
+{
+	/* This is never destroyed, as Images may be freed right up until the end */
+	static auto instance = new ImagePool();
+	return instance;
+}
+
+
+ImagePool::ImagePool()
+{
+	config_changed();
+	_config_connection = Config::instance()->Changed.connect([this](Config::Property) {
+		config_changed();
+	});
+}
+
+
+void
+ImagePool::config_changed()
+{
+	set_limit(static_cast<size_t>(Config::instance()->image_pool_size()) * 1024 * 1024);
+}
+
+
+/** @return a block of memory of the given size, which should be given back with put() */
+uint8_t*
+ImagePool::get(size_t size)
+{
+	{
+		boost::mutex::scoped_lock lm(_mutex);
+		auto i = _free.find(size);
+		if (i != _free.end() && !i->second.empty()) {
+			auto block = i->second.back();
+			i->second.pop_back();
+			_held -= size;
+			++_statistics.hits;
+			return block;
+		}
+		++_statistics.misses;
+	}
+
+	return static_cast<uint8_t*>(wrapped_av_malloc(size));
+}
+
+
+/** Give back a block which was obtained from get(), or with wrapped_av_malloc */
+void
+ImagePool::put(uint8_t* block, size_t size)
+{
+	if (!block) {
+		return;
+	}
+
+	boost::mutex::scoped_lock lm(_mutex);
+	if (size > _limit) {
+		av_free(block);
+		return;
+	}
+
+	_free[size].push_back(block);
+	_held += size;
+	trim();
+}
+
+
+void
+ImagePool::set_limit(size_t limit)
+{
+	boost::mutex::scoped_lock lm(_mutex);
+	_limit = limit;
+	trim();
+}
+
+
+/** Free blocks, largest first, until we are within our limit.  Must be called with _mutex held */
+void
+ImagePool::trim()
+{
+	auto i = _free.rbegin();
+	while (_held > _limit) {
+		DCPOMATIC_ASSERT(i != _free.rend());
+		auto& blocks = i->second;
+		auto const to_free = min(blocks.size(), (_held - _limit + i->first - 1) / i->first);
+		for (size_t j = 0; j < to_free; ++j) {
+			av_free(blocks[j]);
+		}
+		blocks.erase(blocks.begin(), blocks.begin() + to_free);
+		_held -= to_free * i->first;
+		++i;
+	}
+}
+
+
+size_t
+ImagePool::memory_used() const
+{
+	boost::mutex::scoped_lock lm(_mutex);
+	return _held;
+}
+
+
+ImagePool::Statistics
+ImagePool::statistics() const
+{
+	boost::mutex::scoped_lock lm(_mutex);
+	return _statistics;
+}
@@ -0,0 +1,91 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#ifndef DCPOMATIC_IMAGE_POOL_H
+#define DCPOMATIC_IMAGE_POOL_H
+
+
+#include <boost/signals2.hpp>
+#include <boost/thread/mutex.hpp>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+
+/** @class ImagePool
+ *  @brief A pool of memory for Image planes, so that we can re-use the same few large blocks
+ *  rather than asking the allocator for new ones for every frame.
+ *
+ *  Blocks that are given back are kept until the total size held would go over a limit
+ *  (Config::image_pool_size()); then the largest are freed, oldest first.
+ */
+class ImagePool
+{
+public:
+	ImagePool(ImagePool const&) = delete;
+	ImagePool& operator=(ImagePool const&) = delete;
+
+	uint8_t* get(size_t size);
+	void put(uint8_t* block, size_t size);
+
+	/** Set the maximum number of bytes to hold on to when blocks are not in use */
+	void set_limit(size_t limit);
+
+	/** @return number of bytes being held, not in use */
+	size_t memory_used() const;
+
+	struct Statistics
+	{
+		/** number of times get() returned a block from the pool */
+		int64_t hits = 0;
+		/** number of times get() had to allocate a new block */
+		int64_t misses = 0;
+
+		/** @return proportion of get() calls that were satisfied from the pool, from 0 to 1 */
+		float hit_rate() const {
+			return (hits + misses) == 0 ? 0 : static_cast<float>(hits) / (hits + misses);
+		}
+	};
+
+	Statistics statistics() const;
+
+	static ImagePool* instance();
+
+private:
+	ImagePool();
+
+	void trim();
+	void config_changed();
+
+	mutable boost::mutex _mutex;
+	/** blocks not in use, keyed by their size; the most-recently returned of each size is last */
+	std::map<size_t, std::vector<uint8_t*>> _free;
+	/** total size of the blocks in _free */
+	size_t _held = 0;
+	/** limit for _held, taken from Config::image_pool_size() unless set_limit() is called */
+	size_t _limit = 0;
+	Statistics _statistics;
+
+	boost::signals2::scoped_connection _config_connection;
+};
+
+
+#endif
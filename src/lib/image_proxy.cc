@@ -22,6 +22,7 @@
 #include "cross.h"
 #include "exceptions.h"
 #include "ffmpeg_image_proxy.h"
+#include "ffmpeg_packet_image_proxy.h"
 #include "image.h"
 #include "image_proxy.h"
 #include "j2k_image_proxy.h"
@@ -46,6 +47,8 @@ image_proxy_factory (shared_ptr<cxml::Node> xml, shared_ptr<Socket> socket)
 		return make_shared<RawImageProxy>(xml, socket);
 	} else if (xml->string_child("Type") == N_("FFmpeg")) {
 		return make_shared<FFmpegImageProxy>(socket);
+	} else if (xml->string_child("Type") == N_("FFmpegPacket")) {
+		return make_shared<FFmpegPacketImageProxy>(xml, socket);
 	} else if (xml->string_child("Type") == N_("J2K")) {
 		return make_shared<J2KImageProxy>(xml, socket);
 	}
@@ -28,10 +28,12 @@
 #include "config.h"
 #include "cross.h"
 #include "dcp_video.h"
+#include "dcpomatic_assert.h"
 #include "dcpomatic_log.h"
 #include "encode_server_description.h"
 #include "encode_server_finder.h"
 #include "film.h"
+#include "image_pool.h"
 #include "cpu_j2k_encoder_thread.h"
 #ifdef DCPOMATIC_GROK
 #include "grok/context.h"
@@ -41,9 +43,13 @@
 #include "j2k_encoder.h"
 #include "log.h"
 #include "player_video.h"
+#include "sws_context_cache.h"
 #include "util.h"
 #include "writer.h"
 #include <libcxml/cxml.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <iostream>
 
 #include "i18n.h"
@@ -53,7 +59,10 @@ using std::cout;
 using std::dynamic_pointer_cast;
 using std::exception;
 using std::list;
+using std::make_pair;
 using std::make_shared;
+using std::max;
+using std::min;
 using std::shared_ptr;
 using std::weak_ptr;
 using boost::optional;
@@ -88,6 +97,14 @@ grk_plugin::IMessengerLogger* getMessengerLogger(void)
 #endif
 
 
+/** @return a monotonic time in seconds, for measuring intervals */
+static double
+time_now()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
 /** @param film Film that we are encoding.
  *  @param writer Writer that we are using.
  */
@@ -249,6 +266,15 @@ J2KEncoder::end()
 		}
 	}
 
+	auto const scaling = SwsContextCache::statistics();
+	LOG_GENERAL(
+		N_("Scaler contexts: %1 set up in %2s, %3 re-used; %4s spent scaling"),
+		scaling.made, scaling.setup_time, scaling.reused, scaling.scale_time
+		);
+
+	auto const pool = ImagePool::instance()->statistics();
+	LOG_GENERAL(N_("Image pool: %1 hits, %2 misses, %3 bytes held"), pool.hits, pool.misses, ImagePool::instance()->memory_used());
+
 #ifdef DCPOMATIC_GROK
 	delete _context;
 	_context = nullptr;
@@ -296,7 +322,7 @@ J2KEncoder::encode (shared_ptr<PlayerVideo> pv, DCPTime time)
 	/* Wait until the queue has gone down a bit.  Allow one thing in the queue even
 	   when there are no threads.
 	*/
-	while (_queue.size() >= (threads * 2) + 1) {
+	while (_queue.size() >= queue_limit(threads)) {
 		LOG_TIMING ("decoder-sleep queue=%1 threads=%2", _queue.size(), threads);
 		_full_condition.wait (queue_lock);
 		LOG_TIMING ("decoder-wake queue=%1 threads=%2", _queue.size(), threads);
@@ -337,10 +363,11 @@ J2KEncoder::encode (shared_ptr<PlayerVideo> pv, DCPTime time)
 				);
 		_queue.push_back (dcpv);
 
-		/* The queue might not be empty any more, so notify anything which is
-		   waiting on that.
+		/* The queue might not be empty any more, so wake one thread which is
+		   waiting on that; waking them all would just have the others go back
+		   to sleep again.
 		*/
-		_empty_condition.notify_all ();
+		_empty_condition.notify_one ();
 	}
 
 	_last_player_video[pv->eyes()] = pv;
@@ -359,6 +386,9 @@ J2KEncoder::terminate_threads ()
 
 	_threads.clear();
 	_ending = true;
+
+	boost::mutex::scoped_lock queue_lock(_queue_mutex);
+	_workers.clear();
 }
 
 
@@ -455,11 +485,124 @@ J2KEncoder::remake_threads(int cpu, int gpu, list<EncodeServerDescription> serve
 	}
 
 	_writer.set_encoder_threads(_threads.size());
+
+	/* Forget about any threads that we just removed */
+	boost::mutex::scoped_lock queue_lock(_queue_mutex);
+	/* and in case one of them was woken to take a frame, but stopped before it could, wake the rest */
+	_empty_condition.notify_all();
+	for (auto i = _workers.begin(); i != _workers.end(); ) {
+		auto const exists = std::any_of(_threads.begin(), _threads.end(), [i](shared_ptr<J2KEncoderThread> thread) {
+			return thread.get() == i->first;
+		});
+		if (exists) {
+			++i;
+		} else {
+			i = _workers.erase(i);
+		}
+	}
 }
 
 
+/** @return true if a worker has done something recently enough that we can expect it to take
+ *  another frame soon.  Must be called with _queue_mutex held.
+ */
+bool
+J2KEncoder::active(Worker const& worker, double now) const
+{
+	/* A thread which is backing off from a failed server, for example, will look inactive */
+	return worker.latency && (now - worker.last_active) < (*worker.latency * 2 + 1);
+}
+
+
+/** @return the number of frames that we should allow in the queue before encode() blocks.
+ *  Must be called with _queue_mutex held.
+ */
+size_t
+J2KEncoder::queue_limit(size_t threads) const
+{
+	/* Enough to keep every thread busy with one to spare for each */
+	auto limit = threads * 2 + 1;
+
+	auto const rate = _history.rate();
+	if (!rate) {
+		return limit;
+	}
+
+	/* Also try to have enough that our slowest worker can find a frame which it will finish before the
+	 * writer needs it (see choose()), but don't let the queue grow without bound as decoded frames are big.
+	 */
+	auto const now = time_now();
+	double slowest = 0;
+	for (auto const& worker: _workers) {
+		if (active(worker.second, now)) {
+			slowest = max(slowest, *worker.second.latency);
+		}
+	}
+
+	auto const needed = static_cast<size_t>(std::ceil(slowest * *rate)) + threads;
+	return max(limit, min(needed, threads * 4 + 1));
+}
+
+
+/** Choose the frame that a thread should encode next.  The front of the queue holds the frames that
+ *  the writer will need first, so these are given to the fastest threads.  A thread which is slower
+ *  than some other active thread instead takes the first frame that it can expect to finish before
+ *  the writer gets to it, leaving the earlier frames for the faster threads; this stops slow
+ *  threads (typically busy or distant servers) from holding up the writer.
+ *
+ *  Must be called with _queue_mutex held and _queue not empty.
+ */
+std::list<DCPVideo>::iterator
+J2KEncoder::choose(J2KEncoderThread const* thread, double now)
+{
+	DCPOMATIC_ASSERT(!_queue.empty());
+
+	auto worker = _workers.find(thread);
+	if (worker == _workers.end() || !worker->second.latency) {
+		return _queue.begin();
+	}
+
+	auto const latency = *worker->second.latency;
+
+	auto const faster = std::any_of(_workers.begin(), _workers.end(), [this, latency, now](auto const& other) {
+		return active(other.second, now) && *other.second.latency < latency;
+	});
+
+	auto const rate = _history.rate();
+	if (!faster || !rate) {
+		return _queue.begin();
+	}
+
+	/* Number of frames that will be written while this thread is encoding one */
+	auto const slack = static_cast<size_t>(std::ceil(latency * *rate));
+	return std::next(_queue.begin(), min(slack, _queue.size() - 1));
+}
+
+
+/** Remove a frame from the queue for a thread to encode.  Must be called with _queue_mutex held */
+DCPVideo
+J2KEncoder::take(std::list<DCPVideo>::iterator iter, J2KEncoderThread const* thread, double now)
+{
+	auto vf = *iter;
+	_queue.erase(iter);
+
+	if (thread) {
+		auto& worker = _workers[thread];
+		worker.started[make_pair(vf.index(), vf.eyes())] = now;
+		worker.last_active = now;
+	}
+
+	_full_condition.notify_all();
+	return vf;
+}
+
+
+/** @param thread Thread which is asking for a frame, used to decide which frame it should be given,
+ *  or nullptr to just take the next one.
+ *  @return the frame that \p thread should encode next.
+ */
 DCPVideo
-J2KEncoder::pop()
+J2KEncoder::pop(J2KEncoderThread const* thread)
 {
 	boost::mutex::scoped_lock lock(_queue_mutex);
 	while (_queue.empty()) {
@@ -468,11 +611,25 @@ J2KEncoder::pop()
 
 	LOG_TIMING("encoder-wake thread=%1 queue=%2", thread_id(), _queue.size());
 
-	auto vf = _queue.front();
-	_queue.pop_front();
+	auto const now = time_now();
+	return take(choose(thread, now), thread, now);
+}
 
-	_full_condition.notify_all();
-	return vf;
+
+/** @param thread Thread which is asking for a frame, as for pop().
+ *  @return the frame that \p thread should encode next, or an empty optional if there is none
+ *  ready right now.
+ */
+optional<DCPVideo>
+J2KEncoder::try_pop(J2KEncoderThread const* thread)
+{
+	boost::mutex::scoped_lock lock(_queue_mutex);
+	if (_queue.empty()) {
+		return {};
+	}
+
+	auto const now = time_now();
+	return take(choose(thread, now), thread, now);
 }
 
 
@@ -499,15 +656,41 @@ J2KEncoder::retry(DCPVideo video)
 
 	{
 		boost::mutex::scoped_lock lock(_queue_mutex);
-		_queue.push_front(video);
-		_empty_condition.notify_all();
+		for (auto& worker: _workers) {
+			worker.second.started.erase(make_pair(video.index(), video.eyes()));
+		}
+		/* Keep the queue in order so that the front is always the frame that the writer needs first */
+		auto iter = std::find_if(_queue.begin(), _queue.end(), [&video](DCPVideo const& other) {
+			return other.index() > video.index();
+		});
+		_queue.insert(iter, video);
+		_empty_condition.notify_one();
 	}
 }
 
 
+/** Called by a thread when it has encoded a frame.
+ *  @param thread Thread which encoded the frame, or nullptr.
+ */
 void
-J2KEncoder::write(shared_ptr<const dcp::Data> data, int index, Eyes eyes)
+J2KEncoder::write(shared_ptr<const dcp::Data> data, int index, Eyes eyes, J2KEncoderThread const* thread)
 {
+	if (thread) {
+		boost::mutex::scoped_lock lock(_queue_mutex);
+		auto worker = _workers.find(thread);
+		if (worker != _workers.end()) {
+			auto const now = time_now();
+			auto started = worker->second.started.find(make_pair(index, eyes));
+			if (started != worker->second.started.end()) {
+				auto const taken = now - started->second;
+				auto& latency = worker->second.latency;
+				latency = latency ? (*latency * 0.75 + taken * 0.25) : taken;
+				worker->second.started.erase(started);
+			}
+			worker->second.last_active = now;
+		}
+	}
+
 	_writer.write(data, index, eyes);
 	frame_done();
 }
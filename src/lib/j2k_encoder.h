@@ -41,6 +41,7 @@
 #include <boost/thread/condition.hpp>
 #include <boost/thread/mutex.hpp>
 #include <list>
+#include <map>
 #include <stdint.h>
 
 
@@ -58,6 +59,7 @@ namespace grk_plugin {
 struct local_threads_created_and_destroyed;
 struct remote_threads_created_and_destroyed;
 struct frames_not_lost_when_threads_disappear;
+struct j2k_encoder_schedule_test;
 
 
 /** @class J2KEncoder
@@ -87,16 +89,35 @@ public:
 	/** Called when a processing run has finished */
 	void end() override;
 
-	DCPVideo pop();
+	DCPVideo pop(J2KEncoderThread const* thread = nullptr);
+	boost::optional<DCPVideo> try_pop(J2KEncoderThread const* thread = nullptr);
 	void retry(DCPVideo frame);
-	void write(std::shared_ptr<const dcp::Data> data, int index, Eyes eyes);
+	void write(std::shared_ptr<const dcp::Data> data, int index, Eyes eyes, J2KEncoderThread const* thread = nullptr);
 
 private:
 	friend struct ::local_threads_created_and_destroyed;
 	friend struct ::remote_threads_created_and_destroyed;
 	friend struct ::frames_not_lost_when_threads_disappear;
+	friend struct ::j2k_encoder_schedule_test;
+
+	/** What we know about how quickly one of our threads gets through frames */
+	struct Worker
+	{
+		/** Smoothed time between the thread taking a frame and handing it back, in seconds,
+		 *  or empty if it has not yet finished one.
+		 */
+		boost::optional<double> latency;
+		/** Time that the thread last took or finished a frame */
+		double last_active = 0;
+		/** Times at which frames that the thread is working on were taken, keyed by index and eyes */
+		std::map<std::pair<int, Eyes>, double> started;
+	};
 
 	void frame_done ();
+	std::list<DCPVideo>::iterator choose(J2KEncoderThread const* thread, double now);
+	DCPVideo take(std::list<DCPVideo>::iterator iter, J2KEncoderThread const* thread, double now);
+	size_t queue_limit(size_t threads) const;
+	bool active(Worker const& worker, double now) const;
 	void servers_list_changed ();
 	void remake_threads(int cpu, int gpu, std::list<EncodeServerDescription> servers);
 	void terminate_threads ();
@@ -105,11 +126,17 @@ private:
 	std::vector<std::shared_ptr<J2KEncoderThread>> _threads;
 
 	mutable boost::mutex _queue_mutex;
+	/** frames waiting to be encoded.  This is not a lock-free FIFO since choose() may take
+	 *  any frame from it, and encode() waits on it when it is full; the j2k_encoder_writer
+	 *  benchmarks show how it copes with many threads.
+	 */
 	std::list<DCPVideo> _queue;
 	/** condition to manage thread wakeups when we have nothing to do */
 	boost::condition _empty_condition;
 	/** condition to manage thread wakeups when we have too much to do */
 	boost::condition _full_condition;
+	/** Statistics for each of our threads; protected by _queue_mutex */
+	std::map<J2KEncoderThread const*, Worker> _workers;
 
 	Waker _waker;
 
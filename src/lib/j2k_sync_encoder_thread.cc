@@ -48,7 +48,7 @@ try
 		}
 
 		LOG_TIMING("encoder-sleep thread=%1", thread_id());
-		auto frame = _encoder.pop();
+		auto frame = _encoder.pop(this);
 
 		dcp::ScopeGuard frame_guard([this, &frame]() {
 			boost::this_thread::disable_interruption dis;
@@ -62,7 +62,7 @@ try
 		if (encoded) {
 			boost::this_thread::disable_interruption dis;
 			frame_guard.cancel();
-			_encoder.write(encoded, frame.index(), frame.eyes());
+			_encoder.write(encoded, frame.index(), frame.eyes(), this);
 		}
 	}
 } catch (boost::thread_interrupted& e) {
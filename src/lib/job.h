@@ -61,6 +61,27 @@ public:
 		return false;
 	}
 
+	/** The kind of resource that a job mostly uses.  JobManager will run jobs which
+	 *  use different resources at the same time.
+	 */
+	enum class Resource {
+		ENCODE,   ///< CPU-heavy encoding
+		IO,       ///< reading or writing files
+		NETWORK,  ///< sending things over the network
+		ANALYSIS  ///< lighter analysis of content
+	};
+
+	virtual Resource resource () const {
+		return Resource::ENCODE;
+	}
+
+	/** @return true if this job only reads its film.  JobManager runs the jobs for
+	 *  a film one after the other unless they all only read it.
+	 */
+	virtual bool read_only () const {
+		return false;
+	}
+
 	void start ();
 	virtual void pause() {}
 	bool pause_by_user ();
@@ -26,6 +26,7 @@
 
 #include "analyse_audio_job.h"
 #include "analyse_subtitles_job.h"
+#include "config.h"
 #include "cross.h"
 #include "film.h"
 #include "job.h"
@@ -50,7 +51,11 @@ JobManager* JobManager::_instance = nullptr;
 
 JobManager::JobManager()
 {
-
+	/* Wake the scheduler in case the limits on how many jobs can run have changed */
+	_connections.push_back(Config::instance()->Changed.connect([this](Config::Property) {
+		boost::mutex::scoped_lock lm(_mutex);
+		_schedule_condition.notify_all();
+	}));
 }
 
 
@@ -164,47 +169,113 @@ JobManager::scheduler()
 			break;
 		}
 
-		bool have_running = false;
+		/* Go through the jobs in priority order, letting each one run if there
+		 * is room for another job using the same resource, and no higher-priority
+		 * job for the same film is waiting or running (unless both jobs only read
+		 * the film).
+		 */
+		std::map<Job::Resource, int> running;
+		/* Films with a job which is running or waiting to run, and whether all such jobs only read the film */
+		std::map<shared_ptr<const Film>, bool> films;
+		list<shared_ptr<Job>> started;
+		list<shared_ptr<Job>> stopped;
 		for (auto i: _jobs) {
-			if ((have_running || _paused) && i->running()) {
-				/* We already have a running job, or are totally paused, so this job should not be running */
-				i->pause_by_priority();
-			} else if (!have_running && !_paused && (i->is_new() || i->paused_by_priority())) {
-				/* We don't have a running job, and we should have one, so start/resume this */
+			auto const resource = i->resource();
+			auto const film = i->film();
+			auto const earlier = film ? films.find(film) : films.end();
+			bool const film_free = earlier == films.end() || (earlier->second && i->read_only());
+			bool const room = !_paused && film_free && running[resource] < limit(resource);
+			if (film && (i->running() || i->is_new() || i->paused_by_priority())) {
+				auto iter = films.emplace(film, true).first;
+				iter->second = iter->second && i->read_only();
+			}
+			if (i->running()) {
+				if (room) {
+					++running[resource];
+				} else {
+					/* There are higher-priority jobs using this resource or this film, or we are
+					 * totally paused, so this job should not be running.
+					 */
+					i->pause_by_priority();
+					stopped.push_back(i);
+				}
+			} else if (room && (i->is_new() || i->paused_by_priority())) {
 				if (i->is_new()) {
-					_connections.push_back(i->FinishedImmediate.connect(bind(&JobManager::job_finished, this)));
+					_connections.push_back(i->FinishedImmediate.connect(bind(&JobManager::job_finished, this, weak_ptr<Job>(i))));
 					i->start();
 				} else {
 					i->resume();
 				}
-				auto last = _last_active_job.lock();
-				emit(boost::bind(boost::ref(ActiveJobsChanged), last ? last->json_name() : std::string{}, i->json_name()));
 				_last_active_job = i;
-				have_running = true;
-			} else if (!have_running && i->running()) {
-				have_running = true;
+				++running[resource];
+				started.push_back(i);
 			}
 		}
 
+		auto const active = active_job_unlocked();
+		for (auto i: stopped) {
+			emit(boost::bind(boost::ref(ActiveJobsChanged), i->json_name(), active));
+		}
+		if (!started.empty()) {
+			emit(boost::bind(boost::ref(ActiveJobsChanged), optional<string>(), active));
+		}
+
 		_schedule_condition.wait(lm);
 	}
 }
 
 
+/** @return json_name() of the highest-priority job which is running, if there is one.
+ *  A lock must be held on _mutex.
+ */
+optional<string>
+JobManager::active_job_unlocked() const
+{
+	auto iter = std::find_if(_jobs.begin(), _jobs.end(), [](shared_ptr<const Job> job) { return job->running(); });
+	if (iter == _jobs.end()) {
+		return {};
+	}
+	return (*iter)->json_name();
+}
+
+
 void
-JobManager::job_finished()
+JobManager::job_finished(weak_ptr<Job> weak_job)
 {
 	{
 		boost::mutex::scoped_lock lm(_mutex);
-		auto job = _last_active_job.lock();
-		emit(boost::bind(boost::ref(ActiveJobsChanged), job ? job->json_name() : string{}, optional<string>()));
-		_last_active_job = {};
+		auto job = weak_job.lock();
+		emit(boost::bind(boost::ref(ActiveJobsChanged), job ? job->json_name() : string{}, active_job_unlocked()));
+		if (_last_active_job.lock() == job) {
+			_last_active_job = {};
+		}
 	}
 
 	_schedule_condition.notify_all();
 }
 
 
+/** @return the maximum number of jobs using a given resource which may run at the same time */
+int
+JobManager::limit(Job::Resource resource) const
+{
+	auto config = Config::instance();
+	switch (resource) {
+	case Job::Resource::ENCODE:
+		return config->maximum_encode_jobs();
+	case Job::Resource::IO:
+		return config->maximum_file_jobs();
+	case Job::Resource::NETWORK:
+		return config->maximum_network_jobs();
+	case Job::Resource::ANALYSIS:
+		return config->maximum_analysis_jobs();
+	}
+
+	DCPOMATIC_ASSERT(false);
+	return 1;
+}
+
+
 JobManager *
 JobManager::instance()
 {
@@ -31,6 +31,7 @@
 #include <boost/signals2.hpp>
 #include <boost/thread/condition.hpp>
 #include <list>
+#include <map>
 
 
 class Film;
@@ -44,6 +45,11 @@ extern bool wait_for_jobs();
 
 /** @class JobManager
  *  @brief A simple scheduler for jobs.
+ *
+ *  Jobs are run in priority order.  Jobs which use different resources (see Job::resource())
+ *  can run at the same time, up to a limit for each resource which is taken from Config.
+ *  Jobs for the same film still run one after the other, unless they only read it
+ *  (see Job::read_only()).
  */
 class JobManager : public Signaller
 {
@@ -88,6 +94,10 @@ public:
 
 	boost::signals2::signal<void (std::weak_ptr<Job>)> JobAdded;
 	boost::signals2::signal<void ()> JobsReordered;
+	/** Emitted when jobs start or stop.  The first parameter is the json_name() of a job which has
+	 *  stopped, if there is one; the second is the json_name() of the highest-priority job which is
+	 *  now running, if there is one.
+	 */
 	boost::signals2::signal<void (boost::optional<std::string>, boost::optional<std::string>)> ActiveJobsChanged;
 
 	static JobManager* instance();
@@ -102,7 +112,9 @@ private:
 	~JobManager();
 	void scheduler();
 	void start();
-	void job_finished();
+	void job_finished(std::weak_ptr<Job> job);
+	boost::optional<std::string> active_job_unlocked() const;
+	int limit(Job::Resource resource) const;
 
 	mutable boost::mutex _mutex;
 	boost::condition _schedule_condition;
@@ -20,6 +20,7 @@
 
 
 #include "maths_util.h"
+#include "target_clones.h"
 #include <cmath>
 
 
@@ -52,3 +53,35 @@ logarithmic_fade_out_curve (float t)
 	return std::exp(-2 * c) * (1 - c);
 }
 
+
+DCPOMATIC_TARGET_CLONES
+void
+accumulate_power (float const* data, int frames, float minimum, float& sum_of_squares, float& peak)
+{
+	/* Use several independent accumulators so that each addition doesn't have to wait for the
+	 * one before, and so that the compiler can vectorise the loop.
+	 */
+	int constexpr lanes = 8;
+	float sums[lanes] = { 0 };
+	float peaks[lanes] = { 0 };
+
+	int i = 0;
+	for (; i + lanes <= frames; i += lanes) {
+		for (int j = 0; j < lanes; ++j) {
+			auto const a = std::max(std::abs(data[i + j]), minimum);
+			sums[j] += a * a;
+			peaks[j] = std::max(peaks[j], a);
+		}
+	}
+
+	for (; i < frames; ++i) {
+		auto const a = std::max(std::abs(data[i]), minimum);
+		sums[0] += a * a;
+		peaks[0] = std::max(peaks[0], a);
+	}
+
+	for (int j = 0; j < lanes; ++j) {
+		sum_of_squares += sums[j];
+		peak = std::max(peak, peaks[j]);
+	}
+}
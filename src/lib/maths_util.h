@@ -46,6 +46,13 @@ extern float logarithmic_fade_in_curve (float t);
 extern float logarithmic_fade_out_curve (float t);
 
 
+/** Add the squares of some samples to sum_of_squares, and raise peak to the largest absolute value
+ *  of the samples if it is not already higher.  Samples whose absolute value is less than minimum are
+ *  treated as if they were minimum.
+ */
+extern void accumulate_power (float const* data, int frames, float minimum, float& sum_of_squares, float& peak);
+
+
 template <class T>
 T clamp (T val, T minimum, T maximum)
 {
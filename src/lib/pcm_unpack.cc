@@ -0,0 +1,82 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+
+#include "pcm_unpack.h"
+#include "target_clones.h"
+#include <climits>
+
+
+/* These loops are written so that each output sample depends only on its own input,
+ * which lets the compiler vectorise them.
+ */
+
+
+DCPOMATIC_TARGET_CLONES
+void
+unpack_pcm_24(uint8_t const* in, int samples, float* out)
+{
+	for (int i = 0; i < samples; ++i) {
+		uint32_t const v = (uint32_t(in[i * 3]) << 8) | (uint32_t(in[i * 3 + 1]) << 16) | (uint32_t(in[i * 3 + 2]) << 24);
+		out[i] = static_cast<int32_t>(v) / static_cast<float>(INT_MAX - 256);
+	}
+}
+
+
+DCPOMATIC_TARGET_CLONES
+void
+unpack_pcm_16(uint8_t const* in, int samples, float* out)
+{
+	for (int i = 0; i < samples; ++i) {
+		uint32_t const v = (uint32_t(in[i * 2]) << 16) | (uint32_t(in[i * 2 + 1]) << 24);
+		out[i] = static_cast<int32_t>(v) / static_cast<float>(INT_MAX - 256);
+	}
+}
+
+
+DCPOMATIC_TARGET_CLONES
+void
+unpack_u8(uint8_t const* in, int samples, float* out)
+{
+	for (int i = 0; i < samples; ++i) {
+		out[i] = float(in[i]) / (1 << 23);
+	}
+}
+
+
+DCPOMATIC_TARGET_CLONES
+void
+unpack_s16(int16_t const* in, int samples, float* out)
+{
+	for (int i = 0; i < samples; ++i) {
+		out[i] = float(in[i]) / (1 << 15);
+	}
+}
+
+
+DCPOMATIC_TARGET_CLONES
+void
+unpack_s32(int32_t const* in, int samples, float* out)
+{
+	for (int i = 0; i < samples; ++i) {
+		out[i] = static_cast<float>(in[i]) / 2147483648;
+	}
+}
@@ -0,0 +1,47 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+
+/** @file  src/lib/pcm_unpack.h
+ *  @brief Functions to convert integer PCM audio samples to float.
+ *
+ *  These all work on runs of samples without caring about channels, so they can be
+ *  used on interleaved or planar data.
+ */
+
+
+#ifndef DCPOMATIC_PCM_UNPACK_H
+#define DCPOMATIC_PCM_UNPACK_H
+
+
+#include <cstdint>
+
+
+/** Convert packed, little-endian 24-bit samples (as found in DCP sound assets) */
+extern void unpack_pcm_24(uint8_t const* in, int samples, float* out);
+/** Convert packed, little-endian 16-bit samples (as found in DCP sound assets) */
+extern void unpack_pcm_16(uint8_t const* in, int samples, float* out);
+extern void unpack_u8(uint8_t const* in, int samples, float* out);
+extern void unpack_s16(int16_t const* in, int samples, float* out);
+extern void unpack_s32(int32_t const* in, int samples, float* out);
+
+
+#endif
@@ -26,6 +26,8 @@
 #include "j2k_image_proxy.h"
 #include "player.h"
 #include "player_video.h"
+#include "player_video_cache.h"
+#include "raw_image_proxy.h"
 #include "video_content.h"
 extern "C" {
 #include <libavutil/pixfmt.h>
@@ -140,15 +142,27 @@ PlayerVideo::raw_image () const
  *  it is passed the pixel format of the input image from the ImageProxy, and should return the desired
  *  output pixel format.  Two functions force and keep_xyz_or_rgb are provided for use here.
  *  @param fast true to be fast at the expense of quality.
+ *  @param cache Cache to look in for the scaled image before decoding it, and to add it to afterwards, or nullptr.
  */
 void
-PlayerVideo::make_image (function<AVPixelFormat (AVPixelFormat)> pixel_format, VideoRange video_range, bool fast) const
+PlayerVideo::make_image (function<AVPixelFormat (AVPixelFormat)> pixel_format, VideoRange video_range, bool fast, PlayerVideoCache* cache) const
 {
 	_image_crop = _crop;
 	_image_inter_size = _inter_size;
 	_image_out_size = _out_size;
 	_image_fade = _fade;
 
+	auto const key = cache ? cache_key() : optional<string>();
+	if (key) {
+		if (auto cached = cache->get(*key)) {
+			/* Take a copy since we may be about to put text and fade on it */
+			_image = make_shared<Image>(*cached);
+			_error = false;
+			finish_image();
+			return;
+		}
+	}
+
 	auto prox = _in->image (Image::Alignment::PADDED, _inter_size);
 	_error = prox.error;
 
@@ -188,6 +202,18 @@ PlayerVideo::make_image (function<AVPixelFormat (AVPixelFormat)> pixel_format, V
 		total_crop, _inter_size, _out_size, yuv_to_rgb, _video_range, pixel_format (prox.image->pixel_format()), video_range, Image::Alignment::COMPACT, fast
 		);
 
+	if (key && !_error) {
+		cache->put(*key, make_shared<const Image>(*_image));
+	}
+
+	finish_image();
+}
+
+
+/** Add any text and fade to _image.  A lock must be held on _mutex */
+void
+PlayerVideo::finish_image () const
+{
 	if (_text) {
 		_image->alpha_blend (_text->image, _text->position);
 	}
@@ -250,6 +276,14 @@ PlayerVideo::has_j2k () const
 }
 
 
+/** @return true if our input is an uncompressed image */
+bool
+PlayerVideo::has_raw_image () const
+{
+	return static_cast<bool>(dynamic_pointer_cast<const RawImageProxy>(_in));
+}
+
+
 shared_ptr<const dcp::Data>
 PlayerVideo::j2k () const
 {
@@ -310,9 +344,29 @@ PlayerVideo::keep_xyz_or_rgb (AVPixelFormat p)
 }
 
 
+/** Prepare our image so that a later call to image() with the same parameters is quick.
+ *  @param proxy_only true to only prepare the ImageProxy, and not the final image.
+ *  @param cache Cache to look in before decoding, and to add the image to afterwards, or nullptr.
+ */
 void
-PlayerVideo::prepare (function<AVPixelFormat (AVPixelFormat)> pixel_format, VideoRange video_range, Image::Alignment alignment, bool fast, bool proxy_only)
+PlayerVideo::prepare (
+	function<AVPixelFormat (AVPixelFormat)> pixel_format,
+	VideoRange video_range,
+	Image::Alignment alignment,
+	bool fast,
+	bool proxy_only,
+	PlayerVideoCache* cache
+	)
 {
+	if (cache && !proxy_only) {
+		/* Don't prepare the proxy, since we might not need to decode it at all */
+		boost::mutex::scoped_lock lm (_mutex);
+		if (!_image) {
+			make_image (pixel_format, video_range, fast, cache);
+		}
+		return;
+	}
+
 	_in->prepare (alignment, _inter_size);
 	boost::mutex::scoped_lock lm (_mutex);
 	if (!_image && !proxy_only) {
@@ -349,6 +403,42 @@ PlayerVideo::shallow_copy () const
 }
 
 
+/** @return a key for use with PlayerVideoCache which identifies the image that make_image()
+ *  will produce before any text or fade is added, or none if we don't know enough to make one.
+ */
+optional<string>
+PlayerVideo::cache_key () const
+{
+	auto content = _content.lock();
+	if (!content || !_video_time) {
+		return {};
+	}
+
+	auto key = fmt::format(
+		"{}_{}_{}_{}_{}_{}_{}_{}_{}_{}_{}_{}_{}",
+		content->identifier(),
+		_video_time->get(),
+		static_cast<int>(_eyes),
+		static_cast<int>(_part),
+		_crop.left,
+		_crop.right,
+		_crop.top,
+		_crop.bottom,
+		_inter_size.width,
+		_inter_size.height,
+		_out_size.width,
+		_out_size.height,
+		static_cast<int>(_video_range)
+		);
+
+	if (_colour_conversion) {
+		key += "_" + _colour_conversion->identifier();
+	}
+
+	return key;
+}
+
+
 /** Re-read crop, fade, inter/out size, colour conversion and video range from our content.
  *  @return true if this was possible, false if not.
  */
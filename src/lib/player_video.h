@@ -38,6 +38,7 @@ extern "C" {
 class Image;
 class ImageProxy;
 class Film;
+class PlayerVideoCache;
 class Socket;
 
 
@@ -75,7 +76,14 @@ public:
 		return _text;
 	}
 
-	void prepare (std::function<AVPixelFormat (AVPixelFormat)> pixel_format, VideoRange video_range, Image::Alignment alignment, bool fast, bool proxy_only);
+	void prepare (
+		std::function<AVPixelFormat (AVPixelFormat)> pixel_format,
+		VideoRange video_range,
+		Image::Alignment alignment,
+		bool fast,
+		bool proxy_only,
+		PlayerVideoCache* cache = nullptr
+		);
 	std::shared_ptr<Image> image (std::function<AVPixelFormat (AVPixelFormat)> pixel_format, VideoRange video_range, bool fast) const;
 	std::shared_ptr<const Image> raw_image () const;
 
@@ -88,6 +96,7 @@ public:
 	bool reset_metadata (std::shared_ptr<const Film> film, dcp::Size player_video_container_size);
 
 	bool has_j2k () const;
+	bool has_raw_image () const;
 	std::shared_ptr<const dcp::Data> j2k () const;
 
 	Eyes eyes () const {
@@ -116,6 +125,8 @@ public:
 
 	bool same (std::shared_ptr<const PlayerVideo> other) const;
 
+	boost::optional<std::string> cache_key () const;
+
 	size_t memory_used () const;
 
 	std::weak_ptr<Content> content () const {
@@ -127,7 +138,8 @@ public:
 	}
 
 private:
-	void make_image (std::function<AVPixelFormat (AVPixelFormat)> pixel_format, VideoRange video_range, bool fast) const;
+	void make_image (std::function<AVPixelFormat (AVPixelFormat)> pixel_format, VideoRange video_range, bool fast, PlayerVideoCache* cache = nullptr) const;
+	void finish_image () const;
 
 	std::shared_ptr<const ImageProxy> _in;
 	Crop _crop;
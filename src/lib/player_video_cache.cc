@@ -0,0 +1,104 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+
+#include "image.h"
+#include "player_video_cache.h"
+
+
+using std::shared_ptr;
+using std::string;
+
+
+PlayerVideoCache::PlayerVideoCache(size_t limit)
+	: _limit(limit)
+{
+
+}
+
+
+/** @return The image with the given key, or nullptr */
+shared_ptr<const Image>
+PlayerVideoCache::get(string const& key)
+{
+	boost::mutex::scoped_lock lm(_mutex);
+
+	auto i = _index.find(key);
+	if (i == _index.end()) {
+		++_statistics.misses;
+		return {};
+	}
+
+	++_statistics.hits;
+	_images.splice(_images.begin(), _images, i->second);
+	return i->second->second;
+}
+
+
+/** Add an image to the cache.  It must not be modified after this call */
+void
+PlayerVideoCache::put(string const& key, shared_ptr<const Image> image)
+{
+	auto const size = image->memory_used();
+
+	boost::mutex::scoped_lock lm(_mutex);
+
+	if (size > _limit || _index.find(key) != _index.end()) {
+		return;
+	}
+
+	_images.push_front({key, image});
+	_index[key] = _images.begin();
+	_held += size;
+
+	while (_held > _limit) {
+		auto const& last = _images.back();
+		_held -= last.second->memory_used();
+		_index.erase(last.first);
+		_images.pop_back();
+	}
+}
+
+
+void
+PlayerVideoCache::clear()
+{
+	boost::mutex::scoped_lock lm(_mutex);
+	_images.clear();
+	_index.clear();
+	_held = 0;
+}
+
+
+size_t
+PlayerVideoCache::memory_used() const
+{
+	boost::mutex::scoped_lock lm(_mutex);
+	return _held;
+}
+
+
+PlayerVideoCache::Statistics
+PlayerVideoCache::statistics() const
+{
+	boost::mutex::scoped_lock lm(_mutex);
+	return _statistics;
+}
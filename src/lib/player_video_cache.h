@@ -0,0 +1,96 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+
+#ifndef DCPOMATIC_PLAYER_VIDEO_CACHE_H
+#define DCPOMATIC_PLAYER_VIDEO_CACHE_H
+
+
+#include <boost/thread/mutex.hpp>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+
+class Image;
+
+
+/** @class PlayerVideoCache
+ *  @brief A cache of images made by PlayerVideo, so that frames which are shown again
+ *  (after a seek back, say) do not have to be decoded and scaled again.
+ *
+ *  Images are looked up using a key made by PlayerVideo::cache_key(), which describes the
+ *  source frame and everything that is done to it before any text or fade is applied.  The
+ *  key does not describe the output pixel format, range or quality, so a given cache must only
+ *  be used with one set of those parameters.
+ *
+ *  The total size of the images held is kept under a limit by discarding the
+ *  least-recently-used.
+ */
+class PlayerVideoCache
+{
+public:
+	explicit PlayerVideoCache(size_t limit);
+
+	PlayerVideoCache(PlayerVideoCache const&) = delete;
+	PlayerVideoCache& operator=(PlayerVideoCache const&) = delete;
+
+	std::shared_ptr<const Image> get(std::string const& key);
+	void put(std::string const& key, std::shared_ptr<const Image> image);
+	void clear();
+
+	/** @return number of bytes used by the images being held */
+	size_t memory_used() const;
+
+	struct Statistics
+	{
+		/** number of times get() found an image */
+		int64_t hits = 0;
+		/** number of times get() found nothing */
+		int64_t misses = 0;
+
+		/** @return proportion of get() calls that found an image, from 0 to 1 */
+		float hit_rate() const {
+			return (hits + misses) == 0 ? 0 : static_cast<float>(hits) / (hits + misses);
+		}
+	};
+
+	Statistics statistics() const;
+
+private:
+	typedef std::list<std::pair<std::string, std::shared_ptr<const Image>>> List;
+
+	mutable boost::mutex _mutex;
+	/** images with their keys, most-recently-used first */
+	List _images;
+	std::unordered_map<std::string, List::iterator> _index;
+	/** total size of the images in _images */
+	size_t _held = 0;
+	/** limit for _held */
+	size_t _limit;
+	Statistics _statistics;
+};
+
+
+#endif
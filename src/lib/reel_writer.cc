@@ -232,8 +232,8 @@ ReelWriter::ReelWriter (
 			}
 		}
 
-		/* Write the sound asset into the film directory so that we leave the creation
-		   of the DCP directory until the last minute.
+		/* Write the sound asset into the film directory; finish_sound() moves it into
+		   the DCP directory once all the reel's audio has been written.
 		*/
 		_sound_asset_writer = _sound_asset->start_write (
 			film()->directory().get() / audio_asset_filename (_sound_asset, _reel_index, _reel_count, _content_summary),
@@ -354,42 +354,75 @@ ReelWriter::repeat_write (Frame frame, Eyes eyes)
 }
 
 
+/** Finish writing our picture asset.  This can be called before finish(), as soon as
+ *  the last frame of the reel has been written.
+ */
 void
-ReelWriter::finish (boost::filesystem::path output_dcp)
+ReelWriter::finish_picture()
 {
-	if (_j2k_picture_asset_writer && !_j2k_picture_asset_writer->finalize()) {
-		/* Nothing was written to the J2K picture asset */
-		LOG_GENERAL("Nothing was written to J2K asset for reel %1 of %2", _reel_index, _reel_count);
-		_j2k_picture_asset.reset();
+	if (_j2k_picture_asset_writer) {
+		if (!_j2k_picture_asset_writer->finalize()) {
+			/* Nothing was written to the J2K picture asset */
+			LOG_GENERAL("Nothing was written to J2K asset for reel %1 of %2", _reel_index, _reel_count);
+			_j2k_picture_asset.reset();
+		}
+		/* Any further writes will be ignored */
+		_j2k_picture_asset_writer.reset();
 	}
 
-	if (_mpeg2_picture_asset_writer && !_mpeg2_picture_asset_writer->finalize()) {
-		/* Nothing was written to the MPEG2 picture asset */
-		LOG_GENERAL("Nothing was written to MPEG2 asset for reel %1 of %2", _reel_index, _reel_count);
-		_mpeg2_picture_asset.reset();
+	if (_mpeg2_picture_asset_writer) {
+		if (!_mpeg2_picture_asset_writer->finalize()) {
+			/* Nothing was written to the MPEG2 picture asset */
+			LOG_GENERAL("Nothing was written to MPEG2 asset for reel %1 of %2", _reel_index, _reel_count);
+			_mpeg2_picture_asset.reset();
+		}
+		_mpeg2_picture_asset_writer.reset();
 	}
+}
+
 
-	if (_sound_asset_writer && !_sound_asset_writer->finalize ()) {
+/** Finish writing our sound asset and move it into the DCP.  This can be called before
+ *  finish(), as soon as all the audio for the reel has been written.
+ */
+void
+ReelWriter::finish_sound()
+{
+	if (!_sound_asset_writer) {
+		/* Either there is no sound, or we already did this */
+		return;
+	}
+
+	auto const written = _sound_asset_writer->finalize();
+	/* Any further writes will be ignored */
+	_sound_asset_writer.reset();
+
+	if (!written) {
 		/* Nothing was written to the sound asset */
-		_sound_asset.reset ();
+		_sound_asset.reset();
+		return;
 	}
 
 	/* Move the audio asset into the DCP */
-	if (_sound_asset) {
-		boost::filesystem::path audio_to = output_dcp;
-		auto const aaf = audio_asset_filename (_sound_asset, _reel_index, _reel_count, _content_summary);
-		audio_to /= aaf;
+	auto const aaf = audio_asset_filename (_sound_asset, _reel_index, _reel_count, _content_summary);
+	auto const audio_to = _output_dir / aaf;
+
+	boost::system::error_code ec;
+	dcp::filesystem::rename(film()->file(aaf), audio_to, ec);
+	if (ec) {
+		throw FileError (
+			String::compose(_("could not move audio asset into the DCP (%1)"), error_details(ec)), aaf
+			);
+	}
 
-		boost::system::error_code ec;
-		dcp::filesystem::rename(film()->file(aaf), audio_to, ec);
-		if (ec) {
-			throw FileError (
-				String::compose(_("could not move audio asset into the DCP (%1)"), error_details(ec)), aaf
-				);
-		}
+	_sound_asset->set_file (audio_to);
+}
 
-		_sound_asset->set_file (audio_to);
-	}
+
+void
+ReelWriter::finish (boost::filesystem::path output_dcp)
+{
+	finish_picture();
+	finish_sound();
 
 	if (_atmos_asset) {
 		_atmos_asset_writer->finalize ();
@@ -732,9 +765,14 @@ ReelWriter::create_reel (
 
 /** @param set_progress Method to call with progress; first parameter is the number of bytes
  *  done, second parameter is the number of bytes in total.
+ *  @param wait_for_digest Method to call with each asset before we calculate its digest, which should
+ *  wait for any calculation of that digest which is already happening and pass on its progress.
  */
 void
-ReelWriter::calculate_digests(std::function<void (int64_t, int64_t)> set_progress)
+ReelWriter::calculate_digests(
+	std::function<void (int64_t, int64_t)> set_progress,
+	std::function<void (shared_ptr<const dcp::Asset>, std::function<void (int64_t, int64_t)>)> wait_for_digest
+	)
 try
 {
 	vector<shared_ptr<const dcp::Asset>> assets;
@@ -759,9 +797,11 @@ try
 
 	int64_t total_done = 0;
 	for (auto asset: assets) {
-		asset->hash([&total_done, total_size, set_progress](int64_t done, int64_t) {
+		auto progress = [&total_done, total_size, set_progress](int64_t done, int64_t) {
 			set_progress(total_done + done, total_size);
-		});
+		};
+		wait_for_digest(asset, progress);
+		asset->hash(progress);
 		total_done += asset->file() ? boost::filesystem::file_size(*asset->file()) : 0;
 	}
 
@@ -772,6 +812,26 @@ try
 }
 
 
+/** @return the picture asset that we are writing or re-using, if there is one */
+shared_ptr<const dcp::Asset>
+ReelWriter::picture_asset() const
+{
+	if (_j2k_picture_asset) {
+		return _j2k_picture_asset;
+	}
+
+	return _mpeg2_picture_asset;
+}
+
+
+/** @return the sound asset that we are writing, if there is one */
+shared_ptr<const dcp::Asset>
+ReelWriter::sound_asset() const
+{
+	return _sound_asset;
+}
+
+
 Frame
 ReelWriter::start () const
 {
@@ -44,6 +44,7 @@ class Job;
 struct write_frame_info_test;
 
 namespace dcp {
+	class Asset;
 	class AtmosAsset;
 	class MonoJ2KPictureAsset;
 	class MonoJ2KPictureAssetWriter;
@@ -82,6 +83,8 @@ public:
 	void write (std::shared_ptr<const dcp::AtmosFrame> atmos, AtmosMetadata metadata);
 	void write(std::shared_ptr<dcp::MonoMPEG2PictureFrame> image);
 
+	void finish_picture();
+	void finish_sound();
 	void finish (boost::filesystem::path output_dcp);
 	std::shared_ptr<dcp::Reel> create_reel (
 		std::list<ReferencedReelAsset> const & refs,
@@ -89,7 +92,10 @@ public:
 		bool ensure_subtitles,
 		std::set<DCPTextTrack> ensure_closed_captions
 		);
-	void calculate_digests(std::function<void (int64_t, int64_t)> set_progress);
+	void calculate_digests(
+		std::function<void (int64_t, int64_t)> set_progress,
+		std::function<void (std::shared_ptr<const dcp::Asset>, std::function<void (int64_t, int64_t)>)> wait_for_digest
+		);
 
 	Frame start () const;
 
@@ -101,6 +107,9 @@ public:
 		return _first_nonexistent_frame;
 	}
 
+	std::shared_ptr<const dcp::Asset> picture_asset() const;
+	std::shared_ptr<const dcp::Asset> sound_asset() const;
+
 private:
 
 	friend struct ::write_frame_info_test;
@@ -19,21 +19,33 @@
 */
 
 
+#include "compose.hpp"
+#include "config.h"
 #include "dcp_video.h"
+#include "dcpomatic_assert.h"
 #include "dcpomatic_log.h"
+#include "dcpomatic_socket.h"
+#include "exceptions.h"
 #include "j2k_encoder.h"
 #include "remote_j2k_encoder_thread.h"
 #include "util.h"
+#include <dcp/scope_guard.h>
+#include <algorithm>
 
 #include "i18n.h"
 
 
 using std::make_shared;
 using std::shared_ptr;
+using boost::optional;
+
+
+/** Maximum number of frames that we will have on a server at any one time */
+static int const maximum_frames_in_flight = 2;
 
 
 RemoteJ2KEncoderThread::RemoteJ2KEncoderThread(J2KEncoder& encoder, EncodeServerDescription server)
-	: J2KSyncEncoderThread(encoder)
+	: J2KEncoderThread(encoder)
 	, _server(server)
 {
 
@@ -41,40 +53,132 @@ RemoteJ2KEncoderThread::RemoteJ2KEncoderThread(J2KEncoder& encoder, EncodeServer
 
 
 void
-RemoteJ2KEncoderThread::log_thread_start() const
+RemoteJ2KEncoderThread::run()
+try
 {
 	start_of_thread("RemoteJ2KEncoder");
 	LOG_TIMING("start-encoder-thread thread=%1 server=%2", thread_id(), _server.host_name());
+
+	dcp::ScopeGuard in_flight_guard([this]() {
+		boost::this_thread::disable_interruption dis;
+		for (auto const& frame: _in_flight) {
+			_encoder.retry(frame);
+		}
+		_in_flight.clear();
+	});
+
+	while (true) {
+		if (_remote_backoff > 0) {
+			LOG_ERROR(N_("Encoder thread sleeping (due to backoff) for %1s"), _remote_backoff);
+			boost::this_thread::sleep(boost::posix_time::seconds(_remote_backoff));
+		}
+
+		optional<DCPVideo> frame;
+		if (static_cast<int>(_in_flight.size()) < maximum_frames_in_flight) {
+			frame = _encoder.try_pop(this);
+			if (!frame && _in_flight.empty()) {
+				/* There's nothing to do, so don't keep the connection open while we wait */
+				_socket.reset();
+				LOG_TIMING("encoder-sleep thread=%1", thread_id());
+				frame = _encoder.pop(this);
+			}
+		}
+
+		try {
+			if (frame) {
+				LOG_TIMING("encoder-pop thread=%1 frame=%2 eyes=%3", thread_id(), frame->index(), static_cast<int>(frame->eyes()));
+				send(*frame);
+			} else {
+				receive();
+			}
+			if (_remote_backoff > 0) {
+				LOG_GENERAL("%1 was lost, but now she is found; removing backoff", _server.host_name());
+				_remote_backoff = 0;
+			}
+		} catch (std::exception& e) {
+			LOG_ERROR(N_("Remote encode on %1 failed (%2)"), _server.host_name(), e.what());
+			fail();
+		} catch (...) {
+			LOG_ERROR(N_("Remote encode on %1 failed"), _server.host_name());
+			fail();
+		}
+	}
+} catch (boost::thread_interrupted& e) {
+} catch (...) {
+	store_current();
 }
 
 
-shared_ptr<dcp::ArrayData>
-RemoteJ2KEncoderThread::encode(DCPVideo const& frame)
+/** Send a frame to the server, connecting first if necessary */
+void
+RemoteJ2KEncoderThread::send(DCPVideo const& frame)
 {
-	shared_ptr<dcp::ArrayData> encoded;
+	/* Add the frame to _in_flight before doing anything that might fail, so that it
+	 * will be put back on the queue if we can't send it.
+	 */
+	_in_flight.push_back(frame);
+
+	if (!_socket) {
+		auto socket = make_shared<Socket>();
+		socket->set_send_buffer_size(512 * 1024);
+		socket->connect(_server.host_name(), ENCODE_FRAME_PORT);
+		_socket = socket;
+	}
 
-	try {
-		encoded = make_shared<dcp::ArrayData>(frame.encode_remotely(_server));
-		if (_remote_backoff > 0) {
-			LOG_GENERAL("%1 was lost, but now she is found; removing backoff", _server.host_name());
-			_remote_backoff = 0;
-		}
-	} catch (std::exception& e) {
-		LOG_ERROR(
-			N_("Remote encode of %1 on %2 failed (%3)"),
-			frame.index(), _server.host_name(), e.what(), _remote_backoff
-		);
-	} catch (...) {
-		LOG_ERROR(
-			N_("Remote encode of %1 on %2 failed"),
-			frame.index(), _server.host_name(), _remote_backoff
-		);
+	frame.send_to_server(_socket);
+}
+
+
+/** Collect one encoded frame from the server and give it to the encoder */
+void
+RemoteJ2KEncoderThread::receive()
+{
+	DCPOMATIC_ASSERT(_socket);
+
+	auto encoded = DCPVideo::receive_from_server(_socket);
+
+	auto iter = std::find_if(_in_flight.begin(), _in_flight.end(), [&encoded](DCPVideo const& frame) {
+		return frame.index() == encoded.index && frame.eyes() == encoded.eyes;
+	});
+
+	if (iter == _in_flight.end()) {
+		throw NetworkError(String::compose("Server returned unexpected frame %1", encoded.index));
 	}
 
-	if (!encoded && _remote_backoff < 60) {
-		_remote_backoff += 10;
+	boost::this_thread::disable_interruption dis;
+
+	if (encoded.data.size() == 0) {
+		/* The server couldn't encode this frame, but there's nothing wrong with the connection,
+		 * so put the frame back on the queue and carry on.
+		 */
+		LOG_ERROR(N_("Server %1 could not encode frame %2"), _server.host_name(), encoded.index);
+		_encoder.retry(*iter);
+		_in_flight.erase(iter);
+		return;
 	}
 
-	return encoded;
+	_in_flight.erase(iter);
+	_encoder.write(make_shared<dcp::ArrayData>(encoded.data), encoded.index, encoded.eyes, this);
 }
 
+
+/** Called when something has gone wrong with the server; drop the connection, put any
+ *  frames that were being encoded back on the queue and back off for a while.
+ */
+void
+RemoteJ2KEncoderThread::fail()
+{
+	_socket.reset();
+
+	{
+		boost::this_thread::disable_interruption dis;
+		for (auto const& frame: _in_flight) {
+			_encoder.retry(frame);
+		}
+		_in_flight.clear();
+	}
+
+	if (_remote_backoff < 60) {
+		_remote_backoff += 10;
+	}
+}
@@ -1,25 +1,44 @@
+#include "dcp_video.h"
 #include "encode_server_description.h"
-#include "j2k_sync_encoder_thread.h"
+#include "exception_store.h"
+#include "j2k_encoder_thread.h"
+#include <list>
 
 
-class RemoteJ2KEncoderThread : public J2KSyncEncoderThread
+class Socket;
+
+
+/** @class RemoteJ2KEncoderThread
+ *  @brief A thread which sends frames to an encode server and collects the results.
+ *
+ *  The connection to the server is kept open while there is work to do, and
+ *  several frames may be sent before the first result is collected so that the
+ *  server need not sit idle while data is travelling over the network.
+ */
+class RemoteJ2KEncoderThread : public J2KEncoderThread, public ExceptionStore
 {
 public:
 	RemoteJ2KEncoderThread(J2KEncoder& encoder, EncodeServerDescription server);
 
-	void log_thread_start() const override;
-	std::shared_ptr<dcp::ArrayData> encode(DCPVideo const& frame) override;
+	void run() override;
 
 	EncodeServerDescription server() const {
 		return _server;
 	}
 
-	int backoff() const override {
+	int backoff() const {
 		return _remote_backoff;
 	}
 
 private:
+	void send(DCPVideo const& frame);
+	void receive();
+	void fail();
+
 	EncodeServerDescription _server;
+	std::shared_ptr<Socket> _socket;
+	/** Frames which have been sent to the server but not yet received back */
+	std::list<DCPVideo> _in_flight;
 	/** Number of seconds that we currently wait between attempts to connect to the server */
 	int _remote_backoff = 0;
 };
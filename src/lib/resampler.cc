@@ -86,31 +86,25 @@ Resampler::run (shared_ptr<const AudioBuffers> in)
 	int in_frames = in->frames ();
 	int in_offset = 0;
 	int out_offset = 0;
-	auto resampled = make_shared<AudioBuffers>(_channels, 0);
+
+	/* libsamplerate needs interleaved data, so interleave all the input once */
+	_in_buffer.resize(in_frames * _channels);
+	in->interleave_to(_in_buffer.data(), _channels, in_frames, 0);
 
 	while (in_frames > 0) {
 
 		/* Compute the resampled frames count and add 32 for luck */
 		int const max_resampled_frames = ceil (static_cast<double>(in_frames) * _out_rate / _in_rate) + 32;
+		if (_out_buffer.size() < static_cast<size_t>((out_offset + max_resampled_frames) * _channels)) {
+			_out_buffer.resize((out_offset + max_resampled_frames) * _channels);
+		}
 
 		SRC_DATA data;
-		std::vector<float> in_buffer(in_frames * _channels);
-		std::vector<float> out_buffer(max_resampled_frames * _channels);
-
-		{
-			auto p = in->data ();
-			auto q = in_buffer.data();
-			for (int i = 0; i < in_frames; ++i) {
-				for (int j = 0; j < _channels; ++j) {
-					*q++ = p[j][in_offset + i];
-				}
-			}
-		}
 
-		data.data_in = in_buffer.data();
+		data.data_in = _in_buffer.data() + in_offset * _channels;
 		data.input_frames = in_frames;
 
-		data.data_out = out_buffer.data();
+		data.data_out = _out_buffer.data() + out_offset * _channels;
 		data.output_frames = max_resampled_frames;
 
 		data.end_of_input = 0;
@@ -133,23 +127,13 @@ Resampler::run (shared_ptr<const AudioBuffers> in)
 			break;
 		}
 
-		resampled->set_frames (out_offset + data.output_frames_gen);
-
-		{
-			auto p = data.data_out;
-			auto q = resampled->data ();
-			for (int i = 0; i < data.output_frames_gen; ++i) {
-				for (int j = 0; j < _channels; ++j) {
-					q[j][out_offset + i] = *p++;
-				}
-			}
-		}
-
 		in_frames -= data.input_frames_used;
 		in_offset += data.input_frames_used;
 		out_offset += data.output_frames_gen;
 	}
 
+	auto resampled = make_shared<AudioBuffers>(_channels, out_offset);
+	resampled->deinterleave_from(_out_buffer.data(), _channels, out_offset, 0);
 	return resampled;
 }
 
@@ -157,17 +141,15 @@ Resampler::run (shared_ptr<const AudioBuffers> in)
 shared_ptr<const AudioBuffers>
 Resampler::flush ()
 {
-	auto out = make_shared<AudioBuffers>(_channels, 0);
-	int out_offset = 0;
 	int64_t const output_size = 65536;
 
 	float dummy[1];
-	std::vector<float> buffer(output_size);
+	_out_buffer.resize(output_size * _channels);
 
 	SRC_DATA data;
 	data.data_in = dummy;
 	data.input_frames = 0;
-	data.data_out = buffer.data();
+	data.data_out = _out_buffer.data();
 	data.output_frames = output_size;
 	data.end_of_input = 1;
 	data.src_ratio = double (_out_rate) / _in_rate;
@@ -177,18 +159,8 @@ Resampler::flush ()
 		throw EncodeError (String::compose(N_("could not run sample-rate converter (%1)"), src_strerror(r)));
 	}
 
-	out->set_frames (out_offset + data.output_frames_gen);
-
-	auto p = data.data_out;
-	auto q = out->data ();
-	for (int i = 0; i < data.output_frames_gen; ++i) {
-		for (int j = 0; j < _channels; ++j) {
-			q[j][out_offset + i] = *p++;
-		}
-	}
-
-	out_offset += data.output_frames_gen;
-
+	auto out = make_shared<AudioBuffers>(_channels, data.output_frames_gen);
+	out->deinterleave_from(data.data_out, _channels, data.output_frames_gen, 0);
 	return out;
 }
 
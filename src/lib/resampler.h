@@ -21,6 +21,7 @@
 
 #include <samplerate.h>
 #include <memory>
+#include <vector>
 
 
 class AudioBuffers;
@@ -49,4 +50,8 @@ private:
 	int _in_rate;
 	int _out_rate;
 	int _channels;
+	/** interleaved input for libsamplerate, kept to avoid re-allocating it every time */
+	std::vector<float> _in_buffer;
+	/** interleaved output from libsamplerate, kept to avoid re-allocating it every time */
+	std::vector<float> _out_buffer;
 };
@@ -26,11 +26,17 @@
 #include "kdm_util.h"
 #include "kdm_with_metadata.h"
 #include "screen.h"
+#include <dcp/certificate_chain.h>
 #include <libxml++/libxml++.h>
 #include <boost/algorithm/string.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/thread.hpp>
+#include <algorithm>
+#include <atomic>
+#include <exception>
 
 
+using std::exception_ptr;
 using std::list;
 using std::make_shared;
 using std::shared_ptr;
@@ -51,6 +57,37 @@ Screen::trusted_device_thumbprints () const
 }
 
 
+static
+KDMWithMetadataPtr
+encrypt_kdm_for_screen(
+	dcp::DecryptedKDM const& decrypted,
+	shared_ptr<const dcp::CertificateChain> signer,
+	CinemaID cinema_id,
+	Cinema const& cinema,
+	Screen const& screen,
+	dcp::LocalTime valid_from,
+	dcp::LocalTime valid_to,
+	dcp::Formulation formulation,
+	bool disable_forensic_marking_picture,
+	optional<int> disable_forensic_marking_audio
+	)
+{
+	auto kdm = decrypted.encrypt(
+		signer, screen.recipient().get(), screen.trusted_device_thumbprints(), formulation, disable_forensic_marking_picture, disable_forensic_marking_audio
+		);
+
+	dcp::NameFormat::Map name_values;
+	name_values['c'] = cinema.name;
+	name_values['s'] = screen.name;
+	name_values['f'] = kdm.content_title_text();
+	name_values['b'] = valid_from.date() + " " + valid_from.time_of_day(true, false);
+	name_values['e'] = valid_to.date() + " " + valid_to.time_of_day(true, false);
+	name_values['i'] = kdm.cpl_id();
+
+	return make_shared<KDMWithMetadata>(name_values, cinema_id, cinema.emails, kdm);
+}
+
+
 KDMWithMetadataPtr
 kdm_for_screen (
 	std::function<dcp::DecryptedKDM (dcp::LocalTime, dcp::LocalTime)> make_kdm,
@@ -76,18 +113,87 @@ kdm_for_screen (
 		throw InvalidSignerError();
 	}
 
-	auto kdm = make_kdm(valid_from, valid_to).encrypt(
-		signer, screen.recipient().get(), screen.trusted_device_thumbprints(), formulation, disable_forensic_marking_picture, disable_forensic_marking_audio
+	return encrypt_kdm_for_screen(
+		make_kdm(valid_from, valid_to), signer, cinema_id, cinema, screen, valid_from, valid_to, formulation, disable_forensic_marking_picture, disable_forensic_marking_audio
 		);
+}
 
-	dcp::NameFormat::Map name_values;
-	name_values['c'] = cinema.name;
-	name_values['s'] = screen.name;
-	name_values['f'] = kdm.content_title_text();
-	name_values['b'] = valid_from.date() + " " + valid_from.time_of_day(true, false);
-	name_values['e'] = valid_to.date() + " " + valid_to.time_of_day(true, false);
-	name_values['i'] = kdm.cpl_id();
 
-	return make_shared<KDMWithMetadata>(name_values, cinema_id, cinema.emails, kdm);
-}
+/** Make KDMs for a list of screens which all have the same validity period.  make_kdm is called
+ *  only once, and the KDMs are then encrypted and signed for each screen using a few threads.
+ *  @return KDMs in the same order as the screens (screens without a recipient certificate are skipped).
+ */
+list<KDMWithMetadataPtr>
+kdms_for_screens(
+	std::function<dcp::DecryptedKDM (dcp::LocalTime, dcp::LocalTime)> make_kdm,
+	vector<ScreenDetails> const& screens,
+	dcp::LocalTime valid_from,
+	dcp::LocalTime valid_to,
+	dcp::Formulation formulation,
+	bool disable_forensic_marking_picture,
+	optional<int> disable_forensic_marking_audio,
+	vector<KDMCertificatePeriod>& period_checks
+	)
+{
+	vector<size_t> to_make;
+	for (size_t i = 0; i < screens.size(); ++i) {
+		auto const& screen = screens[i].screen;
+		if (screen.recipient()) {
+			period_checks.push_back(check_kdm_and_certificate_validity_periods(screens[i].cinema.name, screen.name, screen.recipient().get(), valid_from, valid_to));
+			to_make.push_back(i);
+		}
+	}
+
+	if (to_make.empty()) {
+		return {};
+	}
+
+	auto signer = Config::instance()->signer_chain();
+	if (!signer->valid()) {
+		throw InvalidSignerError();
+	}
+
+	/* Reading the CPL and decrypting any imported keys only needs to be done once */
+	auto const decrypted = make_kdm(valid_from, valid_to);
+
+	vector<KDMWithMetadataPtr> kdms(to_make.size());
+	vector<exception_ptr> errors(to_make.size());
+	std::atomic<size_t> next(0);
+
+	auto worker = [&]() {
+		while (true) {
+			auto const index = next++;
+			if (index >= to_make.size()) {
+				return;
+			}
+			auto const& details = screens[to_make[index]];
+			try {
+				kdms[index] = encrypt_kdm_for_screen(
+					decrypted, signer, details.cinema_id, details.cinema, details.screen,
+					valid_from, valid_to, formulation, disable_forensic_marking_picture, disable_forensic_marking_audio
+					);
+			} catch (...) {
+				errors[index] = std::current_exception();
+			}
+		}
+	};
+
+	auto const threads = std::min(to_make.size(), static_cast<size_t>(std::max(1U, boost::thread::hardware_concurrency())));
+	if (threads == 1) {
+		worker();
+	} else {
+		boost::thread_group pool;
+		for (size_t i = 0; i < threads; ++i) {
+			pool.create_thread(worker);
+		}
+		pool.join_all();
+	}
 
+	for (auto const& error: errors) {
+		if (error) {
+			std::rethrow_exception(error);
+		}
+	}
+
+	return list<KDMWithMetadataPtr>(kdms.begin(), kdms.end());
+}
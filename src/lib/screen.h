@@ -23,6 +23,7 @@
 #define DCPOMATIC_SCREEN_H
 
 
+#include "cinema.h"
 #include "cinema_list.h"
 #include "kdm_recipient.h"
 #include "kdm_util.h"
@@ -33,10 +34,10 @@
 #include <dcp/utc_offset.h>
 #include <libcxml/cxml.h>
 #include <boost/optional.hpp>
+#include <list>
 #include <string>
 
 
-class Cinema;
 class Film;
 
 
@@ -97,4 +98,33 @@ kdm_for_screen (
 	);
 
 
+/** A screen that we want to make a KDM for, and the cinema that it is in */
+class ScreenDetails
+{
+public:
+	ScreenDetails(CinemaID const& cinema_id_, Cinema const& cinema_, dcpomatic::Screen const& screen_)
+		: cinema_id(cinema_id_)
+		, cinema(cinema_)
+		, screen(screen_)
+	{}
+
+	CinemaID cinema_id;
+	Cinema cinema;
+	dcpomatic::Screen screen;
+};
+
+
+std::list<KDMWithMetadataPtr>
+kdms_for_screens(
+	std::function<dcp::DecryptedKDM (dcp::LocalTime, dcp::LocalTime)> make_kdm,
+	std::vector<ScreenDetails> const& screens,
+	dcp::LocalTime valid_from,
+	dcp::LocalTime valid_to,
+	dcp::Formulation formulation,
+	bool disable_forensic_marking_picture,
+	boost::optional<int> disable_forensic_marking_audio,
+	std::vector<KDMCertificatePeriod>& period_checks
+	);
+
+
 #endif
@@ -0,0 +1,179 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#include "config.h"
+#include "dcpomatic_assert.h"
+#include "slice_threads.h"
+#include "util.h"
+#include <algorithm>
+
+
+using std::make_shared;
+using std::min;
+using std::shared_ptr;
+
+
+SliceThreads* SliceThreads::_instance = nullptr;
+boost::mutex SliceThreads::_instance_mutex;
+
+
+SliceThreads::~SliceThreads()
+{
+	/* Our threads only wait (and so can be interrupted) when they have no bands to run */
+	_threads.interrupt_all();
+	_threads.join_all();
+}
+
+
+SliceThreads*
+SliceThreads::instance()
+{
+	/* This is called from lots of encoding threads */
+	boost::mutex::scoped_lock lm(_instance_mutex);
+	if (!_instance) {
+		_instance = new SliceThreads();
+	}
+
+	return _instance;
+}
+
+
+/** Stop and destroy the pool.  This must only be called when nothing can be using it */
+void
+SliceThreads::drop()
+{
+	boost::mutex::scoped_lock lm(_instance_mutex);
+	delete _instance;
+	_instance = nullptr;
+}
+
+
+int
+SliceThreads::threads() const
+{
+	return std::max(1, Config::instance()->slice_threads());
+}
+
+
+/** Run a task over some lines of an image, splitting them into bands which are processed in parallel.
+ *  The calling thread processes bands as well, and this method returns once all bands are finished.
+ *  @param lines Number of lines.
+ *  @param alignment Each band (apart from the last) will contain a multiple of this many lines.
+ *  @param task Task to run; it is passed the first line of the band and the line after the last.
+ */
+void
+SliceThreads::run(int lines, int alignment, std::function<void (int, int)> task)
+{
+	DCPOMATIC_ASSERT(alignment > 0);
+
+	int const bands = min(threads(), lines / alignment);
+	if (bands <= 1) {
+		task(0, lines);
+		return;
+	}
+
+	auto job = make_shared<Job>();
+	job->task = task;
+	int const band_lines = (lines / bands / alignment) * alignment;
+	for (int i = 0; i < bands; ++i) {
+		job->bands.push_back({i * band_lines, i == (bands - 1) ? lines : (i + 1) * band_lines});
+	}
+	job->remaining = job->bands.size();
+
+	boost::mutex::scoped_lock lm(_mutex);
+
+	/* We do one band in this thread, so we need one fewer than the number of bands */
+	while (_thread_count < (bands - 1)) {
+		_threads.create_thread(boost::bind(&SliceThreads::thread, this));
+		++_thread_count;
+	}
+
+	_jobs.push_back(job);
+	_work.notify_all();
+
+	while (run_band(job, lm)) {}
+
+	{
+		/* Our bands may refer to things that our caller owns, so we must not return (or
+		 * throw) until they are all finished.  Any interruption will happen at the caller's
+		 * next interruption point instead.
+		 */
+		boost::this_thread::disable_interruption dis;
+		while (job->remaining > 0) {
+			_done.wait(lm);
+		}
+	}
+
+	if (job->exception) {
+		std::rethrow_exception(job->exception);
+	}
+}
+
+
+/** Run the next band of a job, if there is one.  Must be called with _mutex held by lock.
+ *  @return true if a band was run.
+ */
+bool
+SliceThreads::run_band(shared_ptr<Job> job, boost::mutex::scoped_lock& lock)
+{
+	if (job->next == job->bands.size()) {
+		return false;
+	}
+
+	auto const band = job->bands[job->next++];
+	if (job->next == job->bands.size()) {
+		_jobs.remove(job);
+	}
+
+	lock.unlock();
+	std::exception_ptr exception;
+	try {
+		job->task(band.first, band.second);
+	} catch (...) {
+		exception = std::current_exception();
+	}
+	lock.lock();
+
+	if (exception && !job->exception) {
+		job->exception = exception;
+	}
+
+	if (--job->remaining == 0) {
+		_done.notify_all();
+	}
+
+	return true;
+}
+
+
+void
+SliceThreads::thread()
+{
+	start_of_thread("SliceThreads");
+
+	boost::mutex::scoped_lock lm(_mutex);
+	while (true) {
+		while (_jobs.empty()) {
+			_work.wait(lm);
+		}
+		run_band(_jobs.front(), lm);
+	}
+}
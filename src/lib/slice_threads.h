@@ -0,0 +1,90 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#ifndef DCPOMATIC_SLICE_THREADS_H
+#define DCPOMATIC_SLICE_THREADS_H
+
+
+#include <boost/thread.hpp>
+#include <boost/thread/condition.hpp>
+#include <exception>
+#include <functional>
+#include <list>
+#include <memory>
+#include <vector>
+
+
+/** @class SliceThreads
+ *  @brief A pool of threads which can be used to process horizontal bands of a single image at the same time.
+ *
+ *  The number of bands that an image is split into is taken from Config::slice_threads().
+ */
+class SliceThreads
+{
+public:
+	~SliceThreads();
+
+	SliceThreads(SliceThreads const&) = delete;
+	SliceThreads& operator=(SliceThreads const&) = delete;
+
+	/** @return number of bands that run() will split work into (at most) */
+	int threads() const;
+
+	void run(int lines, int alignment, std::function<void (int, int)> task);
+
+	static SliceThreads* instance();
+	static void drop();
+
+private:
+	SliceThreads() = default;
+
+	struct Job
+	{
+		std::function<void (int, int)> task;
+		/** start and end lines of each band */
+		std::vector<std::pair<int, int>> bands;
+		/** index of the next band to be started */
+		size_t next = 0;
+		/** number of bands that have not yet finished */
+		size_t remaining = 0;
+		std::exception_ptr exception;
+	};
+
+	bool run_band(std::shared_ptr<Job> job, boost::mutex::scoped_lock& lock);
+	void thread();
+
+	static SliceThreads* _instance;
+	static boost::mutex _instance_mutex;
+
+	/** mutex for everything below */
+	mutable boost::mutex _mutex;
+	/** notified when a job is added */
+	boost::condition _work;
+	/** notified when a band has finished */
+	boost::condition _done;
+	/** jobs that still have bands to be started */
+	std::list<std::shared_ptr<Job>> _jobs;
+	boost::thread_group _threads;
+	int _thread_count = 0;
+};
+
+
+#endif
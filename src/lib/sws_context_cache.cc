@@ -0,0 +1,328 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#include "dcpomatic_assert.h"
+#include "enum_indexed_vector.h"
+#include "sws_context_cache.h"
+#include <dcp/warnings.h>
+LIBDCP_DISABLE_WARNINGS
+extern "C" {
+#include <libavutil/frame.h>
+#include <libavutil/opt.h>
+#include <libavutil/pixdesc.h>
+#include <libswscale/swscale.h>
+}
+LIBDCP_ENABLE_WARNINGS
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
+#include <atomic>
+#include <chrono>
+#include <list>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+
+#include "i18n.h"
+
+
+using std::list;
+using std::pair;
+
+
+/** Number of contexts to keep for each thread */
+static int const contexts_per_thread = 4;
+
+/** Total number of libswscale threads that our contexts have, counting only those contexts
+ *  which use more than one.  Every thread can keep several contexts, so if each one had the
+ *  threads that it asked for there could be very many of them.
+ */
+static std::atomic<int> threads_in_use(0);
+
+
+namespace {
+
+struct Context
+{
+	SwsContextCache::Parameters parameters;
+	SwsContext* context;
+	/** number of threads that the context really uses, which may be fewer than parameters asked for */
+	int threads;
+};
+
+
+void
+free_context(Context const& context)
+{
+	sws_freeContext(context.context);
+	if (context.threads > 1) {
+		threads_in_use -= context.threads;
+	}
+}
+
+
+/** The contexts belonging to one thread, most-recently used first */
+class Contexts
+{
+public:
+	Contexts () = default;
+
+	Contexts (Contexts const&) = delete;
+	Contexts& operator= (Contexts const&) = delete;
+
+	~Contexts ()
+	{
+		for (auto const& context: contexts) {
+			free_context(context);
+		}
+	}
+
+	list<Context> contexts;
+};
+
+}
+
+
+static boost::thread_specific_ptr<Contexts> thread_contexts;
+static boost::mutex statistics_mutex;
+static SwsContextCache::Statistics cache_statistics;
+
+
+bool
+SwsContextCache::Parameters::operator== (Parameters const& other) const
+{
+	return in_size == other.in_size &&
+		in_format == other.in_format &&
+		out_size == other.out_size &&
+		out_format == other.out_format &&
+		flags == other.flags &&
+		yuv_to_rgb == other.yuv_to_rgb &&
+		in_full_range == other.in_full_range &&
+		out_full_range == other.out_full_range &&
+		threads == other.threads;
+}
+
+
+/** @param parameters Parameters to use; parameters.threads is taken as the most threads
+ *  that all our contexts together may use.
+ */
+static Context
+make_context (SwsContextCache::Parameters parameters)
+{
+	if (parameters.threads > 1) {
+		int none = 0;
+		if (!threads_in_use.compare_exchange_strong(none, parameters.threads)) {
+			/* Some other context has the threads, so this one must make do without */
+			parameters.threads = 1;
+		}
+	}
+
+	SwsContext* context = nullptr;
+
+	if (parameters.threads == 1) {
+		context = sws_getContext (
+			parameters.in_size.width, parameters.in_size.height, parameters.in_format,
+			parameters.out_size.width, parameters.out_size.height, parameters.out_format,
+			parameters.flags, 0, 0, 0
+			);
+	} else {
+		/* sws_getContext() can't ask for slice threads, so we have to do it the long way */
+		context = sws_alloc_context();
+		if (context) {
+			av_opt_set_int(context, "srcw", parameters.in_size.width, 0);
+			av_opt_set_int(context, "srch", parameters.in_size.height, 0);
+			av_opt_set_int(context, "src_format", parameters.in_format, 0);
+			av_opt_set_int(context, "dstw", parameters.out_size.width, 0);
+			av_opt_set_int(context, "dsth", parameters.out_size.height, 0);
+			av_opt_set_int(context, "dst_format", parameters.out_format, 0);
+			av_opt_set_int(context, "sws_flags", parameters.flags, 0);
+			av_opt_set_int(context, "threads", parameters.threads, 0);
+			if (sws_init_context(context, nullptr, nullptr) < 0) {
+				sws_freeContext(context);
+				context = nullptr;
+			}
+		}
+	}
+
+	if (!context) {
+		if (parameters.threads > 1) {
+			threads_in_use -= parameters.threads;
+		}
+		throw std::runtime_error (N_("Could not allocate SwsContext"));
+	}
+
+	DCPOMATIC_ASSERT (parameters.yuv_to_rgb < dcp::YUVToRGB::COUNT);
+	EnumIndexedVector<int, dcp::YUVToRGB> lut;
+	lut[dcp::YUVToRGB::REC601] = SWS_CS_ITU601;
+	lut[dcp::YUVToRGB::REC709] = SWS_CS_ITU709;
+	lut[dcp::YUVToRGB::REC2020] = SWS_CS_BT2020;
+
+	/* The 3rd parameter here is:
+	   0 -> source range MPEG (i.e. "video", 16-235)
+	   1 -> source range JPEG (i.e. "full", 0-255)
+	   And the 5th:
+	   0 -> destination range MPEG (i.e. "video", 16-235)
+	   1 -> destination range JPEG (i.e. "full", 0-255)
+
+	   But remember: sws_setColorspaceDetails ignores these
+	   parameters unless the both source and destination images
+	   are isYUV or isGray.  (If either is not, it uses video range).
+	*/
+	sws_setColorspaceDetails (
+		context,
+		sws_getCoefficients(lut[parameters.yuv_to_rgb]), parameters.in_full_range ? 1 : 0,
+		sws_getCoefficients(lut[parameters.yuv_to_rgb]), parameters.out_full_range ? 1 : 0,
+		0, 1 << 16, 1 << 16
+		);
+
+	return { parameters, context, parameters.threads };
+}
+
+
+/** @return a context for these parameters, which may be one that was used before, and the number
+ *  of threads that it uses.  The context belongs to the cache and must only be used by the calling thread.
+ */
+pair<SwsContext*, int>
+SwsContextCache::get (Parameters const& parameters)
+{
+	if (!thread_contexts.get()) {
+		thread_contexts.reset(new Contexts);
+	}
+
+	auto& contexts = thread_contexts->contexts;
+
+	for (auto i = contexts.begin(); i != contexts.end(); ++i) {
+		if (i->parameters == parameters) {
+			contexts.splice(contexts.begin(), contexts, i);
+			boost::mutex::scoped_lock lm (statistics_mutex);
+			++cache_statistics.reused;
+			return { contexts.front().context, contexts.front().threads };
+		}
+	}
+
+	auto const start = std::chrono::steady_clock::now();
+	auto context = make_context (parameters);
+	std::chrono::duration<double> const taken = std::chrono::steady_clock::now() - start;
+
+	/* Keep the parameters that we were asked for, so that we find this context next time */
+	context.parameters = parameters;
+	contexts.push_front (context);
+	while (static_cast<int>(contexts.size()) > contexts_per_thread) {
+		free_context (contexts.back());
+		contexts.pop_back ();
+	}
+
+	boost::mutex::scoped_lock lm (statistics_mutex);
+	++cache_statistics.made;
+	cache_statistics.setup_time += taken.count();
+	return { context.context, context.threads };
+}
+
+
+SwsContextCache::Statistics
+SwsContextCache::statistics ()
+{
+	boost::mutex::scoped_lock lm (statistics_mutex);
+	return cache_statistics;
+}
+
+
+static void
+noop_free (void*, uint8_t*)
+{
+
+}
+
+
+/** Scale with libswscale's slice threads.  This only works with sws_scale_frame(), so we need to
+ *  wrap our data in AVFrames.
+ */
+static void
+scale_frame (
+	SwsContext* context,
+	SwsContextCache::Parameters const& parameters,
+	uint8_t const* const* in_data, int const* in_stride,
+	uint8_t* const* out_data, int const* out_stride
+	)
+{
+	auto in = av_frame_alloc();
+	auto out = av_frame_alloc();
+	if (!in || !out) {
+		av_frame_free(&in);
+		av_frame_free(&out);
+		throw std::bad_alloc();
+	}
+
+	in->width = parameters.in_size.width;
+	in->height = parameters.in_size.height;
+	in->format = parameters.in_format;
+	for (int i = 0; i < av_pix_fmt_count_planes(parameters.in_format); ++i) {
+		in->data[i] = const_cast<uint8_t*>(in_data[i]);
+		in->linesize[i] = in_stride[i];
+	}
+
+	out->width = parameters.out_size.width;
+	out->height = parameters.out_size.height;
+	out->format = parameters.out_format;
+	for (int i = 0; i < av_pix_fmt_count_planes(parameters.out_format); ++i) {
+		out->data[i] = out_data[i];
+		out->linesize[i] = out_stride[i];
+	}
+
+	/* sws_scale_frame() will copy the input and allocate the output unless the frames look
+	 * reference-counted, so give them buffers which refer to our data but never free it.
+	 */
+	in->buf[0] = av_buffer_create(in->data[0], 1, noop_free, nullptr, AV_BUFFER_FLAG_READONLY);
+	out->buf[0] = av_buffer_create(out->data[0], 1, noop_free, nullptr, 0);
+
+	int const r = (in->buf[0] && out->buf[0]) ? sws_scale_frame(context, out, in) : AVERROR(ENOMEM);
+
+	av_frame_free(&in);
+	av_frame_free(&out);
+
+	if (r < 0) {
+		throw std::runtime_error(N_("Could not scale image"));
+	}
+}
+
+
+/** Scale an image using a suitable context, adding the time taken to our statistics */
+void
+SwsContextCache::scale (
+	Parameters const& parameters,
+	uint8_t const* const* in_data, int const* in_stride,
+	uint8_t* const* out_data, int const* out_stride
+	)
+{
+	SwsContext* context;
+	int threads;
+	std::tie(context, threads) = get(parameters);
+
+	auto const start = std::chrono::steady_clock::now();
+	if (threads == 1) {
+		sws_scale (context, in_data, in_stride, 0, parameters.in_size.height, out_data, out_stride);
+	} else {
+		scale_frame (context, parameters, in_data, in_stride, out_data, out_stride);
+	}
+	std::chrono::duration<double> const taken = std::chrono::steady_clock::now() - start;
+
+	boost::mutex::scoped_lock lm (statistics_mutex);
+	cache_statistics.scale_time += taken.count();
+}
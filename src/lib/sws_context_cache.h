@@ -0,0 +1,92 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#ifndef DCPOMATIC_SWS_CONTEXT_CACHE_H
+#define DCPOMATIC_SWS_CONTEXT_CACHE_H
+
+
+#include <dcp/types.h>
+extern "C" {
+#include <libavutil/pixfmt.h>
+}
+#include <cstdint>
+#include <utility>
+
+
+struct SwsContext;
+
+
+/** @class SwsContextCache
+ *  @brief Cache of libswscale contexts, so that we don't have to set up a new one for every frame.
+ *
+ *  Each thread has its own set of contexts.
+ */
+class SwsContextCache
+{
+public:
+	struct Parameters
+	{
+		dcp::Size in_size;
+		AVPixelFormat in_format;
+		dcp::Size out_size;
+		AVPixelFormat out_format;
+		/** SWS_* flags */
+		int flags;
+		dcp::YUVToRGB yuv_to_rgb;
+		/** true if the input is full range, false for video range */
+		bool in_full_range;
+		/** true if the output is full range, false for video range */
+		bool out_full_range;
+		/** number of threads that libswscale should split the scale across.  This is also
+		 *  the most that all the cached contexts together will use; contexts which are made
+		 *  when that many are already in use get only one.
+		 */
+		int threads = 1;
+
+		bool operator== (Parameters const& other) const;
+	};
+
+	struct Statistics
+	{
+		/** number of contexts that have been set up */
+		int64_t made = 0;
+		/** number of times that an existing context has been used again */
+		int64_t reused = 0;
+		/** total time spent setting up contexts, in seconds */
+		double setup_time = 0;
+		/** total time spent scaling, in seconds */
+		double scale_time = 0;
+	};
+
+	static Statistics statistics ();
+
+	static void scale (
+		Parameters const& parameters,
+		uint8_t const* const* in_data, int const* in_stride,
+		uint8_t* const* out_data, int const* out_stride
+		);
+
+private:
+	static std::pair<SwsContext*, int> get (Parameters const& parameters);
+};
+
+
+#endif
@@ -0,0 +1,41 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+
+#ifndef DCPOMATIC_TARGET_CLONES_H
+#define DCPOMATIC_TARGET_CLONES_H
+
+
+/** Put DCPOMATIC_TARGET_CLONES before a function with loops that the compiler can vectorise
+ *  to have it built for a few instruction sets, with the best one for the CPU being chosen
+ *  at run time.  Where this is not supported the function is built in the normal way.
+ *
+ *  Files that use this should be added to the list in src/lib/wscript which is built with
+ *  -fvect-cost-model=dynamic, as otherwise GCC will not vectorise most loops at -O2.
+ */
+#if defined(DCPOMATIC_LINUX) && defined(__x86_64__) && defined(__GNUC__) && !defined(__clang__)
+#define DCPOMATIC_TARGET_CLONES __attribute__((target_clones("avx2", "sse4.1", "default")))
+#else
+#define DCPOMATIC_TARGET_CLONES
+#endif
+
+
+#endif
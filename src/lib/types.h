@@ -44,8 +44,11 @@ class FFmpegContent;
  *  64 - first version used
  *  65 - v2.16.0 - checksums added to communication
  *  66 - v2.17.x - J2KBandwidth -> VideoBitRate in metadata
+ *  67 - v2.18.x - persistent connections with several frames in flight
+ *  68 - v2.18.x - optional compression of frame data
+ *  69 - v2.18.x - frames which fail to encode are reported rather than closing the connection
  */
-#define SERVER_LINK_VERSION (64+2)
+#define SERVER_LINK_VERSION (64+5)
 
 /** A film of F seconds at f FPS will be Ff frames;
     Consider some delta FPS d, so if we run the same
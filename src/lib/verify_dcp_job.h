@@ -39,6 +39,9 @@ public:
 	std::string name() const override;
 	std::string json_name() const override;
 	void run() override;
+	Resource resource() const override {
+		return Resource::IO;
+	}
 
 	dcp::VerificationResult const& result() const {
 		return _result;
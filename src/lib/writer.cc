@@ -31,6 +31,7 @@
 #include "film.h"
 #include "film_util.h"
 #include "frame_info.h"
+#include "frame_spill.h"
 #include "job.h"
 #include "log.h"
 #include "ratio.h"
@@ -39,6 +40,7 @@
 #include "util.h"
 #include "version.h"
 #include "writer.h"
+#include <dcp/asset.h>
 #include <dcp/cpl.h>
 #include <dcp/mono_mpeg2_picture_frame.h>
 #include <dcp/locale_convert.h>
@@ -46,6 +48,7 @@
 #include <dcp/reel_text_asset.h>
 #include <cerrno>
 #include <cfloat>
+#include <limits>
 #include <set>
 
 #include "i18n.h"
@@ -95,6 +98,7 @@ Writer::Writer(weak_ptr<const Film> weak_film, weak_ptr<Job> weak_job, boost::fi
 	}
 
 	_last_written.resize (reels.size());
+	_spills.resize(reels.size());
 
 	/* We can keep track of the current audio, subtitle and closed caption reels easily because audio
 	   and captions arrive to the Writer in sequence.  This is not so for video.
@@ -131,6 +135,9 @@ Writer::~Writer ()
 	if (!_text_only) {
 		terminate_thread (false);
 	}
+
+	_early_digests.interrupt_all();
+	_early_digests.join_all();
 }
 
 
@@ -165,7 +172,10 @@ Writer::write (shared_ptr<const Data> encoded, Frame frame, Eyes eyes)
 	DCPOMATIC_ASSERT((film()->three_d() && eyes != Eyes::BOTH) || (!film()->three_d() && eyes == Eyes::BOTH));
 
 	qi.eyes = eyes;
-	_queue.push_back(qi);
+	if (!_queue.insert(qi).second) {
+		LOG_WARNING("Writer was given frame %1 (%2) more than once", frame, static_cast<int>(eyes));
+		return;
+	}
 	++_queued_full_in_memory;
 
 	/* Now there's something to do: wake anything wait()ing on _empty_condition */
@@ -196,7 +206,7 @@ Writer::repeat (Frame frame, Eyes eyes)
 {
 	boost::mutex::scoped_lock lock (_state_mutex);
 
-	while (_queue.size() > _maximum_queue_size && have_sequenced_image_at_queue_head()) {
+	while (_queue.size() > _maximum_queue_size && have_sequenced_item()) {
 		/* The queue is too big, and the main writer thread can run and fix it, so
 		   wake it and wait until it has done.
 		*/
@@ -210,12 +220,12 @@ Writer::repeat (Frame frame, Eyes eyes)
 	qi.frame = frame - _reels[qi.reel].start ();
 	if (film()->three_d() && eyes == Eyes::BOTH) {
 		qi.eyes = Eyes::LEFT;
-		_queue.push_back (qi);
+		_queue.insert(qi);
 		qi.eyes = Eyes::RIGHT;
-		_queue.push_back (qi);
+		_queue.insert(qi);
 	} else {
 		qi.eyes = eyes;
-		_queue.push_back (qi);
+		_queue.insert(qi);
 	}
 
 	/* Now there's something to do: wake anything wait()ing on _empty_condition */
@@ -228,7 +238,7 @@ Writer::fake_write (Frame frame, Eyes eyes)
 {
 	boost::mutex::scoped_lock lock (_state_mutex);
 
-	while (_queue.size() > _maximum_queue_size && have_sequenced_image_at_queue_head()) {
+	while (_queue.size() > _maximum_queue_size && have_sequenced_item()) {
 		/* The queue is too big, and the main writer thread can run and fix it, so
 		   wake it and wait until it has done.
 		*/
@@ -244,7 +254,7 @@ Writer::fake_write (Frame frame, Eyes eyes)
 	qi.reel = reel;
 	qi.frame = frame - _reels[reel].start();
 	qi.eyes = eyes;
-	_queue.push_back(qi);
+	_queue.insert(qi);
 
 	/* Now there's something to do: wake anything wait()ing on _empty_condition */
 	_empty_condition.notify_all ();
@@ -279,9 +289,13 @@ Writer::write (shared_ptr<const AudioBuffers> audio, DCPTime const time)
 			/* Easy case: we can write all the audio to this reel */
 			_audio_reel->write (audio);
 			t = end;
+			if (end == _audio_reel->period().to) {
+				/* and that's everything for this reel */
+				finish_audio_reel();
+			}
 		} else if (_audio_reel->period().to <= t) {
 			/* This reel is entirely before the start of our audio; just skip the reel */
-			++_audio_reel;
+			finish_audio_reel();
 		} else {
 			/* This audio is over a reel boundary; split the audio into two and write the first part */
 			DCPTime part_lengths[2] = {
@@ -308,13 +322,27 @@ Writer::write (shared_ptr<const AudioBuffers> audio, DCPTime const time)
 				audio.reset ();
 			}
 
-			++_audio_reel;
+			finish_audio_reel();
 			t += part_lengths[0];
 		}
 	}
 }
 
 
+/** Finish the sound asset of the current audio reel, start calculating its digest
+ *  and move on to the next reel.
+ */
+void
+Writer::finish_audio_reel()
+{
+	_audio_reel->finish_sound();
+	if (auto asset = _audio_reel->sound_asset()) {
+		calculate_digest_early(asset);
+	}
+	++_audio_reel;
+}
+
+
 void
 Writer::write (shared_ptr<const dcp::AtmosFrame> atmos, DCPTime time, AtmosMetadata metadata)
 {
@@ -328,17 +356,37 @@ Writer::write (shared_ptr<const dcp::AtmosFrame> atmos, DCPTime time, AtmosMetad
 }
 
 
-/** Caller must hold a lock on _state_mutex */
-bool
-Writer::have_sequenced_image_at_queue_head ()
+/** Find something in the queue that can be written now; i.e. the next frame for one of the reels.
+ *  Reels are separate assets so a reel does not need to wait for those before it to be finished.
+ *  Caller must hold a lock on _state_mutex.
+ *  @return Item to write, or _queue.end().
+ */
+std::set<QueueItem>::iterator
+Writer::sequenced_item()
 {
-	if (_queue.empty ()) {
-		return false;
+	auto item = _queue.begin();
+	while (item != _queue.end()) {
+		if (_last_written[item->reel].next(*item)) {
+			return item;
+		}
+
+		/* Nothing for this reel; skip to the first item for the next one */
+		QueueItem first;
+		first.type = QueueItem::Type::FULL;
+		first.reel = item->reel + 1;
+		first.frame = std::numeric_limits<int>::min();
+		item = _queue.lower_bound(first);
 	}
 
-	_queue.sort ();
-	auto const & f = _queue.front();
-	return _last_written[f.reel].next(f);
+	return item;
+}
+
+
+/** Caller must hold a lock on _state_mutex */
+bool
+Writer::have_sequenced_item()
+{
+	return sequenced_item() != _queue.end();
 }
 
 
@@ -387,7 +435,7 @@ try
 
 		while (true) {
 
-			if (_finish || _queued_full_in_memory > _maximum_frames_in_memory || have_sequenced_image_at_queue_head ()) {
+			if (_finish || _queued_full_in_memory > _maximum_frames_in_memory || have_sequenced_item()) {
 				/* We've got something to do: go and do it */
 				break;
 			}
@@ -403,9 +451,9 @@ try
 		   case we will never terminate as no new frames will be sent once
 		   _finish is true).
 		*/
-		if (_finish && (!have_sequenced_image_at_queue_head() || _queue.empty())) {
+		if (_finish && (!have_sequenced_item() || _queue.empty())) {
 			/* (Hopefully temporarily) log anything that was not written */
-			if (!_queue.empty() && !have_sequenced_image_at_queue_head()) {
+			if (!_queue.empty() && !have_sequenced_item()) {
 				LOG_WARNING (N_("Finishing writer with a left-over queue of %1:"), _queue.size());
 				for (auto const& i: _queue) {
 					if (i.type == QueueItem::Type::FULL) {
@@ -419,10 +467,10 @@ try
 		}
 
 		/* Write any frames that we can write; i.e. those that are in sequence. */
-		while (have_sequenced_image_at_queue_head ()) {
-			auto qi = _queue.front ();
+		for (auto item = sequenced_item(); item != _queue.end(); item = sequenced_item()) {
+			auto qi = *item;
 			_last_written[qi.reel].update (qi);
-			_queue.pop_front ();
+			_queue.erase(item);
 			if (qi.encoded) {
 				--_queued_full_in_memory;
 			}
@@ -436,7 +484,8 @@ try
 				LOG_DEBUG_ENCODE (N_("Writer FULL-writes %1 (%2)"), qi.frame, (int) qi.eyes);
 				if (!qi.encoded) {
 					/* Get the data back from disk where we stored it temporarily */
-					qi.encoded = make_shared<ArrayData>(film()->j2c_path(qi.reel, qi.frame, qi.eyes, false));
+					DCPOMATIC_ASSERT(_spills[qi.reel]);
+					qi.encoded = _spills[qi.reel]->get(qi.frame, qi.eyes);
 				}
 				reel.write (qi.encoded, qi.frame, qi.eyes);
 				++_full_written;
@@ -453,8 +502,24 @@ try
 				break;
 			}
 
+			if (qi.frame == (reel.period().duration().frames_round(film()->video_frame_rate()) - 1) && qi.eyes != Eyes::LEFT) {
+				/* That was the last frame in this reel, so we can finish its picture asset now
+				 * rather than waiting for the whole DCP.
+				 */
+				LOG_GENERAL("Writer finishes picture for reel %1", qi.reel);
+				reel.finish_picture();
+				if (auto asset = reel.picture_asset()) {
+					calculate_digest_early(asset);
+				}
+			}
+
 			lock.lock ();
-			_full_condition.notify_all ();
+			if (_queued_full_in_memory <= _maximum_frames_in_memory || _queue.size() <= _maximum_queue_size) {
+				/* Only wake anything waiting in write(), repeat() or fake_write() if it might now be
+				 * able to continue; otherwise all the encoder threads would wake on every frame.
+				 */
+				_full_condition.notify_all ();
+			}
 		}
 
 		while (_queued_full_in_memory > _maximum_frames_in_memory) {
@@ -463,7 +528,6 @@ try
 			*/
 
 			/* Find one from the back of the queue */
-			_queue.sort ();
 			auto item = _queue.rbegin();
 			while (item != _queue.rend() && !item->encoded) {
 				++item;
@@ -472,14 +536,18 @@ try
 			DCPOMATIC_ASSERT(item != _queue.rend());
 			++_pushed_to_disk;
 
-			LOG_GENERAL("Writer full; pushes %1 to disk while awaiting %2", item->frame, _last_written[_queue.front().reel].frame() + 1);
+			LOG_GENERAL("Writer full; pushes %1 to disk while awaiting %2", item->frame, _last_written[_queue.begin()->reel].frame() + 1);
 
-			item->encoded->write_via_temp(
-				film()->j2c_path(item->reel, item->frame, item->eyes, true),
-				film()->j2c_path(item->reel, item->frame, item->eyes, false)
-				);
+			auto& spill = _spills[item->reel];
+			if (!spill) {
+				spill.reset(new FrameSpill(film()->j2c_spill_path(item->reel)));
+			}
+			spill->put(item->frame, item->eyes, *item->encoded);
 
-			item->encoded.reset();
+			/* The data isn't part of the ordering, so we can take it out of the item in place */
+			auto node = _queue.extract(std::next(item).base());
+			node.value().encoded.reset();
+			_queue.insert(std::move(node));
 			--_queued_full_in_memory;
 			_full_condition.notify_all ();
 		}
@@ -513,6 +581,72 @@ Writer::terminate_thread (bool can_throw)
 }
 
 
+/** Start calculating the digest of an asset which is complete, in the background.
+ *  The asset will remember its digest, so when calculate_digests() gets to it there
+ *  will be nothing to do.  Digests have to be taken from the finished file (rather than
+ *  as it is written) since the MXF header is rewritten when the asset is finalized.
+ */
+void
+Writer::calculate_digest_early(shared_ptr<const dcp::Asset> asset)
+{
+	{
+		boost::mutex::scoped_lock lm(_early_digests_mutex);
+		_early_digest_progresses[asset] = EarlyDigestProgress();
+	}
+
+	_early_digests.create_thread([this, asset]() {
+		try {
+			asset->hash([this, asset](int64_t done, int64_t) {
+				{
+					boost::mutex::scoped_lock lm(_early_digests_mutex);
+					_early_digest_progresses[asset].done = done;
+				}
+				_early_digests_changed.notify_all();
+				boost::this_thread::interruption_point();
+			});
+		} catch (boost::thread_interrupted&) {
+			/* We're being destroyed */
+		} catch (std::exception& e) {
+			/* calculate_digests() will try again */
+			LOG_WARNING("Could not calculate digest of %1 early (%2)", asset->id(), e.what());
+		}
+
+		{
+			boost::mutex::scoped_lock lm(_early_digests_mutex);
+			_early_digest_progresses[asset].finished = true;
+		}
+		_early_digests_changed.notify_all();
+	});
+}
+
+
+/** Wait for calculate_digest_early() to finish with an asset, if it was given it, as
+ *  calculating the same digest twice at the same time would not go well.
+ *  @param set_progress Method to call with progress while we wait; first parameter is the number
+ *  of bytes of the asset done, second is unused.
+ */
+void
+Writer::wait_for_early_digest(shared_ptr<const dcp::Asset> asset, std::function<void (int64_t, int64_t)> set_progress)
+{
+	boost::mutex::scoped_lock lm(_early_digests_mutex);
+
+	auto iter = _early_digest_progresses.find(asset);
+	if (iter == _early_digest_progresses.end()) {
+		return;
+	}
+
+	while (!iter->second.finished) {
+		auto const done = iter->second.done;
+		lm.unlock();
+		set_progress(done, 0);
+		lm.lock();
+		if (iter->second.done == done && !iter->second.finished) {
+			_early_digests_changed.wait(lm);
+		}
+	}
+}
+
+
 void
 Writer::calculate_digests ()
 {
@@ -548,7 +682,8 @@ Writer::calculate_digests ()
 			dcpomatic::post(context, boost::bind(
 					&ReelWriter::calculate_digests,
 					&i,
-					std::function<void (int64_t, int64_t)>(boost::bind(set_progress, index, _1, _2))
+					std::function<void (int64_t, int64_t)>(boost::bind(set_progress, index, _1, _2)),
+					std::function<void (shared_ptr<const dcp::Asset>, std::function<void (int64_t, int64_t)>)>(boost::bind(&Writer::wait_for_early_digest, this, _1, _2))
 					));
 			++index;
 		}
@@ -570,6 +705,10 @@ Writer::calculate_digests ()
 	}
 
 	context.stop();
+
+	/* The pool will have waited for these, unless it was interrupted */
+	_early_digests.interrupt_all();
+	_early_digests.join_all();
 }
 
 
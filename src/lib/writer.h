@@ -43,14 +43,17 @@
 #include <boost/thread.hpp>
 #include <boost/thread/condition.hpp>
 #include <list>
+#include <set>
 
 
 namespace dcp {
+	class Asset;
 	class Data;
 }
 
 class AudioBuffers;
 class Film;
+class FrameSpill;
 class Job;
 class ReelWriter;
 class ReferencedReelAsset;
@@ -137,13 +140,17 @@ private:
 
 	void thread ();
 	void terminate_thread (bool);
-	bool have_sequenced_image_at_queue_head ();
+	std::set<QueueItem>::iterator sequenced_item();
+	bool have_sequenced_item();
 	size_t video_reel (int frame) const;
 	void set_digest_progress(Job* job, int id, int64_t done, int64_t size);
 	void write_cover_sheet();
 	void calculate_referenced_digests(std::function<void (int64_t, int64_t)> set_progress);
 	void write_hanging_text (ReelWriter& reel);
 	void calculate_digests ();
+	void calculate_digest_early(std::shared_ptr<const dcp::Asset> asset);
+	void wait_for_early_digest(std::shared_ptr<const dcp::Asset> asset, std::function<void (int64_t, int64_t)> set_progress);
+	void finish_audio_reel();
 
 	std::weak_ptr<Job> _job;
 	std::vector<ReelWriter> _reels;
@@ -157,8 +164,10 @@ private:
 	boost::thread _thread;
 	/** true if our thread should finish */
 	bool _finish = false;
-	/** queue of things to write to disk */
-	std::list<QueueItem> _queue;
+	/** things to write to disk, kept in the order that they must be written
+	 *  so that the next one is always at the start.
+	 */
+	std::set<QueueItem> _queue;
 	/** number of FULL frames whose JPEG200 data is currently held in RAM */
 	int _queued_full_in_memory = 0;
 	/** mutex for thread state */
@@ -206,6 +215,25 @@ private:
 	    due to the limit of frames to be held in memory.
 	*/
 	int _pushed_to_disk = 0;
+	/** Files holding frames that have been pushed to disk, indexed by reel; only
+	 *  used by our thread, and created when first needed.
+	 */
+	std::vector<std::unique_ptr<FrameSpill>> _spills;
+
+	/** Threads calculating digests of picture assets which were finished before the
+	 *  rest of the DCP, so that calculate_digests() has less to do.
+	 */
+	boost::thread_group _early_digests;
+	struct EarlyDigestProgress
+	{
+		/** bytes of the asset that have been hashed */
+		int64_t done = 0;
+		bool finished = false;
+	};
+	boost::mutex _early_digests_mutex;
+	/** notified when an early digest makes progress or finishes */
+	boost::condition _early_digests_changed;
+	std::map<std::shared_ptr<const dcp::Asset>, EarlyDigestProgress> _early_digest_progresses;
 
 	bool _text_only;
 
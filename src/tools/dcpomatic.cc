@@ -91,6 +91,7 @@
 #include "lib/screen.h"
 #include "lib/send_kdm_email_job.h"
 #include "lib/signal_manager.h"
+#include "lib/slice_threads.h"
 #include "lib/subtitle_film_encoder.h"
 #include "lib/text_content.h"
 #include "lib/transcode_job.h"
@@ -1738,9 +1739,7 @@ private:
 			if (!_film_to_create.empty ()) {
 				_frame->new_film (_film_to_create, optional<string>());
 				if (!_content_to_add.empty()) {
-					for (auto i: content_factory(_content_to_add)) {
-						_frame->film()->examine_and_add_content(i);
-					}
+					_frame->film()->examine_and_add_content(content_factory(_content_to_add));
 				}
 				if (!_dcp_to_add.empty ()) {
 					_frame->film()->examine_and_add_content(make_shared<DCPContent>(_dcp_to_add));
@@ -1775,6 +1774,13 @@ private:
 		return true;
 	}
 
+	int OnExit() override
+	{
+		/* All our windows, and the jobs, have gone by now, so nothing can be using this */
+		SliceThreads::drop();
+		return wxApp::OnExit();
+	}
+
 	void OnInitCmdLine (wxCmdLineParser& parser) override
 	{
 		parser.SetDesc (command_line_description);
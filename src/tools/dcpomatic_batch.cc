@@ -38,6 +38,7 @@
 #include "lib/job.h"
 #include "lib/job_manager.h"
 #include "lib/make_dcp.h"
+#include "lib/slice_threads.h"
 #include "lib/transcode_job.h"
 #include "lib/util.h"
 #include "lib/version.h"
@@ -512,6 +513,13 @@ class App : public wxApp
 		signal_manager->ui_idle ();
 	}
 
+	int OnExit() override
+	{
+		/* All our windows, and the jobs, have gone by now, so nothing can be using this */
+		SliceThreads::drop();
+		return wxApp::OnExit();
+	}
+
 	void OnInitCmdLine (wxCmdLineParser& parser) override
 	{
 		parser.SetDesc (command_line_description);
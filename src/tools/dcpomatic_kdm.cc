@@ -436,26 +436,22 @@ private:
 
 			CinemaList cinemas;
 
+			vector<ScreenDetails> screens;
 			for (auto i: _screens->screens()) {
-
-				auto kdm = kdm_for_screen(
-					make_kdm,
-					i.first,
-					*cinemas.cinema(i.first),
-					*cinemas.screen(i.second),
-					_timing->from(),
-					_timing->until(),
-					_output->formulation(),
-					!_output->forensic_mark_video(),
-					_output->forensic_mark_audio() ? boost::optional<int>() : 0,
-					period_checks
-					);
-
-				if (kdm) {
-					kdms.push_back(kdm);
-				}
+				screens.emplace_back(i.first, *cinemas.cinema(i.first), *cinemas.screen(i.second));
 			}
 
+			kdms = kdms_for_screens(
+				make_kdm,
+				screens,
+				_timing->from(),
+				_timing->until(),
+				_output->formulation(),
+				!_output->forensic_mark_video(),
+				_output->forensic_mark_audio() ? boost::optional<int>() : 0,
+				period_checks
+				);
+
 			if (kdms.empty()) {
 				return;
 			}
@@ -64,6 +64,7 @@
 #include "lib/ratio.h"
 #include "lib/scoped_temporary.h"
 #include "lib/server.h"
+#include "lib/slice_threads.h"
 #include "lib/text_content.h"
 #include "lib/update_checker.h"
 #include "lib/variant.h"
@@ -1367,6 +1368,13 @@ private:
 		return true;
 	}
 
+	int OnExit() override
+	{
+		/* All our windows, and the jobs, have gone by now, so nothing can be using this */
+		SliceThreads::drop();
+		return wxApp::OnExit();
+	}
+
 	void OnInitCmdLine (wxCmdLineParser& parser) override
 	{
 		parser.SetDesc (command_line_description);
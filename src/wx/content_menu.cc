@@ -394,8 +394,8 @@ ContentMenu::re_examine ()
 		return;
 	}
 
-	for (auto i: _content) {
-		JobManager::instance()->add(make_shared<ExamineContentJob>(film, i, false));
+	if (!_content.empty()) {
+		JobManager::instance()->add(make_shared<ExamineContentJob>(film, _content, false));
 	}
 }
 
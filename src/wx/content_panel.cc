@@ -665,9 +665,9 @@ ContentPanel::add_folder(boost::filesystem::path folder)
 			}
 			ic->set_video_frame_rate(_film, dialog.frame_rate());
 		}
-
-		_film->examine_and_add_content(i);
 	}
+
+	_film->examine_and_add_content(content);
 }
 
 
@@ -963,11 +963,13 @@ ContentPanel::add_files(vector<boost::filesystem::path> paths)
 	/* XXX: check for lots of files here and do something */
 
 	try {
+		vector<shared_ptr<Content>> content;
 		for (auto i: paths) {
 			for (auto j: content_factory(i)) {
-				_film->examine_and_add_content(j);
+				content.push_back(j);
 			}
 		}
+		_film->examine_and_add_content(content);
 	} catch (exception& e) {
 		error_dialog(_parent, std_to_wx(e.what()));
 	}
@@ -134,8 +134,8 @@ ContentView::update ()
 		if (i->finished_in_error()) {
 			error_dialog(this, std_to_wx(i->error_summary()) + char_to_wx(".\n"), std_to_wx(i->error_details()));
 		} else {
-			add (i->content());
-			_content.push_back (i->content());
+			add (i->content().front());
+			_content.push_back (i->content().front());
 		}
 	}
 }
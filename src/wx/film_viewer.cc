@@ -47,6 +47,7 @@
 #include "lib/log.h"
 #include "lib/player.h"
 #include "lib/player_video.h"
+#include "lib/player_video_cache.h"
 #include "lib/ratio.h"
 #include "lib/text_content.h"
 #include "lib/timer.h"
@@ -88,7 +89,8 @@ rtaudio_callback(void* out, void *, unsigned int frames, double, RtAudioStreamSt
 
 
 FilmViewer::FilmViewer(wxWindow* p)
-	: _closed_captions_dialog(new ClosedCaptionsDialog(p, this))
+	: _video_cache(std::make_shared<PlayerVideoCache>(256 * 1024 * 1024))
+	, _closed_captions_dialog(new ClosedCaptionsDialog(p, this))
 {
 #if wxCHECK_VERSION(3, 1, 0)
 	switch (Config::instance()->video_view_type()) {
@@ -162,6 +164,7 @@ FilmViewer::set_film(shared_ptr<Film> film)
 	_closed_captions_dialog->clear();
 
 	destroy_butler();
+	_video_cache->clear();
 
 	if (!_film) {
 		_player = boost::none;
@@ -252,7 +255,8 @@ FilmViewer::create_butler()
 		(opengl && _optimisation != Optimisation::NONE) ? Image::Alignment::COMPACT : Image::Alignment::PADDED,
 		true,
 		opengl && _optimisation == Optimisation::JPEG2000,
-		(Config::instance()->sound() && audio.isStreamOpen()) ? Butler::Audio::ENABLED : Butler::Audio::DISABLED
+		(Config::instance()->sound() && audio.isStreamOpen()) ? Butler::Audio::ENABLED : Butler::Audio::DISABLED,
+		_video_cache
 		);
 
 	_closed_captions_dialog->set_butler(_butler);
@@ -772,6 +776,8 @@ void
 FilmViewer::set_dcp_decode_reduction(optional<int> reduction)
 {
 	_dcp_decode_reduction = reduction;
+	/* Cached images were decoded at the old reduction */
+	_video_cache->clear();
 	if (_player) {
 		_player->set_dcp_decode_reduction(reduction);
 	}
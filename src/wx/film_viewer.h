@@ -48,6 +48,7 @@ class FFmpegPlayer;
 class Image;
 class Player;
 class PlayerVideo;
+class PlayerVideoCache;
 class RGBPlusAlphaImage;
 class wxToggleButton;
 
@@ -201,6 +202,8 @@ private:
 	bool _playing = false;
 	int _suspended = 0;
 	std::shared_ptr<Butler> _butler;
+	/** cache of images shared by the butlers that we create, so that it survives them being re-created */
+	std::shared_ptr<PlayerVideoCache> _video_cache;
 
 	std::list<Frame> _latency_history;
 	/** Mutex to protect _latency_history */
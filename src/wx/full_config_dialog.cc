@@ -1218,6 +1218,10 @@ private:
 		table->Add(_only_servers_encode, 1, wxEXPAND | wxLEFT, DCPOMATIC_SIZER_GAP);
 		table->AddSpacer(0);
 
+		_compress_frames_for_servers = new CheckBox(_panel, _("Compress frames sent to encoding servers"));
+		table->Add(_compress_frames_for_servers, 1, wxEXPAND | wxLEFT, DCPOMATIC_SIZER_GAP);
+		table->AddSpacer(0);
+
 		_layout_for_short_screen = new CheckBox(_panel, _("Layout for short screen"));
 		table->Add(_layout_for_short_screen, 1, wxEXPAND | wxLEFT, DCPOMATIC_SIZER_GAP);
 		table->AddSpacer(0);
@@ -1230,6 +1234,46 @@ private:
 			table->Add(s, 1);
 		}
 
+		{
+			add_label_to_sizer(table, _panel, _("Threads to use for each frame's scaling and colour conversion"), true, 0, wxLEFT | wxRIGHT | wxALIGN_CENTRE_VERTICAL);
+			auto s = new wxBoxSizer(wxHORIZONTAL);
+			_slice_threads = new wxSpinCtrl(_panel);
+			_slice_threads->SetRange(1, 128);
+			s->Add(_slice_threads, 1);
+			table->Add(s, 1);
+		}
+
+		{
+			add_label_to_sizer(table, _panel, _("Memory to keep for re-use by video frames"), true, 0, wxLEFT | wxRIGHT | wxALIGN_CENTRE_VERTICAL);
+			auto s = new wxBoxSizer(wxHORIZONTAL);
+			_image_pool_size = new wxSpinCtrl(_panel);
+			_image_pool_size->SetRange(0, 65536);
+			s->Add(_image_pool_size, 1);
+			add_label_to_sizer(s, _panel, _("MB"), false, 0, wxLEFT | wxALIGN_CENTRE_VERTICAL);
+			table->Add(s, 1);
+		}
+
+		{
+			add_top_aligned_label_to_sizer(table, _panel, _("Maximum jobs to run at once"));
+			auto t = new wxFlexGridSizer(2, DCPOMATIC_SIZER_X_GAP, DCPOMATIC_SIZER_Y_GAP);
+			add_label_to_sizer(t, _panel, _("Encoding"), true, 0, wxALIGN_CENTRE_VERTICAL);
+			_maximum_encode_jobs = new wxSpinCtrl(_panel);
+			t->Add(_maximum_encode_jobs);
+			add_label_to_sizer(t, _panel, _("Reading and writing files"), true, 0, wxALIGN_CENTRE_VERTICAL);
+			_maximum_file_jobs = new wxSpinCtrl(_panel);
+			t->Add(_maximum_file_jobs);
+			add_label_to_sizer(t, _panel, _("Network"), true, 0, wxALIGN_CENTRE_VERTICAL);
+			_maximum_network_jobs = new wxSpinCtrl(_panel);
+			t->Add(_maximum_network_jobs);
+			add_label_to_sizer(t, _panel, _("Analysis"), true, 0, wxALIGN_CENTRE_VERTICAL);
+			_maximum_analysis_jobs = new wxSpinCtrl(_panel);
+			t->Add(_maximum_analysis_jobs);
+			for (auto jobs: { _maximum_encode_jobs, _maximum_file_jobs, _maximum_network_jobs, _maximum_analysis_jobs }) {
+				jobs->SetRange(1, 16);
+			}
+			table->Add(t, 0, wxALL, 6);
+		}
+
 		{
 			auto format = create_label(_panel, _("DCP metadata filename format"), true);
 #ifdef DCPOMATIC_OSX
@@ -1314,8 +1358,15 @@ private:
 		_video_display_mode->Bind(wxEVT_CHOICE, boost::bind(&AdvancedPage::video_display_mode_changed, this));
 		_show_experimental_audio_processors->bind(&AdvancedPage::show_experimental_audio_processors_changed, this);
 		_only_servers_encode->bind(&AdvancedPage::only_servers_encode_changed, this);
+		_compress_frames_for_servers->bind(&AdvancedPage::compress_frames_for_servers_changed, this);
 		_layout_for_short_screen->bind(&AdvancedPage::layout_for_short_screen_changed, this);
 		_frames_in_memory_multiplier->Bind(wxEVT_SPINCTRL, boost::bind(&AdvancedPage::frames_in_memory_multiplier_changed, this));
+		_slice_threads->Bind(wxEVT_SPINCTRL, boost::bind(&AdvancedPage::slice_threads_changed, this));
+		_image_pool_size->Bind(wxEVT_SPINCTRL, boost::bind(&AdvancedPage::image_pool_size_changed, this));
+		_maximum_encode_jobs->Bind(wxEVT_SPINCTRL, boost::bind(&AdvancedPage::maximum_jobs_changed, this));
+		_maximum_file_jobs->Bind(wxEVT_SPINCTRL, boost::bind(&AdvancedPage::maximum_jobs_changed, this));
+		_maximum_network_jobs->Bind(wxEVT_SPINCTRL, boost::bind(&AdvancedPage::maximum_jobs_changed, this));
+		_maximum_analysis_jobs->Bind(wxEVT_SPINCTRL, boost::bind(&AdvancedPage::maximum_jobs_changed, this));
 		_dcp_metadata_filename_format->Changed.connect(boost::bind(&AdvancedPage::dcp_metadata_filename_format_changed, this));
 		_dcp_asset_filename_format->Changed.connect(boost::bind(&AdvancedPage::dcp_asset_filename_format_changed, this));
 		_log_general->bind(&AdvancedPage::log_changed, this);
@@ -1347,6 +1398,7 @@ private:
 		}
 		checked_set(_show_experimental_audio_processors, config->show_experimental_audio_processors());
 		checked_set(_only_servers_encode, config->only_servers_encode());
+		checked_set(_compress_frames_for_servers, config->compress_frames_for_servers());
 		checked_set(_layout_for_short_screen, config->layout_for_short_screen());
 		checked_set(_log_general, config->log_types() & LogEntry::TYPE_GENERAL);
 		checked_set(_log_warning, config->log_types() & LogEntry::TYPE_WARNING);
@@ -1359,6 +1411,12 @@ private:
 		checked_set(_log_debug_player, config->log_types() & LogEntry::TYPE_DEBUG_PLAYER);
 		checked_set(_log_debug_audio_analysis, config->log_types() & LogEntry::TYPE_DEBUG_AUDIO_ANALYSIS);
 		checked_set(_frames_in_memory_multiplier, config->frames_in_memory_multiplier());
+		checked_set(_slice_threads, config->slice_threads());
+		checked_set(_image_pool_size, config->image_pool_size());
+		checked_set(_maximum_encode_jobs, config->maximum_encode_jobs());
+		checked_set(_maximum_file_jobs, config->maximum_file_jobs());
+		checked_set(_maximum_network_jobs, config->maximum_network_jobs());
+		checked_set(_maximum_analysis_jobs, config->maximum_analysis_jobs());
 #ifdef DCPOMATIC_WINDOWS
 		checked_set(_win32_console, config->win32_console());
 #endif
@@ -1378,6 +1436,25 @@ private:
 		Config::instance()->set_frames_in_memory_multiplier(_frames_in_memory_multiplier->GetValue());
 	}
 
+	void slice_threads_changed()
+	{
+		Config::instance()->set_slice_threads(_slice_threads->GetValue());
+	}
+
+	void image_pool_size_changed()
+	{
+		Config::instance()->set_image_pool_size(_image_pool_size->GetValue());
+	}
+
+	void maximum_jobs_changed()
+	{
+		auto config = Config::instance();
+		config->set_maximum_encode_jobs(_maximum_encode_jobs->GetValue());
+		config->set_maximum_file_jobs(_maximum_file_jobs->GetValue());
+		config->set_maximum_network_jobs(_maximum_network_jobs->GetValue());
+		config->set_maximum_analysis_jobs(_maximum_analysis_jobs->GetValue());
+	}
+
 	void show_experimental_audio_processors_changed()
 	{
 		Config::instance()->set_show_experimental_audio_processors(_show_experimental_audio_processors->GetValue());
@@ -1388,6 +1465,11 @@ private:
 		Config::instance()->set_only_servers_encode(_only_servers_encode->GetValue());
 	}
 
+	void compress_frames_for_servers_changed()
+	{
+		Config::instance()->set_compress_frames_for_servers(_compress_frames_for_servers->GetValue());
+	}
+
 	void layout_for_short_screen_changed()
 	{
 		Config::instance()->set_layout_for_short_screen(_layout_for_short_screen->GetValue());
@@ -1448,8 +1530,15 @@ private:
 
 	wxChoice* _video_display_mode = nullptr;
 	wxSpinCtrl* _frames_in_memory_multiplier = nullptr;
+	wxSpinCtrl* _slice_threads = nullptr;
+	wxSpinCtrl* _image_pool_size = nullptr;
+	wxSpinCtrl* _maximum_encode_jobs = nullptr;
+	wxSpinCtrl* _maximum_file_jobs = nullptr;
+	wxSpinCtrl* _maximum_network_jobs = nullptr;
+	wxSpinCtrl* _maximum_analysis_jobs = nullptr;
 	CheckBox* _show_experimental_audio_processors = nullptr;
 	CheckBox* _only_servers_encode = nullptr;
+	CheckBox* _compress_frames_for_servers = nullptr;
 	CheckBox* _layout_for_short_screen = nullptr;
 	NameFormatEditor* _dcp_metadata_filename_format = nullptr;
 	NameFormatEditor* _dcp_asset_filename_format = nullptr;
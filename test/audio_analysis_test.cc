@@ -37,10 +37,12 @@
 #include "lib/ffmpeg_content.h"
 #include "lib/film.h"
 #include "lib/job_manager.h"
+#include "lib/maths_util.h"
 #include "lib/playlist.h"
 #include "lib/ratio.h"
 #include "test.h"
 #include <boost/test/unit_test.hpp>
+#include <cmath>
 #include <numeric>
 
 
@@ -312,3 +314,33 @@ BOOST_AUTO_TEST_CASE(ebur128_test)
 	BOOST_CHECK_CLOSE(six.integrated_loudness().get(), -18.1432, 1);
 	BOOST_CHECK_CLOSE(six.loudness_range().get(), 6.92, 1);
 }
+
+
+BOOST_AUTO_TEST_CASE(accumulate_power_test)
+{
+	for (auto frames: { 0, 1, 7, 8, 9, 100, 1001 }) {
+		vector<float> data(frames);
+		for (auto& i: data) {
+			i = (float(rand()) / RAND_MAX) - 0.5;
+		}
+		if (frames > 3) {
+			/* Something below the minimum */
+			data[3] = 1e-9;
+		}
+
+		float sum = 1;
+		float peak = 0.01;
+		accumulate_power(data.data(), frames, 10e-7, sum, peak);
+
+		float check_sum = 1;
+		float check_peak = 0.01;
+		for (auto i: data) {
+			auto const a = std::max(std::abs(i), 10e-7f);
+			check_sum += a * a;
+			check_peak = std::max(check_peak, a);
+		}
+
+		BOOST_CHECK_CLOSE(sum, check_sum, 1e-3);
+		BOOST_CHECK_EQUAL(peak, check_peak);
+	}
+}
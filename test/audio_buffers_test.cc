@@ -24,6 +24,7 @@
  */
 
 #include <cmath>
+#include <vector>
 #include <boost/test/unit_test.hpp>
 #include "lib/audio_buffers.h"
 
@@ -385,3 +386,44 @@ BOOST_AUTO_TEST_CASE(audio_buffers_set_channels_higher)
 		}
 	}
 }
+
+
+BOOST_AUTO_TEST_CASE(audio_buffers_interleave_test)
+{
+	AudioBuffers buffers(3, 1791);
+	srand(12);
+	random_fill(buffers);
+
+	/* More output channels than we have: the extra one should be silent */
+	std::vector<float> interleaved(4 * 1000);
+	buffers.interleave_to(interleaved.data(), 4, 1000, 791);
+	for (int i = 0; i < 1000; ++i) {
+		for (int c = 0; c < 3; ++c) {
+			BOOST_REQUIRE_EQUAL(interleaved[i * 4 + c], buffers.data(c)[i + 791]);
+		}
+		BOOST_REQUIRE_EQUAL(interleaved[i * 4 + 3], 0);
+	}
+
+	/* ...and back again, ignoring the extra channel */
+	AudioBuffers copy(3, 1200);
+	copy.make_silent();
+	copy.deinterleave_from(interleaved.data(), 4, 1000, 200);
+	for (int i = 0; i < 200; ++i) {
+		for (int c = 0; c < 3; ++c) {
+			BOOST_REQUIRE_EQUAL(copy.data(c)[i], 0);
+		}
+	}
+	for (int i = 0; i < 1000; ++i) {
+		for (int c = 0; c < 3; ++c) {
+			BOOST_REQUIRE_EQUAL(copy.data(c)[i + 200], buffers.data(c)[i + 791]);
+		}
+	}
+
+	/* Fewer output channels than we have */
+	std::vector<float> stereo(2 * 1791);
+	buffers.interleave_to(stereo.data(), 2, 1791, 0);
+	for (int i = 0; i < 1791; ++i) {
+		BOOST_REQUIRE_EQUAL(stereo[i * 2], buffers.data(0)[i]);
+		BOOST_REQUIRE_EQUAL(stereo[i * 2 + 1], buffers.data(1)[i]);
+	}
+}
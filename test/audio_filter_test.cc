@@ -28,6 +28,8 @@
 #include <boost/test/unit_test.hpp>
 #include "lib/audio_filter.h"
 #include "lib/audio_buffers.h"
+#include <cmath>
+#include <cstdlib>
 
 
 using std::make_shared;
@@ -62,6 +64,8 @@ audio_filter_impulse_test_one (AudioFilter& f, int block_size, int num_blocks)
 BOOST_AUTO_TEST_CASE (audio_filter_impulse_kernel_test)
 {
 	AudioFilter f (0.02);
+	/* Exact results are only expected from the direct implementation */
+	f._use_fft = false;
 
 	f._ir.resize(f._M + 1);
 	f._ir[0] = 1;
@@ -81,6 +85,7 @@ BOOST_AUTO_TEST_CASE (audio_filter_impulse_kernel_test)
 BOOST_AUTO_TEST_CASE (audio_filter_impulse_input_test)
 {
 	LowPassAudioFilter lpf (0.02, 0.3);
+	lpf._use_fft = false;
 
 	auto in = make_shared<AudioBuffers>(1, 1751);
 	in->make_silent ();
@@ -96,6 +101,7 @@ BOOST_AUTO_TEST_CASE (audio_filter_impulse_input_test)
 	}
 
 	HighPassAudioFilter hpf (0.02, 0.3);
+	hpf._use_fft = false;
 
 	in = make_shared<AudioBuffers>(1, 9133);
 	in->make_silent ();
@@ -110,3 +116,38 @@ BOOST_AUTO_TEST_CASE (audio_filter_impulse_input_test)
 		}
 	}
 }
+
+
+/** Check that filtering with FFT convolution gives the same results as filtering directly,
+ *  to within rounding error, whatever size of blocks the audio comes in.
+ */
+BOOST_AUTO_TEST_CASE (audio_filter_fft_test)
+{
+	for (auto block_size: { 1, 17, 200, 1751, 2000, 9133 }) {
+		BandPassAudioFilter direct (0.01, 0.05, 0.2);
+		direct._use_fft = false;
+		BandPassAudioFilter fft (0.01, 0.05, 0.2);
+		BOOST_REQUIRE (fft._use_fft);
+
+		srand (1);
+		for (int block = 0; block < 8; ++block) {
+			/* 3 channels so that we check both a pair and a single channel */
+			auto in = make_shared<AudioBuffers>(3, block_size);
+			for (int c = 0; c < 3; ++c) {
+				for (int i = 0; i < block_size; ++i) {
+					in->data(c)[i] = (rand() % 20000 - 10000) / 10000.0f;
+				}
+			}
+
+			auto direct_out = direct.run (in);
+			auto fft_out = fft.run (in);
+			BOOST_REQUIRE (fft._fft);
+
+			for (int c = 0; c < 3; ++c) {
+				for (int i = 0; i < block_size; ++i) {
+					BOOST_REQUIRE_SMALL (std::abs(direct_out->data(c)[i] - fft_out->data(c)[i]), 1e-4f);
+				}
+			}
+		}
+	}
+}
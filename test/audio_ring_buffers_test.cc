@@ -192,3 +192,43 @@ BOOST_AUTO_TEST_CASE (audio_ring_buffers_test3)
 	BOOST_CHECK (!rb.get(buffer, 2, 240));
 	BOOST_CHECK_EQUAL (buffer[240 * 2], CANARY);
 }
+
+
+/** Get audio without interleaving it */
+BOOST_AUTO_TEST_CASE(audio_ring_buffers_planar_test)
+{
+	AudioRingBuffers rb;
+
+	/* Put in two blocks of 3 channels */
+	int value = 0;
+	for (int block = 0; block < 2; ++block) {
+		auto data = make_shared<AudioBuffers>(3, 64);
+		for (int i = 0; i < 64; ++i) {
+			for (int j = 0; j < 3; ++j) {
+				data->data(j)[i] = value++;
+			}
+		}
+		rb.put(data, DCPTime::from_frames(block * 64, 48000), 48000);
+	}
+
+	/* Get some out across the join into 4 channels; the last should be silent */
+	AudioBuffers out(4, 100);
+	BOOST_CHECK(*rb.get(&out, 100) == DCPTime());
+	for (int i = 0; i < 100; ++i) {
+		for (int j = 0; j < 3; ++j) {
+			BOOST_REQUIRE_EQUAL(out.data(j)[i], i * 3 + j);
+		}
+		BOOST_REQUIRE_EQUAL(out.data(3)[i], 0);
+	}
+	BOOST_CHECK_EQUAL(rb.size(), 28);
+
+	/* Get more than is left; the rest should be silent */
+	BOOST_CHECK(*rb.get(&out, 40) == DCPTime::from_frames(100, 48000));
+	for (int i = 0; i < 28; ++i) {
+		BOOST_REQUIRE_EQUAL(out.data(0)[i], (i + 100) * 3);
+	}
+	for (int i = 28; i < 40; ++i) {
+		BOOST_REQUIRE_EQUAL(out.data(0)[i], 0);
+	}
+	BOOST_CHECK_EQUAL(rb.size(), 0);
+}
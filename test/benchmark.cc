@@ -0,0 +1,157 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#include "benchmark.h"
+#include "lib/version.h"
+#include <fmt/format.h>
+#include <boost/thread.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+
+using std::string;
+using std::vector;
+
+
+Benchmark::Benchmark(string name, int frames_per_timing)
+	: _name(name)
+	, _frames_per_timing(frames_per_timing)
+{
+
+}
+
+
+void
+Benchmark::run(int iterations, std::function<void ()> function)
+{
+	function();
+
+	for (int i = 0; i < iterations; ++i) {
+		auto const start = std::chrono::steady_clock::now();
+		function();
+		add(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+	}
+}
+
+
+void
+Benchmark::add(double seconds)
+{
+	_timings.push_back(seconds);
+	_total_seconds += seconds;
+	_total_frames += _frames_per_timing;
+}
+
+
+void
+Benchmark::add_total(double seconds, int64_t frames)
+{
+	_total_seconds += seconds;
+	_total_frames += frames;
+}
+
+
+double
+Benchmark::frames_per_second() const
+{
+	if (_total_seconds == 0) {
+		return 0;
+	}
+
+	return _total_frames / _total_seconds;
+}
+
+
+/** @param p Percentile as a fraction (e.g. 0.9 for the 90th percentile).
+ *  @return Timing at that percentile in seconds, using the nearest-rank method.
+ */
+double
+Benchmark::percentile(double p) const
+{
+	if (_timings.empty()) {
+		return 0;
+	}
+
+	auto sorted = _timings;
+	std::sort(sorted.begin(), sorted.end());
+	auto const rank = static_cast<size_t>(std::ceil(p * sorted.size()));
+	return sorted[std::max(rank, size_t(1)) - 1];
+}
+
+
+string
+Benchmark::summary() const
+{
+	auto s = fmt::format("{:32} {:10.2f} frames/s", _name, frames_per_second());
+	if (!_timings.empty()) {
+		s += fmt::format("  p50 {:.3f}ms  p99 {:.3f}ms", percentile(0.5) * 1000, percentile(0.99) * 1000);
+	}
+	return s;
+}
+
+
+string
+Benchmark::as_json() const
+{
+	auto json = fmt::format(
+		"{{ \"name\": \"{}\", \"frames\": {}, \"seconds\": {:.6f}, \"frames_per_second\": {:.3f}",
+		_name, _total_frames, _total_seconds, frames_per_second()
+		);
+
+	if (!_timings.empty()) {
+		json += fmt::format(
+			", \"timings\": {}, \"frames_per_timing\": {}, \"latency_ms\": {{ \"p50\": {:.4f}, \"p90\": {:.4f}, \"p99\": {:.4f}, \"max\": {:.4f} }}",
+			_timings.size(),
+			_frames_per_timing,
+			percentile(0.5) * 1000,
+			percentile(0.9) * 1000,
+			percentile(0.99) * 1000,
+			percentile(1) * 1000
+			);
+	}
+
+	json += " }";
+	return json;
+}
+
+
+string
+benchmarks_as_json(vector<Benchmark> const& benchmarks)
+{
+	string json = fmt::format(
+		"{{\n  \"version\": \"{}\",\n  \"git_commit\": \"{}\",\n  \"hardware_threads\": {},\n  \"benchmarks\": [\n",
+		dcpomatic_version,
+		dcpomatic_git_commit,
+		boost::thread::hardware_concurrency()
+		);
+
+	for (size_t i = 0; i < benchmarks.size(); ++i) {
+		json += "    " + benchmarks[i].as_json();
+		if (i != benchmarks.size() - 1) {
+			json += ",";
+		}
+		json += "\n";
+	}
+
+	json += "  ]\n}\n";
+	return json;
+}
@@ -0,0 +1,81 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+/** @file  test/benchmark.h
+ *  @brief Benchmark class used by the benchmarks program.
+ */
+
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+
+/** @class Benchmark
+ *  @brief Timings taken from one benchmark.
+ *
+ *  Each timing covers some number of frames (of video, or of whatever
+ *  the benchmark works in).  From these we report the throughput and
+ *  the spread of the time taken by each timing.
+ */
+class Benchmark
+{
+public:
+	/** @param name Name of the benchmark.
+	 *  @param frames_per_timing Number of frames that each call to run()'s function, or to add(), covers.
+	 */
+	Benchmark(std::string name, int frames_per_timing);
+
+	/** Call a function once without timing it, then iterations times timing each call */
+	void run(int iterations, std::function<void ()> function);
+
+	/** Add a timing taken by the caller */
+	void add(double seconds);
+
+	/** Add time which was spent on some frames but which is not one of the timings
+	 *  (for example, finishing off at the end).
+	 */
+	void add_total(double seconds, int64_t frames);
+
+	std::string name() const {
+		return _name;
+	}
+
+	double frames_per_second() const;
+
+	/** @return a one-line summary for people to read */
+	std::string summary() const;
+	std::string as_json() const;
+
+private:
+	double percentile(double p) const;
+
+	std::string _name;
+	int _frames_per_timing;
+	/** time taken by each timing, in seconds */
+	std::vector<double> _timings;
+	double _total_seconds = 0;
+	int64_t _total_frames = 0;
+};
+
+
+extern std::string benchmarks_as_json(std::vector<Benchmark> const& benchmarks);
@@ -0,0 +1,996 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+/** @file  test/benchmarks.cc
+ *  @brief Program to time the main parts of the encode and playback pipelines.
+ *
+ *  All the inputs are made here, so the results depend only on the code and
+ *  the machine.  Results are written as JSON so that they can be compared
+ *  across commits.  Benchmarks of audio count 1/24s of audio as a frame.
+ *
+ *  Some benchmarks come in sets to be compared with each other:
+ *  - pcm_unpack_* against the scalar loops which they replaced (*_scalar).
+ *  - audio_filter_direct_mN against audio_filter_fft_mN for filters of various lengths.
+ *  - j2k_encoder_writer_N_threads for numbers of encoding threads from 1 to 64.
+ *  - export_prores_with_audio against export_prores_video_only.
+ */
+
+
+#include "benchmark.h"
+#include "lib/audio_analyser.h"
+#include "lib/audio_buffers.h"
+#include "lib/audio_filter.h"
+#include "lib/audio_mapping.h"
+#include "lib/butler.h"
+#include "lib/colour_conversion.h"
+#include "lib/config.h"
+#include "lib/content.h"
+#include "lib/content_factory.h"
+#include "lib/cross.h"
+#include "lib/dcp_content_type.h"
+#include "lib/dcp_video.h"
+#include "lib/ffmpeg_film_encoder.h"
+#include "lib/film.h"
+#include "lib/image.h"
+#include "lib/j2k_encoder.h"
+#include "lib/job.h"
+#include "lib/job_manager.h"
+#include "lib/make_dcp.h"
+#include "lib/pcm_unpack.h"
+#include "lib/player.h"
+#include "lib/player_video.h"
+#include "lib/ratio.h"
+#include "lib/raw_image_proxy.h"
+#include "lib/remembered_asset.h"
+#include "lib/resampler.h"
+#include "lib/signal_manager.h"
+#include "lib/state.h"
+#include "lib/string_text_file_content.h"
+#include "lib/text_content.h"
+#include "lib/transcode_job.h"
+#include "lib/util.h"
+#include "lib/writer.h"
+#include <dcp/array_data.h>
+#include <dcp/file.h>
+#include <fmt/format.h>
+#include <sndfile.h>
+#include <boost/filesystem.hpp>
+#include <boost/thread.hpp>
+#include <getopt.h>
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+
+
+using std::cerr;
+using std::cout;
+using std::dynamic_pointer_cast;
+using std::function;
+using std::make_shared;
+using std::pair;
+using std::shared_ptr;
+using std::string;
+using std::vector;
+using std::weak_ptr;
+using boost::optional;
+using namespace dcpomatic;
+
+
+/** Directory for the inputs, the film and our configuration */
+static boost::filesystem::path directory = "build/benchmarks";
+/** Number of timings to take in the quicker benchmarks */
+static int iterations = 32;
+/** Length of the benchmark film in frames */
+static int film_frames = 96;
+/** Film made by benchmark_film() */
+static shared_ptr<Film> cached_film;
+
+static int const audio_channels = 6;
+static int const audio_frames_per_video_frame = 48000 / 24;
+
+
+class BenchmarkSignalManager : public SignalManager
+{
+public:
+	/* Do nothing in this method so that UI events happen in our thread
+	   when we call SignalManager::ui_idle().
+	*/
+	void wake_ui() override {}
+};
+
+
+static double
+seconds_since(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+static AVPixelFormat
+force_rgb24(AVPixelFormat)
+{
+	return AV_PIX_FMT_RGB24;
+}
+
+
+static void
+run_jobs()
+{
+	auto jm = JobManager::instance();
+	while (jm->work_to_do()) {
+		while (signal_manager->ui_idle()) {}
+		dcpomatic_sleep_milliseconds(10);
+	}
+
+	while (signal_manager->ui_idle()) {}
+
+	for (auto job: jm->get()) {
+		if (job->finished_in_error()) {
+			throw std::runtime_error(fmt::format("{} failed: {} {}", job->name(), job->error_summary(), job->error_details()));
+		}
+	}
+}
+
+
+/** Fill an image with a gradient which moves from frame to frame, plus a little noise,
+ *  so that the J2K encoder has something more like a picture than a flat field to work on.
+ */
+static void
+fill(shared_ptr<Image> image, int frame)
+{
+	std::minstd_rand noise(frame + 1);
+	for (int c = 0; c < image->planes(); ++c) {
+		for (int y = 0; y < image->sample_size(c).height; ++y) {
+			auto p = image->data()[c] + y * image->stride()[c];
+			for (int x = 0; x < image->line_size()[c]; ++x) {
+				*p++ = ((x / 4 + y / 2 + frame * 4 + c * 64) & 0xff) ^ (noise() & 0x7);
+			}
+		}
+	}
+}
+
+
+static shared_ptr<Image>
+make_image(AVPixelFormat format, dcp::Size size, Image::Alignment alignment = Image::Alignment::PADDED)
+{
+	auto image = make_shared<Image>(format, size, alignment);
+	fill(image, 0);
+	return image;
+}
+
+
+/** @return a BGRA image which is mostly transparent with some opaque blocks, rather like rendered subtitles */
+static shared_ptr<Image>
+make_subtitle_image(dcp::Size size)
+{
+	auto image = make_shared<Image>(AV_PIX_FMT_BGRA, size, Image::Alignment::PADDED);
+	for (int y = 0; y < size.height; ++y) {
+		auto p = image->data()[0] + y * image->stride()[0];
+		for (int x = 0; x < size.width; ++x) {
+			bool const ink = y >= size.height / 4 && y < size.height * 3 / 4 && (y / 8) % 4 != 3 && (x / 6) % 5 != 4 && x < size.width * 3 / 4;
+			*p++ = 255;
+			*p++ = 255;
+			*p++ = 255;
+			*p++ = ink ? 255 : 0;
+		}
+	}
+	return image;
+}
+
+
+/** Fill some audio with a different tone in each channel.
+ *  @param offset Offset of the first frame of audio from the start of the tones.
+ */
+static void
+fill(AudioBuffers& audio, int64_t offset, int sample_rate = 48000)
+{
+	for (int c = 0; c < audio.channels(); ++c) {
+		auto const step = 2 * M_PI * 220 * (c + 1) / sample_rate;
+		auto data = audio.data(c);
+		for (int i = 0; i < audio.frames(); ++i) {
+			data[i] = 0.25 * sin(step * (offset + i));
+		}
+	}
+}
+
+
+static void
+write_file(boost::filesystem::path path, string const& content)
+{
+	dcp::File file(path, "w");
+	if (!file) {
+		throw std::runtime_error(fmt::format("Could not open {} for writing", path.string()));
+	}
+	file.checked_write(content.c_str(), content.length());
+}
+
+
+/** Write YUV420P video in the YUV4MPEG2 format, which FFmpeg can read */
+static void
+write_y4m(boost::filesystem::path path, dcp::Size size, int frames)
+{
+	dcp::File file(path, "wb");
+	if (!file) {
+		throw std::runtime_error(fmt::format("Could not open {} for writing", path.string()));
+	}
+
+	auto const header = fmt::format("YUV4MPEG2 W{} H{} F24:1 Ip A1:1 C420jpeg\n", size.width, size.height);
+	file.checked_write(header.c_str(), header.length());
+
+	auto image = make_shared<Image>(AV_PIX_FMT_YUV420P, size, Image::Alignment::COMPACT);
+	for (int i = 0; i < frames; ++i) {
+		fill(image, i);
+		file.checked_write("FRAME\n", 6);
+		for (int c = 0; c < 3; ++c) {
+			for (int y = 0; y < image->sample_size(c).height; ++y) {
+				file.checked_write(image->data()[c] + y * image->stride()[c], image->line_size()[c]);
+			}
+		}
+	}
+}
+
+
+static void
+write_wav(boost::filesystem::path path, int frames)
+{
+	SF_INFO info;
+	info.samplerate = 48000;
+	info.channels = audio_channels;
+	info.format = SF_FORMAT_WAV | SF_FORMAT_PCM_24;
+	auto file = sf_open(path.string().c_str(), SFM_WRITE, &info);
+	if (!file) {
+		throw std::runtime_error(fmt::format("Could not open {} for writing", path.string()));
+	}
+
+	AudioBuffers audio(audio_channels, audio_frames_per_video_frame);
+	vector<float> interleaved(audio_channels * audio_frames_per_video_frame);
+	for (int i = 0; i < frames; ++i) {
+		fill(audio, int64_t(i) * audio_frames_per_video_frame);
+		audio.interleave_to(interleaved.data(), audio_channels, audio_frames_per_video_frame, 0);
+		sf_writef_float(file, interleaved.data(), audio_frames_per_video_frame);
+	}
+
+	sf_close(file);
+}
+
+
+/** Write a subtitle for each second, lasting most of that second */
+static void
+write_srt(boost::filesystem::path path, int seconds)
+{
+	string srt;
+	for (int i = 0; i < seconds; ++i) {
+		srt += fmt::format(
+			"{}\n00:{:02}:{:02},000 --> 00:{:02}:{:02},800\nSubtitle number {}\n<i>with a second line</i>\n\n",
+			i + 1, i / 60, i % 60, i / 60, i % 60, i + 1
+			);
+	}
+	write_file(path, srt);
+}
+
+
+/** Write an Interop DCP subtitle file with a subtitle for each second, offset from those in write_srt() */
+static void
+write_dcp_subtitles(boost::filesystem::path path, int seconds)
+{
+	string xml =
+		"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+		"<DCSubtitle Version=\"1.0\">\n"
+		"  <SubtitleID>5e0f1f4e-5e6d-4d0e-8a0b-8b9b7b0c2c41</SubtitleID>\n"
+		"  <MovieTitle>Benchmark</MovieTitle>\n"
+		"  <ReelNumber>1</ReelNumber>\n"
+		"  <Language>English</Language>\n"
+		"  <Font Size=\"42\">\n";
+
+	for (int i = 0; i < seconds; ++i) {
+		/* Interop times are HH:MM:SS:TTT where a tick is 4ms */
+		xml += fmt::format(
+			"    <Subtitle SpotNumber=\"{}\" TimeIn=\"00:{:02}:{:02}:125\" TimeOut=\"00:{:02}:{:02}:225\" FadeUpTime=\"0\" FadeDownTime=\"0\">\n"
+			"      <Text VAlign=\"top\" VPosition=\"10\">Caption number {}</Text>\n"
+			"    </Subtitle>\n",
+			i + 1, i / 60, i % 60, i / 60, i % 60, i + 1
+			);
+	}
+
+	xml +=
+		"  </Font>\n"
+		"</DCSubtitle>\n";
+
+	write_file(path, xml);
+}
+
+
+/** @return a film in a new directory called name, containing some of the inputs made by benchmark_film() */
+static shared_ptr<Film>
+make_film(string name, vector<string> inputs)
+{
+	auto const film_directory = directory / name;
+	boost::filesystem::remove_all(film_directory);
+
+	auto film = make_shared<Film>(film_directory);
+	film->set_name("Benchmark");
+	film->set_dcp_content_type(DCPContentType::from_isdcf_name("TST"));
+	film->set_container(Ratio::from_id("185"));
+	film->set_video_frame_rate(24);
+	film->set_audio_channels(audio_channels);
+
+	ContentList content;
+	for (auto const& input: inputs) {
+		for (auto i: content_factory(directory / "inputs" / input)) {
+			content.push_back(i);
+		}
+	}
+
+	film->examine_and_add_content(content, true);
+	run_jobs();
+
+	return film;
+}
+
+
+/** @return a film of film_frames frames made from 1080p YUV video, 5.1 audio, burnt-in subtitles
+ *  from a SRT file and DCP subtitles.
+ */
+static shared_ptr<Film>
+benchmark_film()
+{
+	if (cached_film) {
+		return cached_film;
+	}
+
+	cerr << "Making inputs in " << directory.string() << "\n";
+
+	auto const inputs = directory / "inputs";
+	boost::filesystem::remove_all(inputs);
+	boost::filesystem::create_directories(inputs);
+
+	int const seconds = film_frames / 24;
+	write_y4m(inputs / "video.y4m", dcp::Size(1920, 1080), film_frames);
+	write_wav(inputs / "audio.wav", film_frames);
+	write_srt(inputs / "subtitles.srt", seconds);
+	write_dcp_subtitles(inputs / "subtitles.xml", seconds);
+
+	auto film = make_film("film", { "video.y4m", "audio.wav", "subtitles.srt", "subtitles.xml" });
+
+	for (auto i: film->content()) {
+		if (dynamic_pointer_cast<StringTextFileContent>(i)) {
+			i->only_text()->set_burn(true);
+		}
+	}
+
+	film->write_metadata();
+	cached_film = film;
+	return film;
+}
+
+
+static Benchmark
+scale_yuv420p()
+{
+	auto image = make_image(AV_PIX_FMT_YUV420P, dcp::Size(1920, 1080));
+	Benchmark benchmark("scale_yuv420p_1080p_to_rgb24_2k", 1);
+	benchmark.run(iterations, [image]() {
+		image->scale(dcp::Size(1998, 1080), dcp::YUVToRGB::REC709, AV_PIX_FMT_RGB24, Image::Alignment::PADDED, false);
+	});
+	return benchmark;
+}
+
+
+static Benchmark
+scale_rgb48le()
+{
+	auto image = make_image(AV_PIX_FMT_RGB48LE, dcp::Size(4096, 2160));
+	Benchmark benchmark("scale_rgb48le_4k_to_2k", 1);
+	benchmark.run(iterations, [image]() {
+		image->scale(dcp::Size(2048, 1080), dcp::YUVToRGB::REC709, AV_PIX_FMT_RGB48LE, Image::Alignment::PADDED, false);
+	});
+	return benchmark;
+}
+
+
+static Benchmark
+xyz()
+{
+	auto video = make_shared<PlayerVideo>(
+		make_shared<RawImageProxy>(make_image(AV_PIX_FMT_RGB48LE, dcp::Size(1998, 1080))),
+		Crop(),
+		optional<double>(),
+		dcp::Size(1998, 1080),
+		dcp::Size(1998, 1080),
+		Eyes::BOTH,
+		Part::WHOLE,
+		ColourConversion(),
+		VideoRange::FULL,
+		weak_ptr<Content>(),
+		optional<ContentTime>(),
+		false
+		);
+
+	Benchmark benchmark("xyz_2k", 1);
+	benchmark.run(iterations, [video]() {
+		DCPVideo::convert_to_xyz(video);
+	});
+	return benchmark;
+}
+
+
+static Benchmark
+alpha_blend(AVPixelFormat format, string name)
+{
+	auto image = make_image(format, dcp::Size(1998, 1080));
+	auto subtitle = make_subtitle_image(dcp::Size(1998, 256));
+	Benchmark benchmark("alpha_blend_bgra_onto_" + name, 1);
+	benchmark.run(iterations, [image, subtitle]() {
+		image->alpha_blend(subtitle, Position<int>(0, 800));
+	});
+	return benchmark;
+}
+
+
+static Benchmark
+fade()
+{
+	auto image = make_image(AV_PIX_FMT_RGB48LE, dcp::Size(1998, 1080));
+	Benchmark benchmark("fade_rgb48le_2k", 1);
+	benchmark.run(iterations, [image]() {
+		image->fade(0.5);
+	});
+	return benchmark;
+}
+
+
+static shared_ptr<PlayerVideo>
+j2k_input(int frame = 0)
+{
+	auto image = make_shared<Image>(AV_PIX_FMT_RGB24, dcp::Size(1998, 1080), Image::Alignment::PADDED);
+	fill(image, frame);
+
+	return make_shared<PlayerVideo>(
+		make_shared<RawImageProxy>(image),
+		Crop(),
+		optional<double>(),
+		dcp::Size(1998, 1080),
+		dcp::Size(1998, 1080),
+		Eyes::BOTH,
+		Part::WHOLE,
+		ColourConversion(),
+		VideoRange::FULL,
+		weak_ptr<Content>(),
+		optional<ContentTime>(),
+		false
+		);
+}
+
+
+/** Encode single frames one after the other, to measure the time for one frame; the transcode
+ *  benchmark shows what happens with all the encoding threads running.
+ */
+static Benchmark
+j2k_encode()
+{
+	DCPVideo video(j2k_input(), 0, 24, 250000000, Resolution::TWO_K);
+	Benchmark benchmark("j2k_encode_2k", 1);
+	benchmark.run(std::max(iterations / 4, 4), [&video]() {
+		video.encode_locally();
+	});
+	return benchmark;
+}
+
+
+/** Write a J2K frame and its audio for each frame of the film, then finish the DCP.
+ *  The timings are of the calls to write(); the time taken by finish() goes into the total.
+ */
+static Benchmark
+mxf_write()
+{
+	auto film = benchmark_film();
+	auto encoded = make_shared<dcp::ArrayData>(DCPVideo(j2k_input(), 0, 24, 250000000, Resolution::TWO_K).encode_locally());
+	auto audio = make_shared<AudioBuffers>(film->audio_channels(), audio_frames_per_video_frame);
+	fill(*audio, 0);
+
+	auto const output = film->dir("mxf_write");
+	boost::filesystem::remove_all(output);
+
+	Benchmark benchmark("mxf_write", 1);
+
+	auto writer = make_shared<Writer>(film, weak_ptr<Job>(), output);
+	writer->start();
+
+	auto const frames = film->length().frames_round(film->video_frame_rate());
+	for (int64_t i = 0; i < frames; ++i) {
+		auto const start = std::chrono::steady_clock::now();
+		writer->write(encoded, i, Eyes::BOTH);
+		writer->write(audio, DCPTime::from_frames(i, film->video_frame_rate()));
+		benchmark.add(seconds_since(start));
+	}
+
+	auto const start = std::chrono::steady_clock::now();
+	writer->finish();
+	benchmark.add_total(seconds_since(start), 0);
+
+	return benchmark;
+}
+
+
+/** Encode the film's frames with J2KEncoder using some number of local threads, and write them
+ *  with Writer.  Frames/s against threads shows how well the queues between the caller, the encoding
+ *  threads and the writer cope once there are more threads than cores.
+ */
+static Benchmark
+j2k_encoder_writer(int threads)
+{
+	auto film = benchmark_film();
+	auto config = Config::instance();
+	auto const old_threads = config->master_encoding_threads();
+	auto const old_use_any_servers = config->use_any_servers();
+	config->set_master_encoding_threads(threads);
+	config->set_use_any_servers(false);
+
+	/* Alternate between two different frames so that J2KEncoder doesn't just repeat one */
+	vector<shared_ptr<PlayerVideo>> const video = { j2k_input(0), j2k_input(1) };
+	auto audio = make_shared<AudioBuffers>(film->audio_channels(), audio_frames_per_video_frame);
+	fill(*audio, 0);
+
+	auto const output = film->dir(fmt::format("j2k_encoder_writer_{}", threads));
+	boost::filesystem::remove_all(output);
+	/* Otherwise Writer would find the assets from the last run and fake-write most frames */
+	film->write_remembered_assets({});
+
+	Benchmark benchmark(fmt::format("j2k_encoder_writer_{}_threads", threads), 1);
+
+	{
+		Writer writer(film, weak_ptr<Job>(), output);
+		J2KEncoder encoder(film, writer);
+
+		auto const start = std::chrono::steady_clock::now();
+		writer.start();
+		encoder.begin();
+
+		auto const frames = film->length().frames_round(film->video_frame_rate());
+		for (int64_t i = 0; i < frames; ++i) {
+			auto const time = DCPTime::from_frames(i, film->video_frame_rate());
+			encoder.encode(video[i % 2], time);
+			writer.write(audio, time);
+		}
+
+		encoder.end();
+		writer.finish();
+		benchmark.add_total(seconds_since(start), frames);
+	}
+
+	config->set_master_encoding_threads(old_threads);
+	config->set_use_any_servers(old_use_any_servers);
+
+	return benchmark;
+}
+
+
+/** Convert a frame of interleaved 16-channel 24-bit DCP sound to planar float, as DCPDecoder does.
+ *  @param scalar true to use the per-sample loop that DCPDecoder used before the pcm_unpack kernels.
+ */
+static Benchmark
+pcm_unpack_24(bool scalar)
+{
+	int const channels = 16;
+	int const frames = audio_frames_per_video_frame;
+	std::minstd_rand random(1);
+	vector<uint8_t> in(channels * frames * 3);
+	for (auto& i: in) {
+		i = random() & 0xff;
+	}
+	vector<float> samples(channels * frames);
+	AudioBuffers out(channels, frames);
+
+	Benchmark benchmark(string("pcm_unpack_24_16_channels") + (scalar ? "_scalar" : ""), 1);
+	benchmark.run(iterations * 8, [&in, &samples, &out, scalar]() {
+		if (scalar) {
+			auto from = in.data();
+			auto data = out.data();
+			for (int i = 0; i < frames; ++i) {
+				for (int j = 0; j < channels; ++j) {
+					data[j][i] = static_cast<int>((from[0] << 8) | (from[1] << 16) | (static_cast<unsigned>(from[2]) << 24)) / static_cast<float>(INT_MAX - 256);
+					from += 3;
+				}
+			}
+		} else {
+			unpack_pcm_24(in.data(), channels * frames, samples.data());
+			out.deinterleave_from(samples.data(), channels, frames, 0);
+		}
+	});
+	return benchmark;
+}
+
+
+/** Convert a frame of interleaved 16-channel S16 audio to planar float, as FFmpegDecoder does.
+ *  @param scalar true to use the per-sample loop that FFmpegDecoder used before the pcm_unpack kernels.
+ */
+static Benchmark
+pcm_unpack_s16(bool scalar)
+{
+	int const channels = 16;
+	int const frames = audio_frames_per_video_frame;
+	std::minstd_rand random(1);
+	vector<int16_t> in(channels * frames);
+	for (auto& i: in) {
+		i = random() & 0xffff;
+	}
+	vector<float> samples(channels * frames);
+	AudioBuffers out(channels, frames);
+
+	Benchmark benchmark(string("pcm_unpack_s16_16_channels") + (scalar ? "_scalar" : ""), 1);
+	benchmark.run(iterations * 8, [&in, &samples, &out, scalar]() {
+		if (scalar) {
+			auto p = in.data();
+			auto data = out.data();
+			int sample = 0;
+			int channel = 0;
+			for (int i = 0; i < channels * frames; ++i) {
+				data[channel][sample] = float(*p++) / (1 << 15);
+
+				++channel;
+				if (channel == channels) {
+					channel = 0;
+					++sample;
+				}
+			}
+		} else {
+			unpack_s16(in.data(), channels * frames, samples.data());
+			out.deinterleave_from(samples.data(), channels, frames, 0);
+		}
+	});
+	return benchmark;
+}
+
+
+static Benchmark
+audio_interleave()
+{
+	int const channels = 16;
+	AudioBuffers audio(channels, audio_frames_per_video_frame);
+	fill(audio, 0);
+	vector<float> interleaved(channels * audio_frames_per_video_frame);
+
+	Benchmark benchmark("audio_interleave_deinterleave_16_channels", 1);
+	benchmark.run(iterations * 8, [&audio, &interleaved]() {
+		audio.interleave_to(interleaved.data(), channels, audio_frames_per_video_frame, 0);
+		audio.deinterleave_from(interleaved.data(), channels, audio_frames_per_video_frame, 0);
+	});
+	return benchmark;
+}
+
+
+static Benchmark
+resample()
+{
+	Resampler resampler(44100, 48000, audio_channels);
+	auto in = make_shared<AudioBuffers>(audio_channels, 44100 / 24);
+	fill(*in, 0, 44100);
+
+	Benchmark benchmark("resample_44k1_to_48k", 1);
+	benchmark.run(iterations * 8, [&resampler, in]() {
+		resampler.run(in);
+	});
+	return benchmark;
+}
+
+
+/** Filter with M + 1 taps, run either directly or with FFT convolution; running both for a range
+ *  of M shows where AudioFilter should switch from one to the other.
+ */
+static Benchmark
+audio_filter(int M, bool fft)
+{
+	LowPassAudioFilter filter(4.0 / M, 0.1);
+	filter.set_use_fft(fft);
+	auto in = make_shared<AudioBuffers>(audio_channels, audio_frames_per_video_frame);
+	fill(*in, 0);
+
+	Benchmark benchmark(fmt::format("audio_filter_low_pass_{}_m{}", fft ? "fft" : "direct", M), 1);
+	benchmark.run(iterations * 8, [&filter, in]() {
+		filter.run(in);
+	});
+	return benchmark;
+}
+
+
+static Benchmark
+audio_analysis()
+{
+	auto film = benchmark_film();
+	AudioAnalyser analyser(film, film->playlist(), true, [](float) {});
+	auto audio = make_shared<AudioBuffers>(film->audio_channels(), audio_frames_per_video_frame);
+	fill(*audio, 0);
+
+	Frame position = 0;
+	Benchmark benchmark("audio_analysis", 1);
+	benchmark.run(iterations * 8, [&analyser, audio, &position]() {
+		analyser.analyse(audio, DCPTime::from_frames(position, 48000));
+		position += audio_frames_per_video_frame;
+	});
+	return benchmark;
+}
+
+
+/** Run the player over the whole film, making an RGB image of each frame as the encoder would */
+static Benchmark
+player()
+{
+	auto film = benchmark_film();
+	Player player(film, Image::Alignment::PADDED, false);
+
+	Benchmark benchmark("player", 1);
+	auto last = std::chrono::steady_clock::now();
+	player.Video.connect([&benchmark, &last](shared_ptr<PlayerVideo> video, DCPTime) {
+		video->image(force_rgb24, VideoRange::FULL, false);
+		benchmark.add(seconds_since(last));
+		last = std::chrono::steady_clock::now();
+	});
+
+	while (!player.pass()) {}
+	return benchmark;
+}
+
+
+/** Play the film through a butler, as the viewer does */
+static Benchmark
+butler()
+{
+	auto film = benchmark_film();
+	Player player(film, Image::Alignment::PADDED, false);
+
+	AudioMapping map(film->audio_channels(), film->audio_channels());
+	for (int i = 0; i < film->audio_channels(); ++i) {
+		map.set(i, i, 1);
+	}
+
+	Butler butler(
+		film,
+		player,
+		map,
+		film->audio_channels(),
+		force_rgb24,
+		VideoRange::FULL,
+		Image::Alignment::PADDED,
+		true,
+		false,
+		Butler::Audio::ENABLED
+		);
+
+	AudioBuffers audio(film->audio_channels(), audio_frames_per_video_frame);
+
+	Benchmark benchmark("butler", 1);
+	auto const frames = film->length().frames_round(film->video_frame_rate());
+	for (int64_t i = 0; i < frames; ++i) {
+		auto const start = std::chrono::steady_clock::now();
+		auto video = butler.get_video(Butler::Behaviour::BLOCKING);
+		if (!video.first) {
+			break;
+		}
+		video.first->image(force_rgb24, VideoRange::FULL, true);
+		butler.get_audio(Butler::Behaviour::BLOCKING, &audio, audio_frames_per_video_frame);
+		benchmark.add(seconds_since(start));
+	}
+
+	butler.rethrow();
+	return benchmark;
+}
+
+
+static Benchmark
+transcode()
+{
+	auto film = benchmark_film();
+
+	Benchmark benchmark("transcode", 1);
+	auto const start = std::chrono::steady_clock::now();
+	make_dcp(film, TranscodeJob::ChangedBehaviour::IGNORE);
+	run_jobs();
+	benchmark.add_total(seconds_since(start), film->length().frames_round(film->video_frame_rate()));
+	return benchmark;
+}
+
+
+/** Export a film of the benchmark video, with or without the benchmark audio, to ProRes with PCM
+ *  sound.  Without the audio the export still writes silence, so the difference between the two
+ *  is the cost of getting the audio from the decoder, through the player and butler, to the exporter.
+ */
+static Benchmark
+export_prores(bool audio)
+{
+	/* Make sure that the inputs are there */
+	benchmark_film();
+
+	vector<string> inputs = { "video.y4m" };
+	if (audio) {
+		inputs.push_back("audio.wav");
+	}
+	auto const name = string("export_prores_") + (audio ? "with_audio" : "video_only");
+	auto film = make_film(name, inputs);
+
+	auto const output = directory / (name + ".mov");
+	boost::filesystem::remove(output);
+
+	Benchmark benchmark(name, 1);
+	auto job = make_shared<TranscodeJob>(film, TranscodeJob::ChangedBehaviour::IGNORE);
+	FFmpegFilmEncoder encoder(film, job, output, ExportFormat::PRORES_HQ, false, false, false, 23);
+	auto const start = std::chrono::steady_clock::now();
+	encoder.go();
+	benchmark.add_total(seconds_since(start), film->length().frames_round(film->video_frame_rate()));
+	return benchmark;
+}
+
+
+static void
+help(string n)
+{
+	cerr << "Syntax: " << n << " [OPTION]\n"
+	     << "  -h, --help             show this help\n"
+	     << "  -o, --output <file>    write JSON results to <file> rather than to stdout\n"
+	     << "  -r, --run <name>       only run benchmarks whose names contain <name>; may be given more than once\n"
+	     << "  -l, --list             list the benchmarks\n"
+	     << "  -i, --iterations <n>   number of timings to take in the shorter benchmarks (default " << iterations << ")\n"
+	     << "  -f, --frames <n>       length of the film to make, in frames (default " << film_frames << ")\n"
+	     << "  -d, --directory <dir>  directory to make inputs in (default " << directory.string() << ")\n";
+}
+
+
+int
+main(int argc, char* argv[])
+{
+	optional<boost::filesystem::path> output;
+	vector<string> only;
+	bool list = false;
+
+	while (true) {
+		static struct option long_options[] = {
+			{ "help", no_argument, 0, 'h'},
+			{ "output", required_argument, 0, 'o'},
+			{ "run", required_argument, 0, 'r'},
+			{ "list", no_argument, 0, 'l'},
+			{ "iterations", required_argument, 0, 'i'},
+			{ "frames", required_argument, 0, 'f'},
+			{ "directory", required_argument, 0, 'd'},
+			{ 0, 0, 0, 0 }
+		};
+
+		int option_index = 0;
+		int c = getopt_long(argc, argv, "ho:r:li:f:d:", long_options, &option_index);
+
+		if (c == -1) {
+			break;
+		}
+
+		switch (c) {
+		case 'h':
+			help(argv[0]);
+			exit(EXIT_SUCCESS);
+		case 'o':
+			output = optarg;
+			break;
+		case 'r':
+			only.push_back(optarg);
+			break;
+		case 'l':
+			list = true;
+			break;
+		case 'i':
+			iterations = std::max(1, atoi(optarg));
+			break;
+		case 'f':
+			film_frames = std::max(24, atoi(optarg));
+			break;
+		case 'd':
+			directory = optarg;
+			break;
+		default:
+			help(argv[0]);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	vector<pair<string, function<Benchmark ()>>> benchmarks = {
+		{ "scale_yuv420p", scale_yuv420p },
+		{ "scale_rgb48le", scale_rgb48le },
+		{ "xyz", xyz },
+		{ "alpha_blend_rgb24", []() { return alpha_blend(AV_PIX_FMT_RGB24, "rgb24"); } },
+		{ "alpha_blend_rgb48le", []() { return alpha_blend(AV_PIX_FMT_RGB48LE, "rgb48le"); } },
+		{ "alpha_blend_xyz12le", []() { return alpha_blend(AV_PIX_FMT_XYZ12LE, "xyz12le"); } },
+		{ "alpha_blend_yuv420p", []() { return alpha_blend(AV_PIX_FMT_YUV420P, "yuv420p"); } },
+		{ "fade", fade },
+		{ "j2k_encode", j2k_encode },
+		{ "mxf_write", mxf_write },
+		{ "pcm_unpack_24", []() { return pcm_unpack_24(false); } },
+		{ "pcm_unpack_24_scalar", []() { return pcm_unpack_24(true); } },
+		{ "pcm_unpack_s16", []() { return pcm_unpack_s16(false); } },
+		{ "pcm_unpack_s16_scalar", []() { return pcm_unpack_s16(true); } },
+		{ "audio_interleave", audio_interleave },
+		{ "resample", resample },
+		{ "audio_analysis", audio_analysis },
+		{ "player", player },
+		{ "butler", butler },
+		{ "transcode", transcode },
+		{ "export_prores_video_only", []() { return export_prores(false); } },
+		{ "export_prores_with_audio", []() { return export_prores(true); } },
+	};
+
+	for (auto threads: { 1, 2, 4, 8, 16, 32, 48, 64 }) {
+		benchmarks.push_back({ fmt::format("j2k_encoder_writer_{}", threads), [threads]() { return j2k_encoder_writer(threads); } });
+	}
+
+	for (auto M: { 16, 32, 64, 128, 256, 512, 2000 }) {
+		for (auto fft: { false, true }) {
+			benchmarks.push_back({ fmt::format("audio_filter_{}_m{}", fft ? "fft" : "direct", M), [M, fft]() { return audio_filter(M, fft); } });
+		}
+	}
+
+	if (list) {
+		for (auto const& i: benchmarks) {
+			cout << i.first << "\n";
+		}
+		exit(EXIT_SUCCESS);
+	}
+
+	State::override_path = directory / "state";
+
+	dcpomatic_setup_path_encoding();
+	dcpomatic_setup();
+	signal_manager = new BenchmarkSignalManager();
+
+	Config::instance()->set_master_encoding_threads(boost::thread::hardware_concurrency());
+	Config::instance()->set_automatic_audio_analysis(false);
+
+	vector<Benchmark> results;
+
+	try {
+		for (auto const& i: benchmarks) {
+			auto wanted = only.empty();
+			for (auto const& j: only) {
+				if (i.first.find(j) != string::npos) {
+					wanted = true;
+				}
+			}
+
+			if (wanted) {
+				results.push_back(i.second());
+				cerr << results.back().summary() << "\n";
+			}
+		}
+	} catch (std::exception& e) {
+		cerr << argv[0] << ": " << e.what() << "\n";
+		JobManager::drop();
+		exit(EXIT_FAILURE);
+	}
+
+	JobManager::drop();
+
+	auto const json = benchmarks_as_json(results);
+	if (output) {
+		write_file(*output, json);
+	} else {
+		cout << json;
+	}
+
+	return 0;
+}
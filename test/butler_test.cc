@@ -26,12 +26,17 @@
 #include "lib/dcp_content_type.h"
 #include "lib/film.h"
 #include "lib/player.h"
+#include "lib/player_video.h"
+#include "lib/player_video_cache.h"
 #include "lib/ratio.h"
 #include "test.h"
+#include <fmt/format.h>
 #include <boost/test/unit_test.hpp>
 
 
 using std::make_shared;
+using std::shared_ptr;
+using std::vector;
 #if BOOST_VERSION >= 106100
 using namespace boost::placeholders;
 #endif
@@ -130,3 +135,83 @@ BOOST_AUTO_TEST_CASE (butler_test2)
 	butler.rethrow();
 }
 
+
+/** Check that images come from a PlayerVideoCache after seeking back, and that they are the same as the originals */
+BOOST_AUTO_TEST_CASE(butler_video_cache_test)
+{
+	auto video = content_factory("test/data/flat_red.png")[0];
+	auto film = new_test_film("butler_video_cache_test", { video });
+
+	Player player(film, Image::Alignment::COMPACT, false);
+
+	auto cache = make_shared<PlayerVideoCache>(64 * 1024 * 1024);
+
+	Butler butler(
+		film,
+		player,
+		AudioMapping(),
+		2,
+		boost::bind(&PlayerVideo::force, AV_PIX_FMT_RGB24),
+		VideoRange::FULL,
+		Image::Alignment::COMPACT,
+		false,
+		false,
+		Butler::Audio::DISABLED,
+		cache
+		);
+
+	auto const frames = 8;
+
+	vector<shared_ptr<Image>> first;
+	for (int i = 0; i < frames; ++i) {
+		auto video = butler.get_video(Butler::Behaviour::BLOCKING, 0);
+		BOOST_REQUIRE(video.first);
+		BOOST_CHECK(video.second == DCPTime::from_frames(i, 24));
+		first.push_back(video.first->image(boost::bind(&PlayerVideo::force, AV_PIX_FMT_RGB24), VideoRange::FULL, false));
+	}
+
+	auto const hits_before_seek = cache->statistics().hits;
+	BOOST_CHECK(cache->memory_used() > 0);
+
+	butler.seek(DCPTime(), true);
+
+	for (int i = 0; i < frames; ++i) {
+		auto video = butler.get_video(Butler::Behaviour::BLOCKING, 0);
+		BOOST_REQUIRE(video.first);
+		BOOST_CHECK(video.second == DCPTime::from_frames(i, 24));
+		auto image = video.first->image(boost::bind(&PlayerVideo::force, AV_PIX_FMT_RGB24), VideoRange::FULL, false);
+		BOOST_CHECK(*image == *first[i]);
+	}
+
+	BOOST_CHECK(cache->statistics().hits >= hits_before_seek + frames);
+
+	butler.rethrow();
+}
+
+
+BOOST_AUTO_TEST_CASE(player_video_cache_limit_test)
+{
+	auto const size = Image(AV_PIX_FMT_RGB24, dcp::Size(64, 64), Image::Alignment::COMPACT).memory_used();
+
+	PlayerVideoCache cache(size * 2);
+
+	for (int i = 0; i < 3; ++i) {
+		auto image = make_shared<Image>(AV_PIX_FMT_RGB24, dcp::Size(64, 64), Image::Alignment::COMPACT);
+		image->make_black();
+		cache.put(fmt::to_string(i), image);
+	}
+
+	/* The first one should have been dropped to keep us within the limit */
+	BOOST_CHECK(!cache.get("0"));
+	BOOST_CHECK(cache.get("1"));
+	BOOST_CHECK(cache.get("2"));
+	BOOST_CHECK_EQUAL(cache.memory_used(), size * 2);
+
+	/* "1" was used before "2" so adding another should now drop "1" */
+	cache.put("3", make_shared<Image>(AV_PIX_FMT_RGB24, dcp::Size(64, 64), Image::Alignment::COMPACT));
+	BOOST_CHECK(!cache.get("1"));
+	BOOST_CHECK(cache.get("2"));
+
+	BOOST_CHECK_EQUAL(cache.statistics().hits, 3);
+	BOOST_CHECK_EQUAL(cache.statistics().misses, 2);
+}
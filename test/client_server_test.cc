@@ -25,10 +25,12 @@
  */
 
 
+#include "lib/config.h"
 #include "lib/content_factory.h"
 #include "lib/cross.h"
 #include "lib/dcp_video.h"
 #include "lib/dcpomatic_log.h"
+#include "lib/dcpomatic_socket.h"
 #include "lib/encode_server.h"
 #include "lib/encode_server_description.h"
 #include "lib/encode_server_finder.h"
@@ -41,6 +43,7 @@
 #include "test.h"
 #include <boost/test/unit_test.hpp>
 #include <boost/thread.hpp>
+#include <set>
 
 
 using std::list;
@@ -226,6 +229,155 @@ BOOST_AUTO_TEST_CASE (client_server_test_yuv)
 }
 
 
+/** Send several frames down one connection before asking for any of them back */
+BOOST_AUTO_TEST_CASE (client_server_test_pipelined)
+{
+	auto image = make_shared<Image>(AV_PIX_FMT_RGB24, dcp::Size(1998, 1080), Image::Alignment::PADDED);
+	uint8_t* p = image->data()[0];
+
+	for (int y = 0; y < 1080; ++y) {
+		uint8_t* q = p;
+		for (int x = 0; x < 1998; ++x) {
+			*q++ = x % 256;
+			*q++ = y % 256;
+			*q++ = (x + y) % 256;
+		}
+		p += image->stride()[0];
+	}
+
+	LogSwitcher ls (make_shared<FileLog>("build/test/client_server_test_pipelined.log"));
+
+	auto pvf = std::make_shared<PlayerVideo>(
+		make_shared<RawImageProxy>(image),
+		Crop(),
+		optional<double>(),
+		dcp::Size(1998, 1080),
+		dcp::Size(1998, 1080),
+		Eyes::BOTH,
+		Part::WHOLE,
+		ColourConversion(),
+		VideoRange::FULL,
+		weak_ptr<Content>(),
+		optional<ContentTime>(),
+		false
+		);
+
+	auto locally_encoded = DCPVideo(pvf, 0, 24, 200000000, Resolution::TWO_K).encode_locally();
+
+	auto server = make_shared<EncodeServer>(true, 2);
+
+	thread server_thread(boost::bind(&EncodeServer::run, server));
+
+	/* Let the server get itself ready */
+	dcpomatic_sleep_seconds (1);
+
+	auto socket = make_shared<Socket>(1200);
+	socket->connect("127.0.0.1", ENCODE_FRAME_PORT);
+
+	int const frames = 6;
+	for (int i = 0; i < frames; ++i) {
+		DCPVideo(pvf, i, 24, 200000000, Resolution::TWO_K).send_to_server(socket);
+	}
+
+	std::set<int> received;
+	for (int i = 0; i < frames; ++i) {
+		auto encoded = DCPVideo::receive_from_server(socket);
+		BOOST_CHECK(encoded.eyes == Eyes::BOTH);
+		BOOST_REQUIRE_EQUAL(encoded.data.size(), locally_encoded.size());
+		BOOST_CHECK_EQUAL(memcmp(encoded.data.data(), locally_encoded.data(), locally_encoded.size()), 0);
+		received.insert(encoded.index);
+	}
+
+	BOOST_CHECK_EQUAL(received.size(), static_cast<size_t>(frames));
+	BOOST_CHECK_EQUAL(*received.begin(), 0);
+	BOOST_CHECK_EQUAL(*received.rbegin(), frames - 1);
+
+	socket->close();
+
+	server->stop ();
+	server_thread.join();
+}
+
+
+/** A frame which the server can't encode should be reported as failed without closing the connection */
+BOOST_AUTO_TEST_CASE (client_server_test_failed_frame)
+{
+	auto make_pvf = [](dcp::Size size) {
+		auto image = make_shared<Image>(AV_PIX_FMT_RGB24, size, Image::Alignment::PADDED);
+		for (int y = 0; y < size.height; ++y) {
+			uint8_t* q = image->data()[0] + y * image->stride()[0];
+			for (int x = 0; x < size.width; ++x) {
+				*q++ = x % 256;
+				*q++ = y % 256;
+				*q++ = (x + y) % 256;
+			}
+		}
+
+		return std::make_shared<PlayerVideo>(
+			make_shared<RawImageProxy>(image),
+			Crop(),
+			optional<double>(),
+			size,
+			size,
+			Eyes::BOTH,
+			Part::WHOLE,
+			ColourConversion(),
+			VideoRange::FULL,
+			weak_ptr<Content>(),
+			optional<ContentTime>(),
+			false
+			);
+	};
+
+	LogSwitcher ls (make_shared<FileLog>("build/test/client_server_test_failed_frame.log"));
+
+	auto good = make_pvf(dcp::Size(1998, 1080));
+	/* This is too small to be encoded as a DCP frame */
+	auto bad = make_pvf(dcp::Size(4, 4));
+
+	auto locally_encoded = DCPVideo(good, 0, 24, 200000000, Resolution::TWO_K).encode_locally();
+
+	auto server = make_shared<EncodeServer>(true, 2);
+
+	thread server_thread(boost::bind(&EncodeServer::run, server));
+
+	/* Let the server get itself ready */
+	dcpomatic_sleep_seconds (1);
+
+	auto socket = make_shared<Socket>(1200);
+	socket->connect("127.0.0.1", ENCODE_FRAME_PORT);
+
+	DCPVideo(good, 0, 24, 200000000, Resolution::TWO_K).send_to_server(socket);
+	DCPVideo(bad, 1, 24, 200000000, Resolution::TWO_K).send_to_server(socket);
+	DCPVideo(good, 2, 24, 200000000, Resolution::TWO_K).send_to_server(socket);
+
+	std::set<int> received;
+	for (int i = 0; i < 3; ++i) {
+		auto encoded = DCPVideo::receive_from_server(socket);
+		if (encoded.index == 1) {
+			BOOST_CHECK_EQUAL(encoded.data.size(), 0);
+		} else {
+			BOOST_REQUIRE_EQUAL(encoded.data.size(), locally_encoded.size());
+			BOOST_CHECK_EQUAL(memcmp(encoded.data.data(), locally_encoded.data(), locally_encoded.size()), 0);
+		}
+		received.insert(encoded.index);
+	}
+
+	BOOST_CHECK_EQUAL(received.size(), 3U);
+
+	/* The connection should still work */
+	DCPVideo(good, 3, 24, 200000000, Resolution::TWO_K).send_to_server(socket);
+	auto encoded = DCPVideo::receive_from_server(socket);
+	BOOST_CHECK_EQUAL(encoded.index, 3);
+	BOOST_CHECK_EQUAL(encoded.data.size(), locally_encoded.size());
+
+	socket->close();
+
+	server->stop ();
+	server_thread.join();
+}
+
+
 BOOST_AUTO_TEST_CASE (client_server_test_j2k)
 {
 	auto image = make_shared<Image>(AV_PIX_FMT_YUV420P, dcp::Size (1998, 1080), Image::Alignment::PADDED);
@@ -21,13 +21,18 @@
 
 #include "lib/content_factory.h"
 #include "lib/dcp_content.h"
+#include "lib/ffmpeg_content.h"
 #include "lib/film.h"
 #include "lib/job_manager.h"
 #include "test.h"
 #include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <fstream>
 
 
 using std::make_shared;
+using std::shared_ptr;
+using std::vector;
 
 
 BOOST_AUTO_TEST_CASE(film_contains_atmos_content_test)
@@ -86,3 +91,59 @@ BOOST_AUTO_TEST_CASE(film_possible_reel_types_test2)
 	BOOST_CHECK_EQUAL(film->possible_reel_types().size(), 2U);
 }
 
+
+/** Examine several pieces of content in one job and check that they are all added in the order given */
+BOOST_AUTO_TEST_CASE(film_examine_and_add_content_batch_test)
+{
+	auto film = new_test_film("film_examine_and_add_content_batch_test");
+
+	vector<shared_ptr<Content>> content = {
+		content_factory("test/data/flat_red.png")[0],
+		content_factory("test/data/white.wav")[0],
+		content_factory("test/data/flat_blue.png")[0],
+		content_factory("test/data/test.mp4")[0],
+		content_factory("test/data/flat_green.png")[0]
+	};
+
+	film->examine_and_add_content(content);
+	BOOST_REQUIRE(!wait_for_jobs());
+
+	auto added = film->content();
+	BOOST_REQUIRE_EQUAL(added.size(), content.size());
+	for (auto i: content) {
+		BOOST_CHECK(std::find(added.begin(), added.end(), i) != added.end());
+		BOOST_CHECK(!i->digest().empty());
+	}
+
+	/* Video content is placed end-to-end in the order that it was given */
+	BOOST_CHECK(content[0]->position() < content[2]->position());
+	BOOST_CHECK(content[2]->position() < content[3]->position());
+	BOOST_CHECK(content[3]->position() < content[4]->position());
+}
+
+
+/** If one piece of content in a batch fails to examine the others should still be added */
+BOOST_AUTO_TEST_CASE(film_examine_and_add_content_batch_error_test)
+{
+	auto film = new_test_film("film_examine_and_add_content_batch_error_test");
+
+	auto const bad = film->directory().get() / "bad.mp4";
+	{
+		std::ofstream f(bad.string().c_str());
+		f << "This is not a video file.\n";
+	}
+
+	vector<shared_ptr<Content>> content = {
+		content_factory("test/data/flat_red.png")[0],
+		make_shared<FFmpegContent>(bad),
+		content_factory("test/data/white.wav")[0]
+	};
+
+	film->examine_and_add_content(content);
+	BOOST_CHECK(wait_for_jobs());
+
+	auto added = film->content();
+	BOOST_REQUIRE_EQUAL(added.size(), 2U);
+	BOOST_CHECK(std::find(added.begin(), added.end(), content[0]) != added.end());
+	BOOST_CHECK(std::find(added.begin(), added.end(), content[2]) != added.end());
+}
@@ -0,0 +1,97 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+
+#include "lib/frame_read_ahead.h"
+#include <boost/test/unit_test.hpp>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+
+
+using std::make_shared;
+using std::shared_ptr;
+
+
+BOOST_AUTO_TEST_CASE(frame_read_ahead_test)
+{
+	std::atomic<int> reads(0);
+
+	FrameReadAhead<shared_ptr<int64_t>> read_ahead(
+		[&reads](int64_t frame) {
+			++reads;
+			if (frame == 50) {
+				throw std::runtime_error("bad frame");
+			}
+			return make_shared<int64_t>(frame);
+		},
+		100,
+		4
+		);
+
+	/* Read through in order */
+	for (int64_t i = 10; i < 40; ++i) {
+		BOOST_REQUIRE_EQUAL(*read_ahead.get(i), i);
+	}
+
+	/* Going backwards and skipping forwards should still work */
+	BOOST_CHECK_EQUAL(*read_ahead.get(5), 5);
+	BOOST_CHECK_EQUAL(*read_ahead.get(6), 6);
+	BOOST_CHECK_EQUAL(*read_ahead.get(30), 30);
+
+	/* Errors should come out of get() for the frame that caused them, and not stop things */
+	BOOST_CHECK_THROW(read_ahead.get(50), std::runtime_error);
+	BOOST_CHECK_EQUAL(*read_ahead.get(51), 51);
+
+	/* It's OK to ask for something beyond the end */
+	BOOST_CHECK_EQUAL(*read_ahead.get(120), 120);
+
+	/* We asked for 36 frames; each of the 4 jumps could waste one read-ahead's worth (plus one being read) */
+	BOOST_CHECK(reads <= 36 + 5 * 5);
+}
+
+
+/** Reading in order up to the end and then past it should give whatever the read function does */
+BOOST_AUTO_TEST_CASE(frame_read_ahead_past_end_test)
+{
+	int64_t const end = 20;
+
+	FrameReadAhead<shared_ptr<int64_t>> read_ahead(
+		[end](int64_t frame) {
+			if (frame >= end) {
+				throw std::runtime_error("no such frame");
+			}
+			return make_shared<int64_t>(frame);
+		},
+		end,
+		4
+		);
+
+	for (int64_t i = 0; i < end; ++i) {
+		BOOST_REQUIRE_EQUAL(*read_ahead.get(i), i);
+	}
+
+	BOOST_CHECK_THROW(read_ahead.get(end), std::runtime_error);
+	BOOST_CHECK_THROW(read_ahead.get(end + 1), std::runtime_error);
+
+	/* And we should still be able to go back */
+	BOOST_CHECK_EQUAL(*read_ahead.get(end - 1), end - 1);
+}
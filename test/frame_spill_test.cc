@@ -0,0 +1,128 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+/** @file  test/frame_spill_test.cc
+ *  @brief Test FrameSpill.
+ *  @ingroup selfcontained
+ */
+
+
+#include "lib/frame_spill.h"
+#include <dcp/array_data.h>
+#include <boost/test/unit_test.hpp>
+#include <cstring>
+
+
+static
+dcp::ArrayData
+frame_data(int size, uint8_t value)
+{
+	dcp::ArrayData data(size);
+	memset(data.data(), value, size);
+	return data;
+}
+
+
+static
+void
+check_frame(FrameSpill& spill, Frame frame, Eyes eyes, int size, uint8_t value)
+{
+	BOOST_REQUIRE(spill.has(frame, eyes));
+	auto data = spill.get(frame, eyes);
+	BOOST_REQUIRE_EQUAL(data->size(), size);
+	for (int i = 0; i < size; ++i) {
+		BOOST_REQUIRE_EQUAL(data->data()[i], value);
+	}
+	BOOST_CHECK(!spill.has(frame, eyes));
+}
+
+
+/** Put some frames in and check that we get the same ones back */
+BOOST_AUTO_TEST_CASE(frame_spill_test)
+{
+	boost::filesystem::path const path = "build/test/frame_spill_test.spill";
+
+	{
+		FrameSpill spill(path);
+		BOOST_CHECK(boost::filesystem::exists(path));
+
+		spill.put(0, Eyes::BOTH, frame_data(1000, 1));
+		spill.put(1, Eyes::LEFT, frame_data(2000, 2));
+		spill.put(1, Eyes::RIGHT, frame_data(3000, 3));
+		spill.put(4, Eyes::BOTH, frame_data(500, 4));
+		BOOST_CHECK(!spill.has(1, Eyes::BOTH));
+		BOOST_CHECK_EQUAL(spill.size(), 6500);
+
+		/* Replacing a frame should give us the new data */
+		spill.put(4, Eyes::BOTH, frame_data(400, 5));
+
+		check_frame(spill, 1, Eyes::RIGHT, 3000, 3);
+		check_frame(spill, 4, Eyes::BOTH, 400, 5);
+		check_frame(spill, 0, Eyes::BOTH, 1000, 1);
+		check_frame(spill, 1, Eyes::LEFT, 2000, 2);
+	}
+
+	BOOST_CHECK(!boost::filesystem::exists(path));
+}
+
+
+/** Check that the file starts again from the beginning once everything has been taken out */
+BOOST_AUTO_TEST_CASE(frame_spill_reset_test)
+{
+	FrameSpill spill("build/test/frame_spill_reset_test.spill");
+
+	for (int i = 0; i < 4; ++i) {
+		spill.put(i, Eyes::BOTH, frame_data(1000, i));
+	}
+	BOOST_CHECK_EQUAL(spill.size(), 4000);
+
+	for (int i = 0; i < 4; ++i) {
+		check_frame(spill, i, Eyes::BOTH, 1000, i);
+	}
+	BOOST_CHECK_EQUAL(spill.size(), 0);
+
+	spill.put(4, Eyes::BOTH, frame_data(1500, 4));
+	BOOST_CHECK_EQUAL(spill.size(), 1500);
+	check_frame(spill, 4, Eyes::BOTH, 1500, 4);
+}
+
+
+/** Check that the file does not keep growing when some frames are always in it */
+BOOST_AUTO_TEST_CASE(frame_spill_reuse_test)
+{
+	FrameSpill spill("build/test/frame_spill_reuse_test.spill");
+
+	/* Keep 8 frames in the spill, taking out the oldest whenever we put a new one in */
+	for (int i = 0; i < 8; ++i) {
+		spill.put(i, Eyes::BOTH, frame_data(1000 - i, i));
+	}
+
+	for (int i = 8; i < 1000; ++i) {
+		check_frame(spill, i - 8, Eyes::BOTH, 1000 - ((i - 8) % 8), (i - 8) & 0xff);
+		spill.put(i, Eyes::BOTH, frame_data(1000 - (i % 8), i & 0xff));
+		BOOST_REQUIRE(spill.size() <= 8000);
+	}
+
+	for (int i = 992; i < 1000; ++i) {
+		check_frame(spill, i, Eyes::BOTH, 1000 - (i % 8), i & 0xff);
+	}
+	BOOST_CHECK_EQUAL(spill.size(), 0);
+}
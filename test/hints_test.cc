@@ -309,3 +309,40 @@ BOOST_AUTO_TEST_CASE(hints_mpeg2)
 		"encoded with JPEG2000 rather than MPEG2.  Make sure that your cinema really wants an old-style MPEG2 DCP."
 		);
 }
+
+
+/** Check that text is only examined again for content which has changed */
+BOOST_AUTO_TEST_CASE(hints_text_cache)
+{
+	auto early = content_factory("test/data/hint_subtitle_too_early.srt")[0];
+	auto short_subs = content_factory("test/data/hint_short_subtitles.srt")[0];
+	auto film = new_test_film("hints_text_cache", { early, short_subs });
+	for (auto content: film->content()) {
+		content->text[0]->set_language(dcp::LanguageTag("en-US"));
+	}
+
+	auto scan = [film]() {
+		Hints hints(film);
+		hints.disable_audio_analysis();
+		hints.start();
+		hints.join();
+		while (signal_manager->ui_idle()) {}
+		hints.rethrow();
+		return hints.text_scans();
+	};
+
+	BOOST_CHECK_EQUAL(scan(), 2);
+	BOOST_CHECK_EQUAL(scan(), 0);
+
+	short_subs->text[0]->set_y_offset(0.1);
+	BOOST_CHECK_EQUAL(scan(), 1);
+	BOOST_CHECK_EQUAL(scan(), 0);
+
+	/* Hints from the cached text should still be given */
+	auto hints = get_hints(film);
+	BOOST_CHECK(std::find(
+		hints.begin(),
+		hints.end(),
+		"It is advisable to put your first subtitle at least 4 seconds after the start of the DCP to make sure it is seen."
+		) != hints.end());
+}
@@ -19,13 +19,27 @@
 */
 
 
+#include "lib/compose.hpp"
+#include "lib/content_video.h"
+#include "lib/exceptions.h"
+#include "lib/ffmpeg_content.h"
+#include "lib/ffmpeg_decoder.h"
+#include "lib/ffmpeg_film_encoder.h"
 #include "lib/ffmpeg_image_proxy.h"
+#include "lib/ffmpeg_packet_image_proxy.h"
+#include "lib/film.h"
 #include "lib/j2k_image_proxy.h"
+#include "lib/transcode_job.h"
+#include "lib/video_decoder.h"
 #include "test.h"
+#include <libcxml/cxml.h>
 #include <boost/test/unit_test.hpp>
 
 
+using std::dynamic_pointer_cast;
 using std::make_shared;
+using std::shared_ptr;
+using std::vector;
 
 
 static const boost::filesystem::path data_file0 = TestPaths::private_data() / "player_seek_test_0.png";
@@ -65,3 +79,129 @@ BOOST_AUTO_TEST_CASE (ffmpeg_image_proxy_same_test)
 	}
 }
 
+
+BOOST_AUTO_TEST_CASE (ffmpeg_packet_image_proxy_same_test)
+{
+	/* The data is never decoded here, so it doesn't need to be valid */
+	uint8_t data0[] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+	uint8_t data1[] = { 1, 2, 3, 4, 5, 6, 7, 9 };
+
+	auto parameters = avcodec_parameters_alloc();
+	parameters->codec_type = AVMEDIA_TYPE_VIDEO;
+	parameters->codec_id = AV_CODEC_ID_PRORES;
+	parameters->width = 1998;
+	parameters->height = 1080;
+	parameters->format = AV_PIX_FMT_YUV422P10LE;
+
+	BOOST_CHECK (FFmpegPacketImageProxy::suitable(parameters));
+
+	auto packet0 = av_packet_alloc();
+	packet0->data = data0;
+	packet0->size = sizeof(data0);
+
+	auto packet1 = av_packet_alloc();
+	packet1->data = data1;
+	packet1->size = sizeof(data1);
+
+	auto proxy1 = make_shared<FFmpegPacketImageProxy>(packet0, parameters);
+	auto proxy2 = make_shared<FFmpegPacketImageProxy>(packet0, parameters);
+	auto proxy3 = make_shared<FFmpegPacketImageProxy>(packet1, parameters);
+	BOOST_CHECK (proxy1->same(proxy2));
+	BOOST_CHECK (!proxy1->same(proxy3));
+
+	/* Packets don't own the data above */
+	packet0->data = nullptr;
+	packet1->data = nullptr;
+	av_packet_free(&packet0);
+	av_packet_free(&packet1);
+
+	parameters->codec_id = AV_CODEC_ID_H264;
+	BOOST_CHECK (!FFmpegPacketImageProxy::suitable(parameters));
+
+	avcodec_parameters_free(&parameters);
+}
+
+
+/** Check that the images and times we get from FFmpegDecoder when it passes on video packets
+ *  are the same as those we get when it decodes them itself.
+ */
+BOOST_AUTO_TEST_CASE (ffmpeg_packet_image_proxy_decode_test)
+{
+	Cleanup cl;
+
+	/* Make some ProRes to decode */
+	auto source = make_shared<FFmpegContent>("test/data/test.mp4");
+	auto source_film = new_test_film("ffmpeg_packet_image_proxy_decode_test_source", { source }, &cl);
+	auto job = make_shared<TranscodeJob>(source_film, TranscodeJob::ChangedBehaviour::IGNORE);
+	boost::filesystem::path const prores = "build/test/ffmpeg_packet_image_proxy_decode_test.mov";
+	cl.add(prores);
+	FFmpegFilmEncoder encoder(source_film, job, prores, ExportFormat::PRORES_HQ, false, false, false, 23);
+	encoder.go();
+
+	auto content = make_shared<FFmpegContent>(prores);
+	auto film = new_test_film("ffmpeg_packet_image_proxy_decode_test", { content }, &cl);
+
+	auto decode = [film, content](bool pass_packets) {
+		FFmpegDecoder decoder(film, content, false);
+		BOOST_REQUIRE(decoder._pass_video_packets);
+		decoder._pass_video_packets = pass_packets;
+		vector<ContentVideo> video;
+		decoder.video->Data.connect([&video](ContentVideo cv) {
+			video.push_back(cv);
+		});
+		while (!decoder.pass()) {}
+		return video;
+	};
+
+	auto packets = decode(true);
+	auto frames = decode(false);
+
+	BOOST_REQUIRE(!packets.empty());
+	BOOST_REQUIRE_EQUAL(packets.size(), frames.size());
+
+	for (size_t i = 0; i < packets.size(); ++i) {
+		BOOST_REQUIRE(dynamic_pointer_cast<const FFmpegPacketImageProxy>(packets[i].image));
+		BOOST_CHECK(packets[i].time == frames[i].time);
+		for (auto alignment: { Image::Alignment::COMPACT, Image::Alignment::PADDED }) {
+			auto packet_image = packets[i].image->image(alignment).image;
+			BOOST_CHECK(packet_image->alignment() == alignment);
+			BOOST_CHECK(*packet_image == *frames[i].image->image(alignment).image);
+		}
+	}
+
+	cl.run();
+}
+
+
+BOOST_AUTO_TEST_CASE (ffmpeg_packet_image_proxy_bad_sizes_test)
+{
+	auto proxy = [](int width, int height, int64_t extradata_size, int64_t data_size) {
+		auto doc = make_shared<cxml::Document>();
+		doc->read_string(String::compose(
+			"<Proxy>"
+			"<Type>FFmpegPacket</Type>"
+			"<CodecId>%1</CodecId>"
+			"<CodecTag>0</CodecTag>"
+			"<Width>%2</Width>"
+			"<Height>%3</Height>"
+			"<PixelFormat>%4</PixelFormat>"
+			"<BitsPerCodedSample>0</BitsPerCodedSample>"
+			"<Profile>0</Profile>"
+			"<ExtradataSize>%5</ExtradataSize>"
+			"<DataSize>%6</DataSize>"
+			"</Proxy>",
+			static_cast<int>(AV_CODEC_ID_PRORES), width, height, static_cast<int>(AV_PIX_FMT_YUV422P10LE), extradata_size, data_size
+			));
+		/* None of these should get as far as reading from the socket */
+		make_shared<FFmpegPacketImageProxy>(doc, shared_ptr<Socket>());
+	};
+
+	BOOST_CHECK_THROW(proxy(0, 1080, 0, 4096), NetworkError);
+	BOOST_CHECK_THROW(proxy(1998, -1, 0, 4096), NetworkError);
+	BOOST_CHECK_THROW(proxy(1000000, 1080, 0, 4096), NetworkError);
+	BOOST_CHECK_THROW(proxy(1998, 1080, -1, 4096), NetworkError);
+	BOOST_CHECK_THROW(proxy(1998, 1080, int64_t(1) << 40, 4096), NetworkError);
+	BOOST_CHECK_THROW(proxy(1998, 1080, 0, 0), NetworkError);
+	BOOST_CHECK_THROW(proxy(1998, 1080, 0, -4096), NetworkError);
+	BOOST_CHECK_THROW(proxy(1998, 1080, 0, int64_t(1998) * 1080 * 1024), NetworkError);
+}
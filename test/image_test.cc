@@ -27,20 +27,26 @@
 
 
 #include "lib/compose.hpp"
+#include "lib/config.h"
 #include "lib/image.h"
 #include "lib/image_content.h"
 #include "lib/image_decoder.h"
+#include "lib/image_pool.h"
 #include "lib/image_jpeg.h"
 #include "lib/image_png.h"
 #include "lib/ffmpeg_image_proxy.h"
+#include "lib/sws_context_cache.h"
 #include "test.h"
 #include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
 
 using std::cout;
 using std::list;
 using std::make_shared;
+using std::shared_ptr;
 using std::string;
 
 
@@ -334,6 +340,39 @@ BOOST_AUTO_TEST_CASE(alpha_blend_test_rgba64be_onto_xyz)
 }
 
 
+/** Test that transparent parts of an image being blended leave the target alone */
+BOOST_AUTO_TEST_CASE(alpha_blend_transparent_test)
+{
+	for (auto format: { AV_PIX_FMT_RGB24, AV_PIX_FMT_YUV420P }) {
+		auto target = make_shared<Image>(format, dcp::Size(64, 48), Image::Alignment::PADDED);
+		for (int c = 0; c < target->planes(); ++c) {
+			memset(target->data()[c], 77, target->stride()[c] * target->sample_size(c).height);
+		}
+		auto const original = make_shared<Image>(*target);
+
+		/* BGRA overlay which is transparent apart from an opaque white block at (8, 4) to (16, 12) */
+		auto overlay = make_shared<Image>(AV_PIX_FMT_BGRA, dcp::Size(32, 24), Image::Alignment::PADDED);
+		overlay->make_transparent();
+		for (int y = 4; y < 12; ++y) {
+			memset(overlay->data()[0] + y * overlay->stride()[0] + 8 * 4, 255, 8 * 4);
+		}
+
+		target->alpha_blend(overlay, Position<int>(10, 6));
+
+		/* Only the block should have changed */
+		auto const stride = target->stride()[0];
+		auto const bpp = format == AV_PIX_FMT_RGB24 ? 3 : 1;
+		for (int y = 0; y < 48; ++y) {
+			for (int x = 0; x < 64; ++x) {
+				auto const offset = y * stride + x * bpp;
+				bool const inside = 18 <= x && x < 26 && 10 <= y && y < 18;
+				BOOST_REQUIRE_EQUAL(target->data()[0][offset] != original->data()[0][offset], inside);
+			}
+		}
+	}
+}
+
+
 BOOST_AUTO_TEST_CASE(alpha_blend_text)
 {
 	Image target(AV_PIX_FMT_RGB24, dcp::Size(1998, 1080), Image::Alignment::PADDED);
@@ -536,6 +575,66 @@ BOOST_AUTO_TEST_CASE (crop_scale_window_test8)
 }
 
 
+/** Check that scaling the same way twice re-uses a scaler context and gives the same result */
+BOOST_AUTO_TEST_CASE(crop_scale_window_reuses_context_test)
+{
+	auto proxy = make_shared<FFmpegImageProxy>("test/data/flat_red.png");
+	auto raw = proxy->image(Image::Alignment::PADDED).image;
+
+	auto scale = [raw]() {
+		return raw->crop_scale_window(
+			Crop(), dcp::Size(1234, 556), dcp::Size(1998, 1080), dcp::YUVToRGB::REC709, VideoRange::FULL, AV_PIX_FMT_YUV420P, VideoRange::FULL, Image::Alignment::COMPACT, false
+			);
+	};
+
+	auto const before = SwsContextCache::statistics();
+	auto first = scale();
+	auto const middle = SwsContextCache::statistics();
+	auto second = scale();
+	auto const after = SwsContextCache::statistics();
+
+	BOOST_CHECK_EQUAL(middle.made, before.made + 1);
+	BOOST_CHECK_EQUAL(after.made, middle.made);
+	BOOST_CHECK_EQUAL(after.reused, middle.reused + 1);
+
+	for (int c = 0; c < first->planes(); ++c) {
+		BOOST_CHECK_EQUAL(memcmp(first->data()[c], second->data()[c], first->stride()[c] * first->sample_size(c).height), 0);
+	}
+}
+
+
+/** Check that the memory for an image is re-used for the next one of the same size */
+BOOST_AUTO_TEST_CASE(image_pool_test)
+{
+	auto pool = ImagePool::instance();
+	pool->set_limit(0);
+	pool->set_limit(64 * 1024 * 1024);
+
+	auto const before = pool->statistics();
+	uint8_t* y = nullptr;
+	{
+		Image image(AV_PIX_FMT_YUV420P, dcp::Size(1234, 567), Image::Alignment::PADDED);
+		y = image.data()[0];
+	}
+	BOOST_CHECK(pool->memory_used() > 0);
+
+	Image image(AV_PIX_FMT_YUV420P, dcp::Size(1234, 567), Image::Alignment::PADDED);
+	BOOST_CHECK(image.data()[0] == y);
+	auto const after = pool->statistics();
+	BOOST_CHECK_EQUAL(after.misses, before.misses + 3);
+	BOOST_CHECK_EQUAL(after.hits, before.hits + 3);
+	BOOST_CHECK_EQUAL(pool->memory_used(), 0U);
+
+	/* Nothing should be kept when the limit is 0 */
+	pool->set_limit(0);
+	{
+		Image other(AV_PIX_FMT_RGB24, dcp::Size(64, 64), Image::Alignment::PADDED);
+	}
+	BOOST_CHECK_EQUAL(pool->memory_used(), 0U);
+	pool->set_limit(static_cast<size_t>(Config::instance()->image_pool_size()) * 1024 * 1024);
+}
+
+
 BOOST_AUTO_TEST_CASE (as_png_test)
 {
 	auto proxy = make_shared<FFmpegImageProxy>("test/data/3d_test/000001.png");
@@ -614,6 +713,141 @@ BOOST_AUTO_TEST_CASE (fade_test)
 }
 
 
+static void
+fill_with_noise(shared_ptr<Image> image)
+{
+	uint32_t seed = 42;
+	for (int c = 0; c < image->planes(); ++c) {
+		for (int i = 0; i < image->stride()[c] * image->sample_size(c).height; ++i) {
+			seed = seed * 1664525 + 1013904223;
+			image->data()[c][i] = seed >> 24;
+		}
+	}
+}
+
+
+/** Check that fading in bands across several threads gives the same result as doing it in one go */
+BOOST_AUTO_TEST_CASE(fade_slice_threads_test)
+{
+	ConfigRestorer cr;
+
+	for (auto format: { AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUV422P10, AV_PIX_FMT_RGB24, AV_PIX_FMT_XYZ12LE, AV_PIX_FMT_RGB48LE }) {
+		auto image = make_shared<Image>(format, dcp::Size(1998, 1081), Image::Alignment::PADDED);
+		fill_with_noise(image);
+
+		auto single = make_shared<Image>(*image);
+		Config::instance()->set_slice_threads(1);
+		single->fade(0.3);
+
+		auto sliced = make_shared<Image>(*image);
+		Config::instance()->set_slice_threads(5);
+		sliced->fade(0.3);
+
+		BOOST_CHECK(*single == *sliced);
+	}
+}
+
+
+/** Straightforward version of Image::fade to check the real one against */
+static void
+reference_fade(Image& image, float f)
+{
+	for (int c = 0; c < image.planes(); ++c) {
+		for (int y = 0; y < image.sample_size(c).height; ++y) {
+			auto const line = image.data()[c] + y * image.stride()[c];
+			switch (image.pixel_format()) {
+			case AV_PIX_FMT_YUV420P:
+			case AV_PIX_FMT_RGB24:
+				for (int x = 0; x < image.line_size()[c]; ++x) {
+					if (c == 0 || image.pixel_format() == AV_PIX_FMT_RGB24) {
+						line[x] = int(float(line[x]) * f);
+					} else {
+						line[x] = 127 + int((int(line[x]) - 127) * f);
+					}
+				}
+				break;
+			default:
+			{
+				auto p = reinterpret_cast<uint16_t*>(line);
+				for (int x = 0; x < image.line_size()[c] / 2; ++x) {
+					if (c == 0 || image.pixel_format() != AV_PIX_FMT_YUV422P10LE) {
+						p[x] = int(float(p[x]) * f);
+					} else {
+						p[x] = 511 + int((int(p[x]) - 511) * f);
+					}
+				}
+				break;
+			}
+			}
+		}
+	}
+}
+
+
+/** Check that Image::fade gives exactly the same results as the obvious way of doing it */
+BOOST_AUTO_TEST_CASE(fade_bit_exact_test)
+{
+	for (auto format: { AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUV422P10LE, AV_PIX_FMT_RGB24, AV_PIX_FMT_XYZ12LE, AV_PIX_FMT_RGB48LE }) {
+		for (auto f: { 0.0f, 0.25f, 0.5f, 0.731f, 1.0f }) {
+			auto image = make_shared<Image>(format, dcp::Size(1998, 1080), Image::Alignment::PADDED);
+			fill_with_noise(image);
+			Image reference(*image);
+
+			image->fade(f);
+			reference_fade(reference, f);
+			BOOST_CHECK(*image == reference);
+		}
+	}
+}
+
+
+/** Straightforward version of Image::video_range_to_full_range to check the real one against */
+static void
+reference_video_range_to_full_range(Image& image)
+{
+	for (int c = 0; c < image.planes(); ++c) {
+		for (int y = 0; y < image.sample_size(c).height; ++y) {
+			auto const line = image.data()[c] + y * image.stride()[c];
+			auto const line16 = reinterpret_cast<uint16_t*>(line);
+			switch (image.pixel_format()) {
+			case AV_PIX_FMT_RGB24:
+				for (int x = 0; x < image.line_size()[c]; ++x) {
+					line[x] = std::clamp(lrintf((line[x] - 16) * float(256.0 / 219.0)), 0L, 255L);
+				}
+				break;
+			case AV_PIX_FMT_RGB48LE:
+				for (int x = 0; x < image.line_size()[c] / 2; ++x) {
+					line16[x] = std::clamp(lrintf((line16[x] - 4096) * float(65536.0 / 56064.0)), 0L, 65535L);
+				}
+				break;
+			case AV_PIX_FMT_GBRP12LE:
+				for (int x = 0; x < image.line_size()[c] / 2; ++x) {
+					line16[x] = std::clamp(lrintf((line16[x] - 256) * float(4096.0 / 3504.0)), 0L, 4095L);
+				}
+				break;
+			default:
+				BOOST_REQUIRE(false);
+			}
+		}
+	}
+}
+
+
+/** Check that Image::video_range_to_full_range gives exactly the same results as the obvious way of doing it */
+BOOST_AUTO_TEST_CASE(video_range_to_full_range_test)
+{
+	for (auto format: { AV_PIX_FMT_RGB24, AV_PIX_FMT_RGB48LE, AV_PIX_FMT_GBRP12LE }) {
+		auto image = make_shared<Image>(format, dcp::Size(1998, 1080), Image::Alignment::PADDED);
+		fill_with_noise(image);
+		Image reference(*image);
+
+		image->video_range_to_full_range();
+		reference_video_range_to_full_range(reference);
+		BOOST_CHECK(*image == reference);
+	}
+}
+
+
 BOOST_AUTO_TEST_CASE (make_black_test)
 {
 	dcp::Size in_size (512, 512);
@@ -21,6 +21,8 @@
 
 #include "lib/config.h"
 #include "lib/content_factory.h"
+#include "lib/cpu_j2k_encoder_thread.h"
+#include "lib/dcp_video.h"
 #include "lib/dcp_film_encoder.h"
 #include "lib/dcp_transcode_job.h"
 #include "lib/encode_server_description.h"
@@ -32,6 +34,7 @@
 #include "lib/job_manager.h"
 #include "lib/make_dcp.h"
 #include "lib/transcode_job.h"
+#include "lib/util.h"
 #include "test.h"
 #include <dcp/cpl.h>
 #include <dcp/dcp.h>
@@ -119,6 +122,57 @@ BOOST_AUTO_TEST_CASE(frames_not_lost_when_threads_disappear)
 }
 
 
+BOOST_AUTO_TEST_CASE(j2k_encoder_schedule_test)
+{
+	auto film = new_test_film("j2k_encoder_schedule_test", {});
+	Writer writer(film, {}, "foo");
+	J2KEncoder encoder(film, writer);
+
+	for (int i = 0; i < 10; ++i) {
+		encoder._queue.push_back(DCPVideo({}, i, 24, 100000000, Resolution::TWO_K));
+	}
+
+	/* Make the encoder think that it's writing frames very quickly */
+	for (int i = 0; i < 200; ++i) {
+		encoder._history.event();
+	}
+
+	struct timeval tv;
+	gettimeofday(&tv, 0);
+	auto const now = seconds(tv);
+
+	CPUJ2KEncoderThread fast(encoder);
+	CPUJ2KEncoderThread slow(encoder);
+	CPUJ2KEncoderThread unknown(encoder);
+
+	encoder._workers[&fast].latency = 0.1;
+	encoder._workers[&fast].last_active = now;
+	encoder._workers[&slow].latency = 1;
+	encoder._workers[&slow].last_active = now;
+
+	/* The fastest thread, and any that we know nothing about, get the frame that the writer needs next */
+	BOOST_CHECK_EQUAL(encoder.choose(&fast, now)->index(), 0);
+	BOOST_CHECK_EQUAL(encoder.choose(&unknown, now)->index(), 0);
+	BOOST_CHECK_EQUAL(encoder.choose(nullptr, now)->index(), 0);
+	/* The slow one gets a frame later on */
+	BOOST_CHECK_EQUAL(encoder.choose(&slow, now)->index(), 9);
+
+	auto frame = encoder.take(encoder.choose(&slow, now), &slow, now);
+	BOOST_CHECK_EQUAL(frame.index(), 9);
+	BOOST_CHECK_EQUAL(encoder._queue.size(), 9U);
+
+	/* If the fast thread goes quiet the slow one should not leave the early frames waiting for it */
+	encoder._workers[&fast].last_active = now - 60;
+	BOOST_CHECK_EQUAL(encoder.choose(&slow, now)->index(), 0);
+
+	/* Frames that are retried go back in order */
+	encoder.retry(frame);
+	BOOST_REQUIRE_EQUAL(encoder._queue.size(), 10U);
+	BOOST_CHECK_EQUAL(encoder._queue.back().index(), 9);
+	BOOST_CHECK(encoder._workers[&slow].started.empty());
+}
+
+
 #ifdef DCPOMATIC_GROK
 BOOST_AUTO_TEST_CASE(transcode_stops_when_gpu_enabled_with_no_gpu)
 {
@@ -25,9 +25,11 @@
  */
 
 
+#include "lib/config.h"
 #include "lib/cross.h"
 #include "lib/job.h"
 #include "lib/job_manager.h"
+#include "test.h"
 #include <boost/test/unit_test.hpp>
 
 
@@ -40,8 +42,10 @@ using std::vector;
 class TestJob : public Job
 {
 public:
-	explicit TestJob (shared_ptr<Film> film)
+	explicit TestJob (shared_ptr<Film> film, Resource resource = Resource::ENCODE, bool read_only = false)
 		: Job (film)
+		, _resource (resource)
+		, _read_only (read_only)
 	{
 
 	}
@@ -76,6 +80,18 @@ public:
 	string json_name () const override {
 		return "";
 	}
+
+	Resource resource () const override {
+		return _resource;
+	}
+
+	bool read_only () const override {
+		return _read_only;
+	}
+
+private:
+	Resource _resource;
+	bool _read_only;
 };
 
 
@@ -161,3 +177,103 @@ BOOST_AUTO_TEST_CASE(cancel_job_test)
 	BOOST_CHECK(jobs[1]->finished_cancelled());
 }
 
+
+BOOST_AUTO_TEST_CASE(job_manager_resources_test)
+{
+	ConfigRestorer cr;
+
+	shared_ptr<Film> film;
+
+	auto encode1 = make_shared<TestJob>(film, Job::Resource::ENCODE);
+	auto encode2 = make_shared<TestJob>(film, Job::Resource::ENCODE);
+	auto io = make_shared<TestJob>(film, Job::Resource::IO);
+	auto analysis1 = make_shared<TestJob>(film, Job::Resource::ANALYSIS);
+	auto analysis2 = make_shared<TestJob>(film, Job::Resource::ANALYSIS);
+
+	auto jm = JobManager::instance();
+	Config::instance()->set_maximum_analysis_jobs(2);
+
+	for (auto job: { encode1, encode2, io, analysis1, analysis2 }) {
+		jm->add(job);
+	}
+
+	/* One of the encodes, the IO job and both analyses should run */
+	dcpomatic_sleep_seconds(1);
+	BOOST_CHECK(encode1->running());
+	BOOST_CHECK(!encode2->running());
+	BOOST_CHECK(io->running());
+	BOOST_CHECK(analysis1->running());
+	BOOST_CHECK(analysis2->running());
+
+	/* Priority should still decide which encode runs */
+	jm->increase_priority(encode2);
+	dcpomatic_sleep_seconds(1);
+	BOOST_CHECK(encode1->paused_by_priority());
+	BOOST_CHECK(encode2->running());
+	BOOST_CHECK(io->running());
+
+	/* Lowering the limit should pause the lower-priority analysis */
+	Config::instance()->set_maximum_analysis_jobs(1);
+	dcpomatic_sleep_seconds(1);
+	BOOST_CHECK(analysis1->running());
+	BOOST_CHECK(analysis2->paused_by_priority());
+
+	encode2->set_finished_ok();
+	analysis1->set_finished_ok();
+	dcpomatic_sleep_seconds(1);
+	BOOST_CHECK(encode1->running());
+	BOOST_CHECK(analysis2->running());
+
+	for (auto job: { encode1, io, analysis2 }) {
+		job->set_finished_ok();
+	}
+
+	BOOST_REQUIRE(!wait_for_jobs());
+}
+
+
+BOOST_AUTO_TEST_CASE(job_manager_same_film_test)
+{
+	ConfigRestorer cr;
+	Config::instance()->set_maximum_analysis_jobs(2);
+
+	auto film_a = new_test_film("job_manager_same_film_test_a");
+	auto film_b = new_test_film("job_manager_same_film_test_b");
+
+	auto check_a = make_shared<TestJob>(film_a, Job::Resource::IO);
+	auto encode_a = make_shared<TestJob>(film_a, Job::Resource::ENCODE);
+	auto encode_b = make_shared<TestJob>(film_b, Job::Resource::ENCODE);
+	auto analysis_b1 = make_shared<TestJob>(film_b, Job::Resource::ANALYSIS, true);
+	auto analysis_b2 = make_shared<TestJob>(film_b, Job::Resource::ANALYSIS, true);
+
+	auto jm = JobManager::instance();
+	for (auto job: { check_a, encode_a, encode_b, analysis_b1, analysis_b2 }) {
+		jm->add(job);
+	}
+
+	/* film_a's encode must wait for its check, so film_b's encode can have the encoding slot,
+	 * and film_b's analyses must wait for its encode.
+	 */
+	dcpomatic_sleep_seconds(1);
+	BOOST_CHECK(check_a->running());
+	BOOST_CHECK(!encode_a->running());
+	BOOST_CHECK(encode_b->running());
+	BOOST_CHECK(!analysis_b1->running());
+	BOOST_CHECK(!analysis_b2->running());
+
+	/* Jobs which only read a film can run together */
+	encode_b->set_finished_ok();
+	dcpomatic_sleep_seconds(1);
+	BOOST_CHECK(analysis_b1->running());
+	BOOST_CHECK(analysis_b2->running());
+
+	check_a->set_finished_ok();
+	dcpomatic_sleep_seconds(1);
+	BOOST_CHECK(encode_a->running());
+
+	for (auto job: { encode_a, analysis_b1, analysis_b2 }) {
+		job->set_finished_ok();
+	}
+
+	BOOST_REQUIRE(!wait_for_jobs());
+}
@@ -257,3 +257,63 @@ BOOST_AUTO_TEST_CASE(directory_kdm_naming_test)
 	BOOST_CHECK_MESSAGE (boost::filesystem::exists(base / dir_b / ref), "File " << ref << " not found");
 }
 
+
+/** Check that kdms_for_screens makes one KDM per screen, in order, and only makes the decrypted KDM once */
+BOOST_AUTO_TEST_CASE(kdms_for_screens_test)
+{
+	Context context;
+	CinemaList cinemas;
+
+	auto film = new_test_film("kdms_for_screens_test", { content_factory("test/data/flat_black.png")[0] });
+	film->set_encrypted(true);
+	make_and_verify_dcp(film);
+	auto cpls = film->cpls();
+	BOOST_REQUIRE(cpls.size() == 1);
+
+	auto sign_cert = Config::instance()->signer_chain()->leaf();
+
+	dcp::LocalTime from(sign_cert.not_before());
+	from.add_months(2);
+	dcp::LocalTime until(sign_cert.not_after());
+	until.add_months(-2);
+
+	vector<pair<CinemaID, ScreenID>> ids = {
+		{ context.cinema_b, context.cinema_b_screen_y },
+		{ context.cinema_a, context.cinema_a_screen_2 },
+		{ context.cinema_b, context.cinema_b_screen_x },
+		{ context.cinema_a, context.cinema_a_screen_1 },
+		{ context.cinema_b, context.cinema_b_screen_z }
+	};
+
+	vector<ScreenDetails> screens;
+	for (auto const& id: ids) {
+		screens.emplace_back(id.first, *cinemas.cinema(id.first), *cinemas.screen(id.second));
+	}
+
+	int calls = 0;
+	auto const cpl = cpls.front().cpl_file;
+	std::function<dcp::DecryptedKDM (dcp::LocalTime, dcp::LocalTime)> make_kdm = [film, cpl, &calls](dcp::LocalTime begin, dcp::LocalTime end) {
+		++calls;
+		return film->make_kdm(cpl, begin, end);
+	};
+
+	std::vector<KDMCertificatePeriod> period_checks;
+	auto kdms = kdms_for_screens(make_kdm, screens, from, until, dcp::Formulation::MODIFIED_TRANSITIONAL_1, false, optional<int>(), period_checks);
+
+	BOOST_CHECK_EQUAL(calls, 1);
+	BOOST_REQUIRE_EQUAL(kdms.size(), screens.size());
+	BOOST_CHECK_EQUAL(period_checks.size(), screens.size());
+
+	auto screen = screens.begin();
+	for (auto kdm: kdms) {
+		BOOST_CHECK_EQUAL(kdm->get('c').get_value_or(""), screen->cinema.name);
+		BOOST_CHECK_EQUAL(kdm->get('s').get_value_or(""), screen->screen.name);
+		BOOST_CHECK_EQUAL(kdm->get('i').get_value_or(""), cpls.front().cpl_id);
+
+		/* Each KDM should be decryptable by its recipient and contain the film's key */
+		dcp::DecryptedKDM decrypted(dcp::EncryptedKDM(kdm->kdm_as_xml()), Config::instance()->decryption_chain()->key().get());
+		BOOST_REQUIRE(!decrypted.keys().empty());
+		BOOST_CHECK(decrypted.keys().front().key() == film->key());
+		++screen;
+	}
+}
@@ -0,0 +1,106 @@
+/*
+    Copyright (C) 2026 Carl Hetherington <cth@carlh.net>
+
+    This file is part of DCP-o-matic.
+
+    DCP-o-matic is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    DCP-o-matic is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with DCP-o-matic.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+
+#include "lib/pcm_unpack.h"
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <climits>
+#include <vector>
+
+
+using std::vector;
+
+
+static
+vector<uint8_t>
+random_bytes(int size)
+{
+	vector<uint8_t> bytes(size);
+	for (auto& i: bytes) {
+		i = rand() & 0xff;
+	}
+	/* Make sure the extremes are in there */
+	for (int i = 0; i < std::min(size, 6); ++i) {
+		bytes[i] = i < 3 ? 0xff : 0;
+	}
+	bytes[size - 1] = 0x80;
+	return bytes;
+}
+
+
+/** Check that the PCM conversions give exactly the same results as the simple loops that they replaced */
+BOOST_AUTO_TEST_CASE(pcm_unpack_test)
+{
+	srand(42);
+
+	/* An odd number of samples, so that there are some left over after any vectorised part */
+	int const samples = 16 * 2001 + 3;
+	vector<float> out(samples);
+
+	{
+		auto in = random_bytes(samples * 3);
+		unpack_pcm_24(in.data(), samples, out.data());
+		auto from = in.data();
+		for (int i = 0; i < samples; ++i) {
+			float const ref = static_cast<int>((from[0] << 8) | (from[1] << 16) | (static_cast<unsigned>(from[2]) << 24)) / static_cast<float>(INT_MAX - 256);
+			BOOST_REQUIRE_EQUAL(out[i], ref);
+			from += 3;
+		}
+	}
+
+	{
+		auto in = random_bytes(samples * 2);
+		unpack_pcm_16(in.data(), samples, out.data());
+		auto from = in.data();
+		for (int i = 0; i < samples; ++i) {
+			float const ref = static_cast<int>(from[0] << 16 | (static_cast<unsigned>(from[1]) << 24)) / static_cast<float>(INT_MAX - 256);
+			BOOST_REQUIRE_EQUAL(out[i], ref);
+			from += 2;
+		}
+	}
+
+	{
+		auto in = random_bytes(samples);
+		unpack_u8(in.data(), samples, out.data());
+		for (int i = 0; i < samples; ++i) {
+			BOOST_REQUIRE_EQUAL(out[i], float(in[i]) / (1 << 23));
+		}
+	}
+
+	{
+		auto bytes = random_bytes(samples * 2);
+		auto in = reinterpret_cast<int16_t const*>(bytes.data());
+		unpack_s16(in, samples, out.data());
+		for (int i = 0; i < samples; ++i) {
+			BOOST_REQUIRE_EQUAL(out[i], float(in[i]) / (1 << 15));
+		}
+	}
+
+	{
+		auto bytes = random_bytes(samples * 4);
+		auto in = reinterpret_cast<int32_t const*>(bytes.data());
+		unpack_s32(in, samples, out.data());
+		for (int i = 0; i < samples; ++i) {
+			BOOST_REQUIRE_EQUAL(out[i], static_cast<float>(in[i]) / 2147483648);
+		}
+	}
+}
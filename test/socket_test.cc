@@ -42,12 +42,13 @@ using boost::bind;
 class TestServer : public Server
 {
 public:
-	TestServer (bool digest)
+	TestServer (bool digest, bool compressed = false)
 		: Server (TEST_SERVER_PORT, 30)
 		, _buffer (TEST_SERVER_BUFFER_LENGTH)
 		, _size (0)
 		, _result (false)
 		, _digest (digest)
+		, _compressed (compressed)
 	{
 		_thread = boost::thread(bind(&TestServer::run, this));
 	}
@@ -83,12 +84,26 @@ public:
 		return _result;
 	}
 
+	uint64_t network_bytes_read () const {
+		return _network_bytes_read;
+	}
+
 private:
 	void handle (std::shared_ptr<Socket> socket) override
 	{
 		boost::mutex::scoped_lock lm (_mutex);
 		BOOST_REQUIRE (_size);
-		if (_digest) {
+		if (_compressed) {
+			Socket::ReadDigestScope ds (socket);
+			{
+				Socket::ReadCompressionScope cs (socket);
+				socket->read (_buffer.data(), _size);
+			}
+			_size = 0;
+			_result = ds.check();
+			_network_bytes_read = socket->network_bytes_read();
+			_condition.notify_one ();
+		} else if (_digest) {
 			Socket::ReadDigestScope ds (socket);
 			socket->read (_buffer.data(), _size);
 			_size = 0;
@@ -108,6 +123,8 @@ private:
 	int _size;
 	bool _result;
 	bool _digest;
+	bool _compressed;
+	uint64_t _network_bytes_read = 0;
 };
 
 
@@ -180,3 +197,28 @@ BOOST_AUTO_TEST_CASE (socket_digest_test2)
 	BOOST_CHECK (server.result());
 }
 
+
+/** Check that data sent in a compression scope is decompressed properly */
+BOOST_AUTO_TEST_CASE (socket_compression_test)
+{
+	TestServer server(true, true);
+	server.expect (1000);
+
+	std::vector<uint8_t> data(1000);
+	for (size_t i = 0; i < data.size(); ++i) {
+		data[i] = i % 7;
+	}
+
+	auto socket = make_shared<Socket>();
+	socket->connect("127.0.0.1", TEST_SERVER_PORT);
+	{
+		Socket::WriteDigestScope ds(socket);
+		Socket::WriteCompressionScope cs(socket);
+		socket->write(data.data(), data.size());
+	}
+
+	server.await ();
+	BOOST_CHECK_EQUAL(memcmp(server.buffer(), data.data(), data.size()), 0);
+	BOOST_CHECK (server.result());
+	BOOST_CHECK (server.network_bytes_read() < data.size());
+}
@@ -41,6 +41,7 @@
 #include "lib/make_dcp.h"
 #include "lib/ratio.h"
 #include "lib/signal_manager.h"
+#include "lib/slice_threads.h"
 #include "lib/util.h"
 #include "test.h"
 #include <dcp/cpl.h>
@@ -185,6 +186,7 @@ struct TestConfig
 	~TestConfig ()
 	{
 		JobManager::drop ();
+		SliceThreads::drop();
 	}
 };
 
@@ -27,9 +27,12 @@
 
 #include "lib/util.h"
 #include "lib/cross.h"
+#include "lib/digest_index.h"
 #include "lib/exceptions.h"
 #include "test.h"
 #include <dcp/certificate_chain.h>
+#include <dcp/file.h>
+#include <dcp/filesystem.h>
 #include <fmt/format.h>
 #include <boost/bind/bind.hpp>
 #include <boost/date_time/c_local_time_adjustor.hpp>
@@ -68,6 +71,62 @@ BOOST_AUTO_TEST_CASE (digest_head_tail_test)
 }
 
 
+BOOST_AUTO_TEST_CASE(digest_index_test)
+{
+	vector<vector<boost::filesystem::path>> paths = {
+		{ "test/data/digest.test" },
+		{ "test/data/digest.test", "test/data/digest.test2" },
+		{ "test/data/digest.test3", "test/data/digest.test", "test/data/digest.test2", "test/data/digest.test4" },
+		{ "test/data/flat_red.png" }
+	};
+
+	DigestIndex index;
+
+	/* Digests should be the same as simple_digest() gives, and be remembered */
+	for (auto const& p: paths) {
+		BOOST_CHECK_EQUAL(index.digest(p), simple_digest(p));
+	}
+	BOOST_CHECK_EQUAL(index.statistics().misses, 4);
+	for (auto const& p: paths) {
+		BOOST_CHECK_EQUAL(index.digest(p), simple_digest(p));
+	}
+	BOOST_CHECK_EQUAL(index.statistics().hits, 4);
+
+	/* A file which changes should have its digest calculated again */
+	boost::filesystem::path const changing = "build/test/digest_index_test";
+	auto write = [changing](int size, uint8_t value) {
+		dcp::File file(changing, "wb");
+		BOOST_REQUIRE(file);
+		vector<uint8_t> data(size, value);
+		file.write(data.data(), 1, data.size());
+	};
+
+	write(2000000, 1);
+	BOOST_CHECK_EQUAL(index.digest({changing}), simple_digest({changing}));
+	write(3000000, 2);
+	BOOST_CHECK_EQUAL(index.digest({changing}), simple_digest({changing}));
+	/* ... even if its size does not change and it is written again within the same second */
+	dcpomatic_sleep_milliseconds(50);
+	write(3000000, 3);
+	BOOST_CHECK_EQUAL(index.digest({changing}), simple_digest({changing}));
+	BOOST_CHECK_EQUAL(index.statistics().misses, 7);
+
+	/* The index should survive being written and read back */
+	index.write();
+	BOOST_CHECK(boost::filesystem::exists(State::write_path("digests.xml")));
+	BOOST_CHECK(!boost::filesystem::exists(State::write_path("digests.xml.tmp")));
+	DigestIndex copy;
+	copy.read();
+	for (auto const& p: paths) {
+		BOOST_CHECK_EQUAL(copy.digest(p), simple_digest(p));
+	}
+	BOOST_CHECK_EQUAL(copy.statistics().hits, 4);
+	BOOST_CHECK_EQUAL(copy.statistics().misses, 0);
+
+	BOOST_CHECK_THROW(index.digest({"foobar"}), OpenFileError);
+}
+
+
 BOOST_AUTO_TEST_CASE (timecode_test)
 {
 	auto t = DCPTime::from_seconds (2 * 60 * 60 + 4 * 60 + 31) + DCPTime::from_frames (19, 24);
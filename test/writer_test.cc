@@ -29,9 +29,16 @@
 #include "lib/video_content.h"
 #include "lib/writer.h"
 #include "test.h"
+#include <dcp/cpl.h>
+#include <dcp/dcp.h>
 #include <dcp/openjpeg_image.h>
 #include <dcp/j2k_transcode.h>
+#include <dcp/mono_j2k_picture_asset.h>
+#include <dcp/reel.h>
+#include <dcp/reel_picture_asset.h>
+#include <dcp/reel_sound_asset.h>
 #include <boost/test/unit_test.hpp>
+#include <cstring>
 #include <memory>
 
 
@@ -46,7 +53,7 @@ BOOST_AUTO_TEST_CASE (test_write_odd_amount_of_silence)
 	auto content = content_factory("test/data/flat_red.png");
 	auto film = new_test_film("test_write_odd_amount_of_silence", content);
 	content[0]->video->set_length(24);
-	auto writer = make_shared<Writer>(film, shared_ptr<Job>(), "foo");
+	auto writer = make_shared<Writer>(film, shared_ptr<Job>(), film->dir(film->dcp_name()));
 
 	auto audio = make_shared<AudioBuffers>(6, 48000);
 	audio->make_silent ();
@@ -153,3 +160,203 @@ BOOST_AUTO_TEST_CASE(writer_progress_test)
 	encoder.go();
 }
 
+
+static shared_ptr<dcp::ArrayData>
+black_j2k_frame()
+{
+	auto image = make_shared<dcp::OpenJPEGImage>(dcp::Size(1998, 1080));
+	for (int i = 0; i < 3; ++i) {
+		memset(image->data(i), 0, 1998 * 1080 * sizeof(int));
+	}
+	auto video = dcp::compress_j2k(image, 100000000, 24, false, false);
+	return make_shared<dcp::ArrayData>(video.data(), video.size());
+}
+
+
+/** Give the writer frames out of order, with too few allowed in memory to hold
+ *  them all, and check that they all end up in the DCP.
+ */
+BOOST_AUTO_TEST_CASE(writer_out_of_order_test)
+{
+	auto content = content_factory("test/data/flat_red.png")[0];
+	auto film = new_test_film("writer_out_of_order_test", { content });
+	auto constexpr frames = 24 * 4;
+	content->video->set_length(frames);
+
+	auto video_ptr = black_j2k_frame();
+
+	auto writer = make_shared<Writer>(film, shared_ptr<Job>(), film->dir(film->dcp_name()));
+	writer->set_encoder_threads(1);
+	writer->start();
+
+	/* Write blocks of 16 frames backwards */
+	for (int block = 0; block < frames; block += 16) {
+		for (int i = block + 15; i >= block; --i) {
+			writer->write(video_ptr, i, Eyes::BOTH);
+		}
+	}
+
+	auto audio = make_shared<AudioBuffers>(6, 48000 / 24);
+	audio->make_silent();
+	for (int i = 0; i < frames; ++i) {
+		writer->write(audio, dcpomatic::DCPTime::from_frames(i, 24));
+	}
+
+	writer->finish();
+
+	dcp::DCP dcp(film->dir(film->dcp_name()));
+	dcp.read();
+	BOOST_REQUIRE_EQUAL(dcp.cpls().size(), 1U);
+	BOOST_REQUIRE_EQUAL(dcp.cpls()[0]->reels().size(), 1U);
+	BOOST_CHECK_EQUAL(dcp.cpls()[0]->reels()[0]->main_picture()->intrinsic_duration(), frames);
+}
+
+
+/** Give the writer all the frames for the second reel before any for the first */
+BOOST_AUTO_TEST_CASE(writer_reels_out_of_order_test)
+{
+	auto picture1 = content_factory("test/data/flat_red.png")[0];
+	auto picture2 = content_factory("test/data/flat_red.png")[0];
+
+	auto film = new_test_film("writer_reels_out_of_order_test", { picture1, picture2 });
+	film->set_reel_type(ReelType::BY_VIDEO_CONTENT);
+	picture1->video->set_length(48);
+	picture2->video->set_length(48);
+	picture2->set_position(film, dcpomatic::DCPTime::from_seconds(2));
+
+	auto video_ptr = black_j2k_frame();
+
+	auto writer = make_shared<Writer>(film, shared_ptr<Job>(), film->dir(film->dcp_name()));
+	writer->start();
+
+	for (int i = 48; i < 96; ++i) {
+		writer->write(video_ptr, i, Eyes::BOTH);
+	}
+	for (int i = 0; i < 48; ++i) {
+		writer->write(video_ptr, i, Eyes::BOTH);
+	}
+
+	auto audio = make_shared<AudioBuffers>(6, 48000 / 24);
+	audio->make_silent();
+	for (int i = 0; i < 96; ++i) {
+		writer->write(audio, dcpomatic::DCPTime::from_frames(i, 24));
+	}
+
+	writer->finish();
+
+	dcp::DCP dcp(film->dir(film->dcp_name()));
+	dcp.read();
+	BOOST_REQUIRE_EQUAL(dcp.cpls().size(), 1U);
+	auto reels = dcp.cpls()[0]->reels();
+	BOOST_REQUIRE_EQUAL(reels.size(), 2U);
+	BOOST_CHECK_EQUAL(reels[0]->main_picture()->intrinsic_duration(), 48);
+	BOOST_CHECK_EQUAL(reels[1]->main_picture()->intrinsic_duration(), 48);
+}
+
+
+/** Check that the first reel's picture asset is finished, and can be read, before
+ *  the last frame of the second reel has been given to the writer.
+ */
+BOOST_AUTO_TEST_CASE(writer_finishes_reels_early_test)
+{
+	auto picture1 = content_factory("test/data/flat_red.png")[0];
+	auto picture2 = content_factory("test/data/flat_red.png")[0];
+
+	auto film = new_test_film("writer_finishes_reels_early_test", { picture1, picture2 });
+	film->set_reel_type(ReelType::BY_VIDEO_CONTENT);
+	picture1->video->set_length(48);
+	picture2->video->set_length(48);
+	picture2->set_position(film, dcpomatic::DCPTime::from_seconds(2));
+
+	auto video_ptr = black_j2k_frame();
+
+	auto const output = film->dir(film->dcp_name());
+	auto writer = make_shared<Writer>(film, shared_ptr<Job>(), output);
+	writer->start();
+
+	for (int i = 0; i < 95; ++i) {
+		writer->write(video_ptr, i, Eyes::BOTH);
+	}
+
+	/* @return number of complete 48-frame picture assets in the DCP directory */
+	auto complete_assets = [output]() {
+		int complete = 0;
+		for (auto const& i: boost::filesystem::directory_iterator(output)) {
+			if (i.path().extension() != ".mxf") {
+				continue;
+			}
+			try {
+				dcp::MonoJ2KPictureAsset asset(i.path());
+				if (asset.intrinsic_duration() == 48) {
+					++complete;
+				}
+			} catch (...) {
+				/* Not finished yet */
+			}
+		}
+		return complete;
+	};
+
+	/* The writer thread will finish the first reel in its own time */
+	for (int i = 0; i < 100 && complete_assets() == 0; ++i) {
+		dcpomatic_sleep_milliseconds(100);
+	}
+
+	BOOST_CHECK_EQUAL(complete_assets(), 1);
+
+	writer->write(video_ptr, 95, Eyes::BOTH);
+
+	auto audio = make_shared<AudioBuffers>(6, 48000 / 24);
+	audio->make_silent();
+	for (int i = 0; i < 96; ++i) {
+		writer->write(audio, dcpomatic::DCPTime::from_frames(i, 24));
+	}
+
+	writer->finish();
+
+	BOOST_CHECK_EQUAL(complete_assets(), 2);
+}
+
+
+/** Check that the digests which the writer calculates for each reel's assets while the
+ *  DCP is still being written are the same as those of the finished files.
+ */
+BOOST_AUTO_TEST_CASE(writer_early_digests_test)
+{
+	auto picture1 = content_factory("test/data/flat_red.png")[0];
+	auto picture2 = content_factory("test/data/flat_red.png")[0];
+
+	auto film = new_test_film("writer_early_digests_test", { picture1, picture2 });
+	film->set_reel_type(ReelType::BY_VIDEO_CONTENT);
+	picture1->video->set_length(48);
+	picture2->video->set_length(48);
+	picture2->set_position(film, dcpomatic::DCPTime::from_seconds(2));
+
+	auto video_ptr = black_j2k_frame();
+
+	auto writer = make_shared<Writer>(film, shared_ptr<Job>(), film->dir(film->dcp_name()));
+	writer->start();
+
+	auto audio = make_shared<AudioBuffers>(6, 48000 / 24);
+	audio->make_silent();
+	for (int i = 0; i < 96; ++i) {
+		writer->write(video_ptr, i, Eyes::BOTH);
+		writer->write(audio, dcpomatic::DCPTime::from_frames(i, 24));
+	}
+
+	writer->finish();
+
+	dcp::DCP dcp(film->dir(film->dcp_name()));
+	dcp.read();
+	BOOST_REQUIRE_EQUAL(dcp.cpls().size(), 1U);
+	auto reels = dcp.cpls()[0]->reels();
+	BOOST_REQUIRE_EQUAL(reels.size(), 2U);
+	for (auto reel: reels) {
+		BOOST_REQUIRE(reel->main_picture());
+		BOOST_REQUIRE(reel->main_picture()->hash());
+		BOOST_CHECK_EQUAL(*reel->main_picture()->hash(), reel->main_picture()->asset()->hash());
+		BOOST_REQUIRE(reel->main_sound());
+		BOOST_REQUIRE(reel->main_sound()->hash());
+		BOOST_CHECK_EQUAL(*reel->main_sound()->hash(), reel->main_sound()->asset()->hash());
+	}
+}